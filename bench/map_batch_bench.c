@@ -0,0 +1,74 @@
+/*
+  batched vs scalar lookups: ads_map_get_batch vs ads_map_get in a loop, random hits
+
+  gcc -O2 bench/map_batch_bench.c src/map.c src/hash.c src/bloom.c src/dlist.c src/string.c src/allocator.c -o map_batch_bench
+  ./map_batch_bench [entries...]    (default: 1000000 10000000)
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "../include/map.h"
+
+#define BENCH_LOOKUPS (1 << 22) // multiple of BENCH_BATCH
+#define BENCH_BATCH   1024
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(size_t entries) {
+  ads_map_t map;
+  ads_map_init_flags(&map, entries, ADS_MAP_POW2, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64);
+
+  void** keys = malloc(BENCH_LOOKUPS * sizeof(void*));
+  void** values = malloc(BENCH_BATCH * sizeof(void*));
+
+  // insert the keys in batches as well
+  for(size_t i = 0; i < entries; i += BENCH_BATCH) {
+    size_t n = entries - i < BENCH_BATCH ? entries - i : BENCH_BATCH;
+    for(size_t j = 0; j < n; j++)
+      keys[j] = values[j] = ads_map_uint64_key(i + j);
+    ads_map_insert_batch(&map, keys, values, n);
+  }
+
+  srand(7);
+  for(size_t i = 0; i < BENCH_LOOKUPS; i++)
+    keys[i] = ads_map_uint64_key(((size_t) rand() * RAND_MAX + rand()) % entries);
+
+  size_t found = 0;
+  double start = now();
+  for(size_t i = 0; i < BENCH_LOOKUPS; i++)
+    found += ads_map_get(&map, keys[i], NULL) != NULL;
+  double scalar = now() - start;
+
+  start = now();
+  for(size_t i = 0; i < BENCH_LOOKUPS; i += BENCH_BATCH)
+    found += ads_map_get_batch(&map, &keys[i], BENCH_BATCH, NULL, values);
+  double batch = now() - start;
+
+  printf("%12zu | %10.1f %10.1f | %6.2fx %s\n", entries,
+         scalar * 1e9 / BENCH_LOOKUPS, batch * 1e9 / BENCH_LOOKUPS, scalar / batch,
+         found == 2 * BENCH_LOOKUPS ? "" : "(missing keys!)");
+
+  free(keys);
+  free(values);
+  ads_map_destroy(&map);
+}
+
+int main(int argc, char** argv) {
+  printf("%12s | %10s %10s | %7s\n", "entries", "scalar ns", "batch ns", "speedup");
+
+  if(argc > 1) {
+    for(int i = 1; i < argc; i++)
+      bench(strtoull(argv[i], NULL, 10));
+  }
+  else {
+    bench(1000000);
+    bench(10000000);
+  }
+
+  return 0;
+}
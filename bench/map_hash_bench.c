@@ -0,0 +1,105 @@
+/*
+  string hash benchmark: djb2 vs ads_hash_bytes (ADS_MAP_HASH_STRING / ADS_MAP_HASH_ADS_STRING)
+
+  gcc -O2 bench/map_hash_bench.c src/map.c src/hash.c src/bloom.c src/dlist.c src/string.c src/allocator.c -o map_hash_bench
+  ./map_hash_bench
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "../include/map.h"
+#include "../include/string.h"
+
+#define BENCH_ROUNDS 5
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// random printable keys of the same length
+static ads_string_t* make_keys(size_t count, size_t length) {
+  ads_string_t* keys = calloc(count, sizeof(ads_string_t));
+  char* buf = malloc(length + 1);
+
+  for(size_t i = 0; i < count; i++) {
+    for(size_t j = 0; j < length; j++)
+      buf[j] = 'a' + rand() % 26;
+    buf[length] = '\0';
+    ads_string_init(&keys[i], buf);
+  }
+
+  free(buf);
+  return keys;
+}
+
+// nanoseconds per key, best of BENCH_ROUNDS
+static double bench_hash(ads_string_t* keys, size_t count, int ads_string_keys, size_t (*hash)(void*)) {
+  double best = 1e30;
+  volatile size_t sink = 0;
+
+  for(int r = 0; r < BENCH_ROUNDS; r++) {
+    double start = now();
+    for(size_t i = 0; i < count; i++)
+      sink += hash(ads_string_keys ? (void*) &keys[i] : (void*) keys[i].buf);
+    double elapsed = now() - start;
+    if(elapsed < best)
+      best = elapsed;
+  }
+
+  (void) sink;
+  return best * 1e9 / count;
+}
+
+// longest chain when indexing with hash % buckets, buckets being a power of two
+static size_t bench_max_chain(ads_string_t* keys, size_t count, size_t (*hash)(void*)) {
+  size_t buckets = 1;
+  while(buckets < count)
+    buckets <<= 1;
+
+  size_t* chains = calloc(buckets, sizeof(size_t));
+  size_t max_chain = 0;
+  for(size_t i = 0; i < count; i++) {
+    size_t len = ++chains[hash(keys[i].buf) % buckets];
+    if(len > max_chain)
+      max_chain = len;
+  }
+
+  free(chains);
+  return max_chain;
+}
+
+int main() {
+  size_t lengths[] = {4, 8, 16, 32, 64, 256, 1024};
+  size_t counts[]  = {1000, 100000, 1000000};
+
+  srand(42);
+  printf("%8s %8s | %10s %10s %12s | %10s %10s\n",
+         "keys", "length", "djb2 ns", "wyhash ns", "ads_string", "djb2 chain", "wy chain");
+
+  for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    for(size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+      size_t count = counts[c], length = lengths[l];
+      if(count * length > (size_t) 256 << 20)
+        continue; // keep the key set under 256MB
+
+      ads_string_t* keys = make_keys(count, length);
+
+      printf("%8zu %8zu | %10.2f %10.2f %12.2f | %10zu %10zu\n", count, length,
+             bench_hash(keys, count, 0, ADS_MAP_HASH_STRING_DJB2),
+             bench_hash(keys, count, 0, ADS_MAP_HASH_STRING),
+             bench_hash(keys, count, 1, ADS_MAP_HASH_ADS_STRING),
+             bench_max_chain(keys, count, ADS_MAP_HASH_STRING_DJB2),
+             bench_max_chain(keys, count, ADS_MAP_HASH_STRING));
+
+      for(size_t i = 0; i < count; i++)
+        ads_string_destroy(&keys[i]);
+      free(keys);
+    }
+  }
+
+  return 0;
+}
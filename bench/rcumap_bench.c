@@ -0,0 +1,116 @@
+/*
+  read scalability benchmark: ads_rcumap_t vs ads_cmap_t (lock striping) on a read-mostly map
+
+  gcc -O2 bench/rcumap_bench.c src/rcumap.c src/cmap.c src/map.c src/hash.c src/bloom.c src/dlist.c src/string.c src/allocator.c -pthread -o rcumap_bench
+  ./rcumap_bench [max_threads]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../include/rcumap.h"
+#include "../include/cmap.h"
+
+#define BENCH_KEYS    100000
+#define BENCH_SECONDS 1.0
+
+static ads_rcumap_t rcumap;
+static ads_cmap_t cmap;
+static atomic_int stop;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* rcumap_reader(void* arg) {
+  size_t* lookups = arg;
+  ads_rcumap_reader_t* reader = ads_rcumap_reader_register(&rcumap);
+  size_t key = (size_t) lookups * 2654435761u, count = 0;
+  void* value = NULL;
+
+  while(!atomic_load_explicit(&stop, memory_order_relaxed)) {
+    for(int i = 0; i < 1024; i++) {
+      key = key * 6364136223846793005 + 1442695040888963407;
+      ads_rcumap_read_lock(reader);
+      ads_rcumap_get(&rcumap, ads_map_uint64_key((key >> 33) % BENCH_KEYS), &value);
+      ads_rcumap_read_unlock(reader);
+    }
+    count += 1024;
+  }
+
+  ads_rcumap_reader_unregister(reader);
+  *lookups = count;
+  return NULL;
+}
+
+static void* cmap_reader(void* arg) {
+  size_t* lookups = arg;
+  size_t key = (size_t) lookups * 2654435761u, count = 0;
+  void* value = NULL;
+
+  while(!atomic_load_explicit(&stop, memory_order_relaxed)) {
+    for(int i = 0; i < 1024; i++) {
+      key = key * 6364136223846793005 + 1442695040888963407;
+      ads_cmap_get(&cmap, ads_map_uint64_key((key >> 33) % BENCH_KEYS), &value);
+    }
+    count += 1024;
+  }
+
+  *lookups = count;
+  return NULL;
+}
+
+// readers run for BENCH_SECONDS while the main thread updates a key every millisecond
+static double run(int threads, void* (*reader)(void*), int use_rcu) {
+  pthread_t tids[threads];
+  size_t lookups[threads];
+
+  atomic_store(&stop, 0);
+  for(int i = 0; i < threads; i++)
+    pthread_create(&tids[i], NULL, reader, &lookups[i]);
+
+  struct timespec ms = {0, 1000000};
+  double start = now();
+  for(size_t k = 0; now() - start < BENCH_SECONDS; k++) {
+    void* key = ads_map_uint64_key(k % BENCH_KEYS);
+    if(use_rcu)
+      ads_rcumap_insert(&rcumap, key, key);
+    else
+      ads_cmap_insert(&cmap, key, key);
+    nanosleep(&ms, NULL);
+  }
+  atomic_store(&stop, 1);
+
+  size_t total = 0;
+  for(int i = 0; i < threads; i++) {
+    pthread_join(tids[i], NULL);
+    total += lookups[i];
+  }
+
+  return total / (now() - start) / 1e6;
+}
+
+int main(int argc, char** argv) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : 16;
+
+  ads_rcumap_init(&rcumap, BENCH_KEYS, max_threads, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64);
+  ads_cmap_init(&cmap, 64, BENCH_KEYS, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64);
+
+  for(size_t k = 0; k < BENCH_KEYS; k++) {
+    ads_rcumap_insert(&rcumap, ads_map_uint64_key(k), ads_map_uint64_key(k));
+    ads_cmap_insert(&cmap, ads_map_uint64_key(k), ads_map_uint64_key(k));
+  }
+
+  printf("%8s | %14s %14s\n", "threads", "rcumap Mops/s", "cmap Mops/s");
+  for(int threads = 1; threads <= max_threads; threads *= 2)
+    printf("%8d | %14.1f %14.1f\n", threads, run(threads, rcumap_reader, 1), run(threads, cmap_reader, 0));
+
+  ads_rcumap_destroy(&rcumap);
+  ads_cmap_destroy(&cmap);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+  uint64 -> uint64 map benchmark: ads_map_t vs a map generated by ADS_MAP_DEFINE (see tmap.h)
+
+  gcc -O2 bench/tmap_bench.c src/map.c src/hash.c src/bloom.c src/dlist.c src/string.c src/allocator.c -o tmap_bench
+  ./tmap_bench
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "../include/map.h"
+#include "../include/tmap.h"
+
+#define BENCH_KEYS   (1 << 20)
+#define BENCH_ROUNDS 5
+
+ADS_MAP_DEFINE(bench_tmap, uint64_t, uint64_t, ADS_TMAP_HASH_UINT64, ADS_TMAP_EQ)
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// random keys, half of them looked up while absent
+static uint64_t* make_keys(size_t count) {
+  uint64_t* keys = malloc(count * sizeof(uint64_t));
+  for(size_t i = 0; i < count; i++)
+    keys[i] = ((uint64_t) rand() << 31) ^ (uint64_t) rand();
+  return keys;
+}
+
+int main(void) {
+  uint64_t* keys = make_keys(2 * BENCH_KEYS);
+  double best_map = 1e30, best_tmap = 1e30;
+  volatile uint64_t sink = 0;
+
+  ads_map_t map;
+  ads_map_init(&map, BENCH_KEYS, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64);
+  bench_tmap_t tmap;
+  bench_tmap_init(&tmap, BENCH_KEYS);
+
+  for(size_t i = 0; i < BENCH_KEYS; i++) {
+    ads_map_insert(&map, ads_map_uint64_key(keys[i]), ads_map_uint64_key(i));
+    bench_tmap_insert(&tmap, keys[i], i);
+  }
+
+  for(int r = 0; r < BENCH_ROUNDS; r++) {
+    double start = now();
+    for(size_t i = 0; i < 2 * BENCH_KEYS; i++) {
+      void* value;
+      if(ads_map_get(&map, ads_map_uint64_key(keys[i]), &value))
+        sink += (uint64_t) value;
+    }
+    double elapsed = now() - start;
+    if(elapsed < best_map)
+      best_map = elapsed;
+
+    start = now();
+    for(size_t i = 0; i < 2 * BENCH_KEYS; i++) {
+      uint64_t* value = bench_tmap_get(&tmap, keys[i]);
+      if(value)
+        sink += *value;
+    }
+    elapsed = now() - start;
+    if(elapsed < best_tmap)
+      best_tmap = elapsed;
+  }
+
+  printf("%d keys, 50%% hits\n", BENCH_KEYS);
+  printf("ads_map_t : %6.1f ns/get\n", best_map * 1e9 / (2 * BENCH_KEYS));
+  printf("tmap      : %6.1f ns/get\n", best_tmap * 1e9 / (2 * BENCH_KEYS));
+
+  (void) sink;
+  ads_map_destroy(&map);
+  bench_tmap_destroy(&tmap);
+  free(keys);
+  return 0;
+}
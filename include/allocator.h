@@ -0,0 +1,100 @@
+#ifndef ADS_ALLOCATOR_H
+#define ADS_ALLOCATOR_H
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  memory allocator used by the containers
+
+  list, dlist, vector, deque, string, map (with its Bloom filter), flatmap, imap, btree, lru,
+  clru, cmap, rcumap and phmap get every block of memory they keep from an ads_allocator_t
+  chosen at init (see their *_init_allocator functions, and ads_phmap_build_allocator). The
+  plain init functions use the process-wide default, which is ads_allocator_std
+  (malloc/realloc/free) unless replaced with ads_allocator_set_default. A container keeps a
+  pointer to its allocator, so the allocator must outlive it.
+
+  Left out, on malloc:
+    - scratch buffers freed before the call returns (ads_btree_bulk_load, the builds of
+      ads_phmap_t, ads_mapfile_write), which would only fill an arena with dead memory
+    - ads_mapfile_t, whose only memory is the mapping of its file
+    - the types generated by tmap.h and tvector.h, kept down to their buffer and sizes so
+      that they stay plain arrays; they have no allocator to store
+    - ads_arena_t, which is itself an allocator
+
+  Every call gets `ctx` back, and realloc and free also get the size the block was asked with,
+  so pools and arenas don't need headers of their own:
+
+    alloc:   `size` bytes aligned to `alignment` (0 for the default of malloc), NULL on failure
+    realloc: may be NULL, then the containers use alloc, copy and free
+    free:    may be NULL, then blocks are only released with the whole allocator (e.g. arenas)
+*/
+
+typedef struct ads_allocator {
+  void* (*alloc)(void* ctx, size_t size, size_t alignment);
+  void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t new_size);
+  void  (*free)(void* ctx, void* ptr, size_t size);
+  void* ctx;
+} ads_allocator_t;
+
+extern const ads_allocator_t ads_allocator_std;
+
+/* the allocator of the containers initialized without one. Meant to be set once at startup:
+   containers keep the allocator they were initialized with. NULL restores ads_allocator_std */
+void ads_allocator_set_default(const ads_allocator_t* allocator);
+const ads_allocator_t* ads_allocator_get_default(void);
+
+/* ----- HELPERS FOR THE CONTAINERS ----- */
+
+// a NULL allocator, e.g. of a zeroed container that was never initialized, is the std one
+#define ads_allocator_or_std(allocator) ((allocator) ? (allocator) : &ads_allocator_std)
+
+/* 0 for allocators that only release memory as a whole (e.g. arenas, see arena.h): their
+   containers skip walking the nodes on destroy when there's nothing else to release */
+#define ads_allocator_frees(allocator) (ads_allocator_or_std((allocator))->free != NULL)
+
+static inline void*
+ads_alloc(const ads_allocator_t* allocator, size_t size) {
+  allocator = ads_allocator_or_std(allocator);
+  return allocator->alloc(allocator->ctx, size, 0);
+}
+
+static inline void*
+ads_alloc_aligned(const ads_allocator_t* allocator, size_t size, size_t alignment) {
+  allocator = ads_allocator_or_std(allocator);
+  return allocator->alloc(allocator->ctx, size, alignment);
+}
+
+static inline void*
+ads_calloc(const ads_allocator_t* allocator, size_t count, size_t size) {
+  if(size && count > (size_t) -1 / size)
+    return NULL;
+
+  void* ptr = ads_alloc(allocator, count * size);
+  if(ptr)
+    memset(ptr, 0, count * size);
+  return ptr;
+}
+
+static inline void
+ads_free(const ads_allocator_t* allocator, void* ptr, size_t size) {
+  allocator = ads_allocator_or_std(allocator);
+  if(ptr && allocator->free)
+    allocator->free(allocator->ctx, ptr, size);
+}
+
+static inline void*
+ads_realloc(const ads_allocator_t* allocator, void* ptr, size_t old_size, size_t new_size) {
+  allocator = ads_allocator_or_std(allocator);
+  if(allocator->realloc)
+    return allocator->realloc(allocator->ctx, ptr, old_size, new_size);
+
+  void* new_ptr = allocator->alloc(allocator->ctx, new_size, 0);
+  if(new_ptr && ptr) {
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    ads_free(allocator, ptr, old_size);
+  }
+  return new_ptr;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef ADS_ARENA_H
+#define ADS_ARENA_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  region (bump) allocator
+
+  Memory is carved from chunks by bumping an offset, and it's only released all at once: by
+  ads_arena_reset, back to a mark or to empty, and by ads_arena_destroy. Chunks start at the
+  size given to ads_arena_init and double up to ADS_ARENA_MAX_CHUNK_SIZE; larger requests get
+  a chunk of their own.
+
+  ads_arena_get_allocator gives an ads_allocator_t (see allocator.h) without free, so
+  containers initialized with it don't free their nodes one by one: ads_list_destroy,
+  ads_dlist_destroy and ads_map_destroy without a destroy function just drop them. The
+  containers must not be used after the arena is reset below the point where they were
+  created.
+
+  An arena isn't thread-safe and can't be moved after ads_arena_init. ads_arena_thread gives
+  each thread an arena of its own, released when the thread exits.
+
+  Usage, per request:
+
+    ads_arena_mark_t mark;
+    ads_arena_mark(arena, &mark);
+
+    ads_map_init_allocator(&map, 16, 0, ads_arena_get_allocator(arena), NULL, compare, hash);
+    ...
+    ads_map_destroy(&map);         // O(1), no entry is visited
+    ads_arena_reset(arena, &mark); // O(chunks)
+*/
+
+#define ADS_ARENA_CHUNK_SIZE     (16 << 10) // default size of the first chunk
+#define ADS_ARENA_MAX_CHUNK_SIZE (4 << 20)  // chunks double in size up to this one
+#define ADS_ARENA_ALIGNMENT      _Alignof(max_align_t) // of every allocation, like malloc
+
+typedef struct ads_arena_chunk {
+  struct ads_arena_chunk* prev; // older chunk
+  size_t size; // bytes of data
+  size_t used;
+  unsigned char data[];
+} ads_arena_chunk_t;
+
+typedef struct ads_arena {
+  ads_arena_chunk_t* chunk; // newest chunk, the one allocations are bumped from
+  size_t next_size;         // data size of the next chunk
+  size_t chunk_size;        // of the first chunk, next_size starts over from it after destroy
+  void* last;               // last allocation, the only one ads_arena_realloc grows in place
+
+  ads_allocator_t allocator; // ctx is the arena itself
+} ads_arena_t;
+
+// position of an arena, taken by ads_arena_mark
+typedef struct ads_arena_mark {
+  ads_arena_chunk_t* chunk;
+  size_t used;
+} ads_arena_mark_t;
+
+#define ads_arena_get_allocator(arena) ((const ads_allocator_t*) &(arena)->allocator)
+
+// chunks of `chunk_size` bytes to start with, 0 for ADS_ARENA_CHUNK_SIZE. Nothing is allocated yet
+void ads_arena_init(ads_arena_t* arena, size_t chunk_size);
+
+// release every chunk; the arena can be used again, as right after ads_arena_init
+void ads_arena_destroy(ads_arena_t* arena);
+
+// `alignment` is a power of two, 0 for ADS_ARENA_ALIGNMENT. NULL when out of memory
+void* ads_arena_alloc(ads_arena_t* arena, size_t size, size_t alignment);
+
+// grows or shrinks in place when `ptr` is the last allocation, otherwise copies it
+void* ads_arena_realloc(ads_arena_t* arena, void* ptr, size_t old_size, size_t new_size);
+
+/* ads_arena_reset releases everything allocated after ads_arena_mark, marks being reset in
+   the reverse order they were taken. A NULL mark releases everything but keeps the first
+   chunk, so an arena reused per request doesn't go back to malloc */
+void ads_arena_mark(const ads_arena_t* arena, ads_arena_mark_t* mark);
+void ads_arena_reset(ads_arena_t* arena, const ads_arena_mark_t* mark);
+
+// total bytes of the chunks
+size_t ads_arena_get_capacity(const ads_arena_t* arena);
+
+// arena of the calling thread, created on first use; NULL when out of memory
+ads_arena_t* ads_arena_thread(void);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef ADS_BLOOM_H
+#define ADS_BLOOM_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  blocked Bloom filter: a set of hashes that answers "maybe present" or "definitely absent"
+
+  The bits are split in blocks of one cache line. A hash selects a single block and sets one
+  bit in each of its 64-bit words, so adding or testing a hash touches exactly one cache line.
+  With ADS_BLOOM_BITS_PER_KEY bits per expected key the false positive rate stays below 1%.
+
+  Hashes can't be removed: to forget entries, clear the filter and add the remaining hashes
+  again.
+*/
+
+#define ADS_BLOOM_BLOCK_SIZE   64 // bytes of a block, a cache line
+#define ADS_BLOOM_BLOCK_WORDS  (ADS_BLOOM_BLOCK_SIZE / sizeof(uint64_t))
+#define ADS_BLOOM_BITS_PER_KEY 12
+
+typedef struct ads_bloom {
+  uint64_t* blocks; // n_blocks * ADS_BLOOM_BLOCK_WORDS words, aligned to a cache line
+  size_t n_blocks;
+  size_t count;     // hashes added since the last clear, duplicates included
+  const ads_allocator_t* allocator; // of the blocks
+} ads_bloom_t;
+
+#define ads_bloom_get_count(bloom)  ((bloom)->count)
+#define ads_bloom_get_blocks(bloom) ((bloom)->n_blocks)
+
+// sized for `capacity` keys, more can be added at the cost of a higher false positive rate
+ads_status_t ads_bloom_init(ads_bloom_t* bloom, size_t capacity);
+
+// NULL uses the default allocator (see allocator.h)
+ads_status_t ads_bloom_init_allocator(ads_bloom_t* bloom, size_t capacity, const ads_allocator_t* allocator);
+void ads_bloom_destroy(ads_bloom_t* bloom);
+void ads_bloom_clear(ads_bloom_t* bloom);
+
+// `hash` should be a full-width hash of the key, e.g. from ads_hash_bytes (see hash.h)
+void ads_bloom_add(ads_bloom_t* bloom, size_t hash);
+
+// 0 if `hash` was never added, 1 if it probably was
+int ads_bloom_may_contain(const ads_bloom_t* bloom, size_t hash);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef ADS_BTREE_H
+#define ADS_BTREE_H
+
+#include <stdlib.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  implementation of an ordered map based on a B+-tree
+
+  Every node starts with an array of ADS_BTREE_NODE_KEYS keys that fills a pair of cache
+  lines, so a search reads two lines per level. Values are only stored in the leaves, which
+  are linked in key order for range scans.
+
+  Unlike ads_map_t (see map.h), compare returns a three-way ordering: < 0, 0 or > 0 when
+  key1 is before, equal to or after key2.
+*/
+
+#define ADS_BTREE_NODE_KEYS 15 // 15 keys + count fit in 128 bytes
+#define ADS_BTREE_MIN_KEYS  (ADS_BTREE_NODE_KEYS / 2) // of every node but the root
+#define ADS_BTREE_NODE_ALIGN 64
+
+typedef struct ads_btree_node {
+  void* keys[ADS_BTREE_NODE_KEYS];
+  unsigned short count;
+  unsigned short leaf;
+} ads_btree_node_t;
+
+typedef struct ads_btree_leaf {
+  ads_btree_node_t node;
+  void* values[ADS_BTREE_NODE_KEYS];
+  struct ads_btree_leaf* next;
+  struct ads_btree_leaf* prev;
+} ads_btree_leaf_t;
+
+// children[i] holds the keys in [keys[i - 1], keys[i])
+typedef struct ads_btree_inner {
+  ads_btree_node_t node;
+  ads_btree_node_t* children[ADS_BTREE_NODE_KEYS + 1];
+} ads_btree_inner_t;
+
+typedef struct ads_btree {
+  ads_btree_node_t* root; // a leaf, possibly empty, until the first split
+  size_t size;
+  const ads_allocator_t* allocator; // of the nodes
+
+  void (*destroy)(void* value);       // destroy the value store into the tree
+  int  (*compare)(void* key1, void* key2); // three-way comparison of two keys
+} ads_btree_t;
+
+// position of an entry, or the end of the tree when leaf is NULL
+typedef struct ads_btree_cursor {
+  ads_btree_leaf_t* leaf;
+  size_t index;
+} ads_btree_cursor_t;
+
+// the entries in [begin, end), iterated with ADS_ITERATOR_BTREE (see iterator.h)
+typedef struct ads_btree_range {
+  ads_btree_cursor_t cursor; // current entry while iterating
+  ads_btree_cursor_t begin;
+  ads_btree_cursor_t end;
+} ads_btree_range_t;
+
+#define ads_btree_get_size(tree) ((tree)->size)
+#define ads_btree_is_empty(tree) (ads_btree_get_size((tree)) == 0)
+
+#define ads_btree_cursor_is_end(cursor)    ((cursor)->leaf == NULL)
+#define ads_btree_cursor_get_key(cursor)   ((cursor)->leaf->node.keys[(cursor)->index])
+#define ads_btree_cursor_get_value(cursor) ((cursor)->leaf->values[(cursor)->index])
+
+int ADS_BTREE_COMPARE_STRING(void* key_string1, void* key_string2);
+int ADS_BTREE_COMPARE_UINT64(void* key_uint64a, void* key_uint64b);
+
+ads_status_t
+ads_btree_init(ads_btree_t* tree,
+               void (*destroy)(void* value),
+               int  (*compare)(void* key1, void* key2));
+
+// NULL uses the default allocator (see allocator.h), which must honor ADS_BTREE_NODE_ALIGN
+ads_status_t
+ads_btree_init_allocator(ads_btree_t* tree,
+                         const ads_allocator_t* allocator,
+                         void (*destroy)(void* value),
+                         int  (*compare)(void* key1, void* key2));
+
+void ads_btree_destroy(ads_btree_t* tree);
+
+ads_status_t ads_btree_insert(ads_btree_t* tree, void* key, void* value);
+ads_status_t ads_btree_remove(ads_btree_t* tree, void* key, void** out);
+ads_status_t ads_btree_get(const ads_btree_t* tree, void* key, void** out);
+
+/* fill an empty tree from `count` keys sorted in strictly increasing order, packing the
+   nodes instead of splitting them. ADS_INVALID if the tree isn't empty or the keys aren't
+   sorted; on failure the tree is left empty */
+ads_status_t ads_btree_bulk_load(ads_btree_t* tree, void** keys, void** values, size_t count);
+
+// first entry, first entry with a key >= `key` and first entry with a key > `key`
+void ads_btree_first(const ads_btree_t* tree, ads_btree_cursor_t* cursor);
+void ads_btree_lower_bound(const ads_btree_t* tree, void* key, ads_btree_cursor_t* cursor);
+void ads_btree_upper_bound(const ads_btree_t* tree, void* key, ads_btree_cursor_t* cursor);
+void ads_btree_cursor_next(ads_btree_cursor_t* cursor);
+
+/* the entries with from <= key < to. A NULL `from` starts at the first entry and a NULL `to`
+   runs to the end. The tree can't be modified while the range is in use */
+void ads_btree_range(const ads_btree_t* tree, void* from, void* to, ads_btree_range_t* range);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef ADS_CMAP_H
+#define ADS_CMAP_H
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "error.h"
+#include "map.h"
+
+/*
+  thread-safe map built on ads_map_t (see map.h)
+
+  The keys are partitioned into stripes by hash, each stripe being an ads_map_t with its own
+  reader/writer lock, so threads working on different stripes never wait on each other and
+  readers of the same stripe run in parallel.
+
+  Values are returned by copy (out parameters), never as ads_map_entry_t*, because an entry
+  may be removed by another thread as soon as the stripe is unlocked.
+*/
+
+#define ADS_CMAP_CACHE_LINE 64
+
+typedef struct ads_cmap_stripe {
+  _Alignas(ADS_CMAP_CACHE_LINE) pthread_rwlock_t lock; // stripes don't share cache lines
+  ads_map_t map;
+} ads_cmap_stripe_t;
+
+typedef struct ads_cmap {
+  ads_cmap_stripe_t* stripes;
+  size_t n_stripes; // always a power of two
+  const ads_allocator_t* allocator; // of the stripes and of every stripe's map
+} ads_cmap_t;
+
+// called with the stripe locked; returns the value to be inserted or NULL to insert nothing
+typedef void* (*ads_cmap_compute_f)(void* key, void* arg);
+
+#define ads_cmap_get_stripes(map) ((map)->n_stripes)
+
+ads_status_t
+ads_cmap_init(ads_cmap_t* map,
+              size_t stripes,
+              size_t buckets,
+              void   (*destroy)(void* value),
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key));
+
+/* NULL uses the default allocator (see allocator.h). The stripes call it concurrently, each
+   one under its own lock, so it must be thread-safe */
+ads_status_t
+ads_cmap_init_allocator(ads_cmap_t* map,
+                        size_t stripes,
+                        size_t buckets,
+                        const ads_allocator_t* allocator,
+                        void   (*destroy)(void* value),
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key));
+
+void ads_cmap_destroy(ads_cmap_t* map);
+
+size_t ads_cmap_get_size(ads_cmap_t* map);
+
+ads_status_t ads_cmap_insert(ads_cmap_t* map, void* key, void* value);
+ads_status_t ads_cmap_remove(ads_cmap_t* map, void* key, void** out);
+ads_status_t ads_cmap_get(ads_cmap_t* map, void* key, void** out);
+
+/* atomic check-then-insert: if `key` is already in the map, `out` receives the current value
+   and `value` is left untouched (still owned by the caller); otherwise `value` is inserted
+   and `out` receives it */
+ads_status_t ads_cmap_get_or_insert(ads_cmap_t* map, void* key, void* value, void** out);
+
+/* same as ads_cmap_get_or_insert, but the value is only built (by `compute`) when the key
+   is absent. Returns ADS_NOTFOUND if `compute` returned NULL */
+ads_status_t
+ads_cmap_compute_if_absent(ads_cmap_t*        map,
+                           void*              key,
+                           ads_cmap_compute_f compute,
+                           void*              arg,
+                           void**             out);
+
+#endif
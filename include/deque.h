@@ -0,0 +1,69 @@
+#ifndef ADS_DEQUE_H
+#define ADS_DEQUE_H
+
+#include <stdlib.h>
+#include "error.h"
+#include "vector.h"
+#include "allocator.h"
+
+/*
+  double-ended queue backed by a circular buffer
+
+  Elements are stored by value, data_size bytes each, with the same copy/destroy model as
+  ads_vector_t (see vector.h). The elements wrap around the end of the buffer, so pushing and
+  popping at either end never moves the others, and element i is found with a mask.
+*/
+
+#define ADS_DEQUE_PRE_ALLOCATE 8 // always a power of two
+
+typedef struct ads_deque {
+  size_t data_size;
+  size_t size;
+  size_t capacity; // always a power of two
+  size_t head;     // slot of the first element
+  void* buf;
+  const ads_allocator_t* allocator; // of the buffer
+
+  ads_vector_copy_f    copy;
+  ads_vector_destroy_f destroy;
+} ads_deque_t;
+
+#define ads_deque_get_size(deque) ((deque)->size)
+#define ads_deque_is_empty(deque) (ads_deque_get_size((deque)) == 0)
+#define ads_deque_is_full(deque)  ((deque)->size == (deque)->capacity)
+
+// address of the `index`-th element, from the front
+#define ads_deque_get_idx_address(deque, index) \
+  ( &((char*)(deque)->buf)[(((deque)->head + (index)) & ((deque)->capacity - 1)) * (deque)->data_size] )
+
+ads_status_t
+ads_deque_init(ads_deque_t*         deque,
+               size_t               data_size,
+               ads_vector_copy_f    copy,
+               ads_vector_destroy_f destroy);
+
+// same as ads_deque_init, but the buffer comes from `allocator` (NULL for the default one, see allocator.h)
+ads_status_t
+ads_deque_init_allocator(ads_deque_t*           deque,
+                         size_t                 data_size,
+                         const ads_allocator_t* allocator,
+                         ads_vector_copy_f      copy,
+                         ads_vector_destroy_f   destroy);
+
+void ads_deque_clear(ads_deque_t* deque);
+void ads_deque_destroy(ads_deque_t* deque);
+
+// make room for at least `capacity` elements
+ads_status_t ads_deque_reserve(ads_deque_t* deque, size_t capacity);
+
+ads_status_t ads_deque_push_back(ads_deque_t* deque, void* data);
+ads_status_t ads_deque_push_front(ads_deque_t* deque, void* data);
+
+/* remove the last/first element. If `out` isn't NULL the element's bytes are copied to it
+   and destroy isn't called, the caller takes it over. ADS_NOTFOUND if the deque is empty */
+ads_status_t ads_deque_pop_back(ads_deque_t* deque, void* out);
+ads_status_t ads_deque_pop_front(ads_deque_t* deque, void* out);
+
+ads_status_t ads_deque_get_at(ads_deque_t* deque, ssize_t index, void** out);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include "error.h"
+#include "allocator.h"
 
 /*
   DOUBLE LINKED LIST HEADER
@@ -22,6 +23,7 @@ typedef struct ads_dlist {
   size_t size;
 
   void (*destroy)(void* data);
+  const ads_allocator_t* allocator; // of the nodes
 } ads_dlist_t;
 
 #define ads_dlist_get_size(dlist) ((dlist)->size)
@@ -34,6 +36,10 @@ typedef struct ads_dlist {
 #define ads_dlist_get_prev(node)  ((node)->prev)
 
 void ads_dlist_init(ads_dlist_t* dlist, void (*destroy)(void*));
+
+// NULL uses the default allocator (see allocator.h)
+void ads_dlist_init_allocator(ads_dlist_t* dlist, void (*destroy)(void*), const ads_allocator_t* allocator);
+
 void ads_dlist_destroy(ads_dlist_t* dlist);
 void ads_dlist_clean(ads_dlist_t* dlist);
 
@@ -49,4 +55,11 @@ ads_status_t ads_dlist_add_prev(ads_dlist_t* dlist, ads_dlist_node_t* node, void
 
 ads_dlist_node_t* ads_dlist_get_at(ads_dlist_t* dlist, ssize_t index);
 
+// move nodes between lists without freeing/allocating them; both must have the same allocator
+void ads_dlist_unlink(ads_dlist_t* dlist, ads_dlist_node_t* node);
+void ads_dlist_link_front(ads_dlist_t* dlist, ads_dlist_node_t* node);
+
+// make `node`, already in `dlist`, its head (e.g. most recently used entry of a cache)
+void ads_dlist_move_to_front(ads_dlist_t* dlist, ads_dlist_node_t* node);
+
 #endif
\ No newline at end of file
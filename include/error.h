@@ -5,7 +5,9 @@ typedef enum {
   ADS_SUCCESS = 0,
   ADS_NOMEM,
   ADS_OUTOFBOUNDS,
-  ADS_NOTFOUND
+  ADS_NOTFOUND,
+  ADS_INVALID,
+  ADS_IOERROR
 } ads_status_t;
 
 const char* ads_status_message(ads_status_t status);
@@ -0,0 +1,65 @@
+#ifndef ADS_FLATMAP_H
+#define ADS_FLATMAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  implementation of a map based on open addressing, in the style of Swiss tables:
+  entries are stored inline in a flat array of slots and a separate array of control bytes
+  keeps a 7-bit tag of each slot's hash. Lookups scan the control bytes 16 at a time (SSE2)
+  and only touch the slots whose tag matches.
+
+  The API is the same as ads_map_t (see map.h), including the hash/compare callbacks, so
+  ADS_MAP_HASH_STRING, ADS_MAP_COMPARE_UINT64 and friends can be used here too.
+*/
+
+#define ADS_FLATMAP_GROUP_WIDTH 16 // control bytes scanned at a time
+
+typedef struct ads_flatmap_entry {
+  void* key;
+  void* value;
+} ads_flatmap_entry_t;
+
+typedef struct ads_flatmap {
+  int8_t* ctrl;               // capacity + ADS_FLATMAP_GROUP_WIDTH control bytes
+  ads_flatmap_entry_t* slots; // capacity slots, same allocation as ctrl
+  size_t capacity;            // always a power of two
+  size_t size;
+  size_t growth_left;         // number of empty slots that can still be filled before a rehash
+  const ads_allocator_t* allocator; // of the table
+
+  void   (*destroy)(void* value); // destroy the value store into the map
+  int    (*compare)(void* key1, void* key2); // function to compare two keys
+  size_t (*hash)(void* key); // hash function
+} ads_flatmap_t;
+
+#define ads_flatmap_get_size(map)     ((map)->size)
+#define ads_flatmap_get_capacity(map) ((map)->capacity)
+#define ads_flatmap_is_empty(map)     (ads_flatmap_get_size((map)) == 0)
+
+ads_status_t
+ads_flatmap_init(ads_flatmap_t* map,
+                 size_t capacity,
+                 void   (*destroy)(void* value),
+                 int    (*compare)(void* key1, void* key2),
+                 size_t (*hash)(void* key));
+
+// NULL uses the default allocator (see allocator.h)
+ads_status_t
+ads_flatmap_init_allocator(ads_flatmap_t* map,
+                           size_t capacity,
+                           const ads_allocator_t* allocator,
+                           void   (*destroy)(void* value),
+                           int    (*compare)(void* key1, void* key2),
+                           size_t (*hash)(void* key));
+
+void ads_flatmap_destroy(ads_flatmap_t* map);
+
+ads_status_t ads_flatmap_insert(ads_flatmap_t* map, void* key, void* value);
+ads_status_t ads_flatmap_remove(ads_flatmap_t* map, void* key, void** out);
+ads_flatmap_entry_t* ads_flatmap_get(ads_flatmap_t* map, void* key, void** out);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ADS_HASH_H
+#define ADS_HASH_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+  length-aware hashing of byte strings, reads the input 8 bytes at a time
+  (wyhash by Wang Yi, https://github.com/wangyi-fudan/wyhash)
+*/
+
+size_t ads_hash_bytes(const void* data, size_t size, size_t seed);
+
+// seed used by the ADS_MAP_HASH_* string callbacks; set it before creating any map
+void ads_hash_set_seed(size_t seed);
+size_t ads_hash_get_seed(void);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef ADS_IMAP_H
+#define ADS_IMAP_H
+
+#include <stdlib.h>
+#include <stddef.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  implementation of an intrusive chained hash table
+
+  Each entry embeds its own chain link and the hash of its key, so there are no list nodes
+  in between. It can be used in two ways:
+
+  - managed: ads_imap_insert/get/remove work like ads_map_t (see map.h), but an insert does
+    a single allocation (the ads_imap_entry_t) and a remove a single free.
+
+  - intrusive: the caller embeds an ads_imap_link_t in its own struct and hands it to
+    ads_imap_link/ads_imap_unlink. The map never allocates or frees these links; use
+    ads_imap_container_of to get back to the caller's struct. The only allocation left is
+    the bucket array growing, which can be avoided by passing enough buckets to init.
+
+  A map must be used in only one of the two ways: ads_imap_init for managed maps,
+  ads_imap_init_intrusive for intrusive ones.
+*/
+
+#define ADS_IMAP_MAX_LOAD_FACTOR 1.0 // grow when size / buckets goes above it
+
+typedef struct ads_imap_link {
+  struct ads_imap_link* next;
+  size_t hash; // cached hash of key, compared before calling compare and reused on resize
+  void* key;
+} ads_imap_link_t;
+
+// entry allocated by the map in managed mode
+typedef struct ads_imap_entry {
+  ads_imap_link_t link;
+  void* value;
+} ads_imap_entry_t;
+
+typedef struct ads_imap {
+  ads_imap_link_t** htable; // each bucket is the head of a singly linked chain
+  size_t buckets;
+  size_t size;
+  int intrusive; // links are owned by the caller
+  const ads_allocator_t* allocator; // of the bucket array and the managed entries
+
+  void   (*destroy)(void* value); // destroy the value store into the map (managed mode)
+  int    (*compare)(void* key1, void* key2); // function to compare two keys
+  size_t (*hash)(void* key); // hash function
+} ads_imap_t;
+
+#define ads_imap_get_size(map)    ((map)->size)
+#define ads_imap_get_buckets(map) ((map)->buckets)
+#define ads_imap_is_empty(map)    (ads_imap_get_size((map)) == 0)
+
+#define ads_imap_container_of(link, type, member) \
+  ((type*) ((char*) (link) - offsetof(type, member)))
+
+ads_status_t
+ads_imap_init(ads_imap_t* map,
+              size_t buckets,
+              void   (*destroy)(void* value),
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key));
+
+ads_status_t
+ads_imap_init_intrusive(ads_imap_t* map,
+                        size_t buckets,
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key));
+
+// NULL uses the default allocator (see allocator.h)
+ads_status_t
+ads_imap_init_allocator(ads_imap_t* map,
+                        size_t buckets,
+                        const ads_allocator_t* allocator,
+                        void   (*destroy)(void* value),
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key));
+
+// only the bucket array comes from `allocator`, the links are the caller's
+ads_status_t
+ads_imap_init_intrusive_allocator(ads_imap_t* map,
+                                  size_t buckets,
+                                  const ads_allocator_t* allocator,
+                                  int    (*compare)(void* key1, void* key2),
+                                  size_t (*hash)(void* key));
+
+void ads_imap_destroy(ads_imap_t* map);
+
+// managed mode
+ads_status_t ads_imap_insert(ads_imap_t* map, void* key, void* value);
+ads_status_t ads_imap_remove(ads_imap_t* map, void* key, void** out);
+ads_imap_entry_t* ads_imap_get(ads_imap_t* map, void* key, void** out);
+
+// intrusive mode
+ads_imap_link_t* ads_imap_link(ads_imap_t* map, ads_imap_link_t* link, void* key);
+ads_imap_link_t* ads_imap_unlink(ads_imap_t* map, void* key);
+ads_imap_link_t* ads_imap_find(ads_imap_t* map, void* key);
+
+#endif
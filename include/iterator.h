@@ -1,12 +1,16 @@
 #ifndef ADS_ITERATOR_H
 #define ADS_ITERATOR_H
 
+#include <stdlib.h>
+
 typedef struct ads_iterator ads_iterator_t;
 typedef int (*it_function_t)(ads_iterator_t*);
 
 typedef struct ads_iterator {
   void* data_structure;
   void* curr_position;
+  void* next_position; // looked up in advance, so curr_position can be removed while iterating
+  size_t index;        // current bucket, for iterators over hash tables
   it_function_t it_func;
 } ads_iterator_t;
 
@@ -15,10 +19,18 @@ typedef struct ads_iterator {
 #define ADS_ITERATOR_DLIST  ( (it_function_t) 2) 
 #define ADS_ITERATOR_STRING ( (it_function_t) 3)
 
-#define ads_iterator_reset(it) ((it)->curr_position = NULL)
+/* yields ads_map_entry_t*. The current entry may be removed from the map while iterating;
+   inserting or removing other entries isn't supported until the iteration ends, the iterator
+   is reset or destroyed */
+#define ADS_ITERATOR_MAP    ( (it_function_t) 4)
+
+/* data_structure is an ads_btree_range_t* (see ads_btree_range in btree.h), yields a pointer
+   to its cursor, in key order */
+#define ADS_ITERATOR_BTREE  ( (it_function_t) 5)
 
 void ads_iterator_init(ads_iterator_t* it, void* data_structure, it_function_t it_func);
 int ads_iterator_iterate(ads_iterator_t* it, void** value);
+void ads_iterator_reset(ads_iterator_t* it);
 void ads_iterator_destroy(ads_iterator_t* it);
 
 #endif
\ No newline at end of file
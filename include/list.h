@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include "error.h"
+#include "allocator.h"
 
 /*
   SINGLE LINKED LIST HEADER
@@ -21,6 +22,7 @@ typedef struct ads_list {
   size_t size;
 
   void (*destroy)(void* data);
+  const ads_allocator_t* allocator; // of the nodes
 } ads_list_t;
 
 #define ads_list_get_size(list)  ((list)->size)
@@ -32,6 +34,9 @@ typedef struct ads_list {
 #define ads_list_get_next(node) ((node)->next)
 
 void ads_list_init(ads_list_t* list, void (*destroy)(void*));
+
+// NULL uses the default allocator (see allocator.h)
+void ads_list_init_allocator(ads_list_t* list, void (*destroy)(void*), const ads_allocator_t* allocator);
 #define ads_list_compact_init(list, destroy) \
   ads_list_t (list); \
   ads_list_init(&(list), (destroy))
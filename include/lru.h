@@ -0,0 +1,157 @@
+#ifndef ADS_LRU_H
+#define ADS_LRU_H
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "error.h"
+#include "map.h"
+#include "dlist.h"
+
+/*
+  bounded cache with least recently used eviction
+
+  An ads_map_t maps each key to its node in an ads_dlist_t ordered by recency, most recently
+  used first. The node and the ads_lru_item_t of an entry are a single allocation. A hit moves
+  the node to the head of the list without reallocating it, and entries are evicted from the
+  tail.
+
+  Every entry has a cost and the total cost never goes above the capacity. Pass a cost of 1
+  to bound the number of entries, or the size of the value to bound the memory used.
+
+  The cache owns the key and the value of an entry from its insertion until `evict` is called
+  for them: when the entry is evicted or removed, or when the cache is destroyed.
+  When ads_lru_insert replaces an entry, the old key and value are passed to `evict`, the key
+  being NULL if the new one is the same pointer. ads_lru_remove with `out` hands the value to
+  the caller and `evict` gets a NULL value.
+*/
+
+typedef void (*ads_lru_evict_f)(void* key, void* value);
+
+typedef struct ads_lru_item {
+  void* key;
+  void* value;
+  size_t cost;
+} ads_lru_item_t;
+
+typedef struct ads_lru_stats {
+  size_t size;
+  size_t cost;
+  size_t hits;
+  size_t misses;
+  size_t evictions; // entries dropped to make room, not counting replaces and removes
+} ads_lru_stats_t;
+
+typedef struct ads_lru {
+  ads_map_t map;     // key -> ads_dlist_node_t* of `order`
+  ads_dlist_t order; // ads_lru_item_t*, most recently used first; its allocator is the cache's
+  size_t capacity;
+  size_t cost;
+
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+
+  ads_lru_evict_f evict; // may be NULL
+} ads_lru_t;
+
+#define ads_lru_get_size(lru)     (ads_dlist_get_size(&(lru)->order))
+#define ads_lru_get_cost(lru)     ((lru)->cost)
+#define ads_lru_get_capacity(lru) ((lru)->capacity)
+#define ads_lru_is_empty(lru)     (ads_lru_get_size((lru)) == 0)
+
+ads_status_t
+ads_lru_init(ads_lru_t* lru,
+             size_t capacity,
+             ads_lru_evict_f evict,
+             int    (*compare)(void* key1, void* key2),
+             size_t (*hash)(void* key));
+
+// the map and the entries use `allocator`, NULL for the default one (see allocator.h)
+ads_status_t
+ads_lru_init_allocator(ads_lru_t* lru,
+                       size_t capacity,
+                       const ads_allocator_t* allocator,
+                       ads_lru_evict_f evict,
+                       int    (*compare)(void* key1, void* key2),
+                       size_t (*hash)(void* key));
+
+void ads_lru_destroy(ads_lru_t* lru);
+
+/* insert or replace `key`, evicting the least recently used entries until it fits.
+   ADS_OUTOFBOUNDS if `cost` alone is above the capacity (nothing is evicted) */
+ads_status_t ads_lru_insert(ads_lru_t* lru, void* key, void* value, size_t cost);
+
+// on a hit, the entry becomes the most recently used one
+ads_lru_item_t* ads_lru_get(ads_lru_t* lru, void* key, void** out);
+
+// same as ads_lru_get, but neither the recency nor the counters are updated
+ads_lru_item_t* ads_lru_peek(const ads_lru_t* lru, void* key, void** out);
+
+ads_status_t ads_lru_remove(ads_lru_t* lru, void* key, void** out);
+
+// evict least recently used entries until the cost is at most `cost`
+void ads_lru_trim(ads_lru_t* lru, size_t cost);
+
+void ads_lru_get_stats(const ads_lru_t* lru, ads_lru_stats_t* stats);
+
+/* ----- SHARDED CACHE ----- */
+
+/*
+  thread-safe cache: the keys are split by hash into shards, each one an ads_lru_t with its
+  own mutex and an equal share of the capacity (ADS_INVALID if the capacity is below the
+  number of shards, rounded up to a power of two). Recency is tracked per shard, so the evicted
+  entry is the least recently used one of its shard.
+
+  ads_clru_get copies the value out, which is only safe if `evict` doesn't free it while
+  another thread may still use it. Otherwise, use ads_clru_visit, which runs a function on
+  the value with the shard still locked.
+*/
+
+#define ADS_CLRU_CACHE_LINE 64
+
+typedef struct ads_clru_shard {
+  _Alignas(ADS_CLRU_CACHE_LINE) pthread_mutex_t lock; // shards don't share cache lines
+  ads_lru_t lru;
+} ads_clru_shard_t;
+
+typedef struct ads_clru {
+  ads_clru_shard_t* shards;
+  size_t n_shards; // always a power of two
+  const ads_allocator_t* allocator; // of the shards and of every shard's cache
+} ads_clru_t;
+
+// called with the shard locked
+typedef void (*ads_clru_visit_f)(void* key, void* value, void* arg);
+
+#define ads_clru_get_shards(lru) ((lru)->n_shards)
+
+ads_status_t
+ads_clru_init(ads_clru_t* lru,
+              size_t shards,
+              size_t capacity,
+              ads_lru_evict_f evict,
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key));
+
+/* NULL uses the default allocator (see allocator.h). The shards call it concurrently, each one
+   under its own lock, so it must be thread-safe */
+ads_status_t
+ads_clru_init_allocator(ads_clru_t* lru,
+                        size_t shards,
+                        size_t capacity,
+                        const ads_allocator_t* allocator,
+                        ads_lru_evict_f evict,
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key));
+
+void ads_clru_destroy(ads_clru_t* lru);
+
+ads_status_t ads_clru_insert(ads_clru_t* lru, void* key, void* value, size_t cost);
+ads_status_t ads_clru_get(ads_clru_t* lru, void* key, void** out);
+ads_status_t ads_clru_visit(ads_clru_t* lru, void* key, ads_clru_visit_f visit, void* arg);
+ads_status_t ads_clru_remove(ads_clru_t* lru, void* key, void** out);
+
+// sum of the stats of every shard
+void ads_clru_get_stats(ads_clru_t* lru, ads_lru_stats_t* stats);
+
+#endif
@@ -2,21 +2,81 @@
 #define ADS_MAP_H
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
 #include "error.h"
 #include "dlist.h"
+#include "hash.h"
+#include "bloom.h"
 
 // implementation of a map based on a chained hash table
 
+#define ADS_MAP_MAX_LOAD_FACTOR 1.0 // default: grow when size / buckets goes above it
+#define ADS_MAP_MIN_LOAD_FACTOR 0.0 // default: shrink when size / buckets goes below it (0 = never shrink)
+#define ADS_MAP_REHASH_STEP     4   // non-empty buckets moved to the new table on each operation
+#define ADS_MAP_BATCH_SIZE      16  // keys whose memory accesses are overlapped by the batch functions
+#define ADS_MAP_STATS_PROBES    16  // probe histogram slots, the last one counts every longer lookup
+
+// flags for ads_map_init_flags
+#define ADS_MAP_POW2  0x1 // power-of-two buckets, indexed with a mask instead of a division
+#define ADS_MAP_BLOOM 0x2 // keep a Bloom filter of the keys, most missing keys never reach a bucket
+
 typedef struct ads_map_entry {
   void* key;
   void* value;
+  size_t hash; // cached hash of key, compared before calling compare and reused on rehash
 } ads_map_entry_t;
 
+/* lookup counters, compile with -DADS_MAP_STATS option. probes[n] is the number of lookups that
+   compared n entries before finding the key or giving up */
+typedef struct ads_map_counters {
+  size_t hits;
+  size_t misses;
+  size_t probes[ADS_MAP_STATS_PROBES];
+} ads_map_counters_t;
+
+// filled by ads_map_get_stats
+typedef struct ads_map_stats {
+  size_t size;
+  size_t buckets;       // buckets of both tables while rehashing
+  size_t empty_buckets;
+  size_t max_chain;
+  double mean_chain;    // mean length of the non-empty chains
+  ads_map_counters_t counters; // all zero unless compiled with ADS_MAP_STATS
+} ads_map_stats_t;
+
 typedef struct ads_map {
   ads_dlist_t* htable; // each bucket is a doubly linked list
+  uint64_t* occupied;  // bitmap of the non-empty buckets of htable
   size_t buckets;
   size_t size;
 
+  /* incremental rehashing: when the table grows or shrinks, the old table is kept in old_htable
+     and its buckets are moved to htable a few at a time on each insert/get/remove */
+  ads_dlist_t* old_htable;
+  uint64_t* old_occupied;
+  size_t old_buckets;
+  size_t rehash_index; // next bucket of old_htable to be moved
+  size_t min_buckets;  // the table never shrinks below the number of buckets passed to ads_map_init
+  size_t iterators;    // while > 0, entries are never moved between buckets (no rehash/resize)
+
+  double max_load_factor;
+  double min_load_factor;
+  int flags;
+  const ads_allocator_t* allocator; // of the tables, the entries and the nodes of the buckets
+
+  /* with ADS_MAP_BLOOM, the hashes of the keys of htable (and of some removed ones), sized for
+     it. A resize starts the new table with an empty filter, filled as the buckets are moved,
+     while old_bloom keeps answering for the keys still in old_htable. ads_map_remove starts
+     a rehash into a table of the same size once the removed hashes outnumber both the keys
+     and the blocks of the filter, so no operation rebuilds a whole filter at once */
+  ads_bloom_t bloom;
+  ads_bloom_t old_bloom;
+
+  /* updated by ads_map_get and ads_map_get_batch when compiled with ADS_MAP_STATS. Always
+     present, so that the layout of ads_map_t doesn't depend on the option */
+  ads_map_counters_t counters;
+
   void   (*destroy)(void* value); // destroy the value store into the map
   int    (*compare)(void* key1, void* key2); // function to compare two keys
   size_t (*hash)(void* key); // hash function
@@ -25,7 +85,27 @@ typedef struct ads_map {
 #define ads_map_get_size(map)    ((map)->size)
 #define ads_map_get_buckets(map) ((map)->buckets)
 #define ads_map_is_empty(map)    (ads_map_get_size((map)) == 0)
-#define ads_map_get_index(map, key) ((map)->hash((key)) % (map)->buckets)
+#define ads_map_get_index(map, key) ads_map_index_of((map), (map)->hash((key)), (map)->buckets)
+#define ads_map_is_rehashing(map) ((map)->old_htable != NULL)
+
+// used by ADS_ITERATOR_MAP (see iterator.h)
+#define ads_map_pause_rehash(map)  ((map)->iterators++)
+#define ads_map_resume_rehash(map) ((map)->iterators--)
+
+/* bucket of `hash` in a table with `buckets` buckets. In ADS_MAP_POW2 mode the hash goes
+   through a final bit-mix first, so weak hashes (e.g. small sequential ids) still use all
+   the bits kept by the mask */
+static inline size_t
+ads_map_index_of(const ads_map_t* map, size_t hash, size_t buckets) {
+  if(map->flags & ADS_MAP_POW2) {
+    hash ^= hash >> 32;
+    hash *= 0x9e3779b97f4a7c15;
+    hash ^= hash >> 29;
+    return hash & (buckets - 1);
+  }
+
+  return hash % buckets;
+}
 
 #define ads_map_uint64_key(key) ((void*) ((size_t)(key)))
 
@@ -36,11 +116,40 @@ ads_map_init(ads_map_t* map,
              int    (*compare)(void* key1, void* key2),
              size_t (*hash)(void* key));
 
+ads_status_t
+ads_map_init_flags(ads_map_t* map,
+                   size_t buckets,
+                   int    flags,
+                   void   (*destroy)(void* value),
+                   int    (*compare)(void* key1, void* key2),
+                   size_t (*hash)(void* key));
+
+// NULL uses the default allocator (see allocator.h)
+ads_status_t
+ads_map_init_allocator(ads_map_t* map,
+                       size_t buckets,
+                       int    flags,
+                       const ads_allocator_t* allocator,
+                       void   (*destroy)(void* value),
+                       int    (*compare)(void* key1, void* key2),
+                       size_t (*hash)(void* key));
+
 void ads_map_destroy(ads_map_t* map);
 
+/* ADS_INVALID unless 0 < max_load_factor and 0 <= min_load_factor <= max_load_factor / 2, the
+   factors are left as they were */
+ads_status_t ads_map_set_load_factor(ads_map_t* map, double max_load_factor, double min_load_factor);
+// room for `size` entries without growing. ADS_INVALID while the rehash is paused (iterators)
+ads_status_t ads_map_reserve(ads_map_t* map, size_t size);
+
 size_t ADS_MAP_HASH_STRING(void* key_string);
+size_t ADS_MAP_HASH_STRING_DJB2(void* key_string);
 int ADS_MAP_COMPARE_STRING(void* key_string1, void* key_string2);
 
+// keys are ads_string_t* (see string.h), the length comes from its size
+size_t ADS_MAP_HASH_ADS_STRING(void* key_ads_string);
+int ADS_MAP_COMPARE_ADS_STRING(void* key_ads_string1, void* key_ads_string2);
+
 size_t ADS_MAP_HASH_UINT64(void* key_uint64);
 int ADS_MAP_COMPARE_UINT64(void* key_uint64a, void* key_uint64b);
 
@@ -48,4 +157,32 @@ ads_status_t ads_map_insert(ads_map_t* map, void* key, void* value);
 ads_status_t ads_map_remove(ads_map_t* map, void* key, void** out);
 ads_map_entry_t* ads_map_get(ads_map_t* map, void* key, void** out);
 
+// same as ads_map_get, but never moves buckets of an ongoing rehash, so the map isn't modified
+ads_map_entry_t* ads_map_lookup(const ads_map_t* map, void* key, void** out);
+
+/* same as the functions above with `hash`, which must be map->hash(key), already computed.
+   For wrappers that hash the key themselves, e.g. to pick a stripe (see cmap.h) */
+ads_status_t ads_map_insert_hashed(ads_map_t* map, void* key, void* value, size_t hash);
+ads_status_t ads_map_remove_hashed(ads_map_t* map, void* key, size_t hash, void** out);
+ads_map_entry_t* ads_map_get_hashed(ads_map_t* map, void* key, size_t hash, void** out);
+ads_map_entry_t* ads_map_lookup_hashed(const ads_map_t* map, void* key, size_t hash, void** out);
+
+/* first non-empty bucket at or after `index`, NULL if there is none. While rehashing, indexes
+   [0, old_buckets) are the buckets of the old table and the current table's come after them */
+ads_dlist_t* ads_map_next_bucket(const ads_map_t* map, size_t* index);
+
+/* batched lookups/inserts of `count` keys, prefetching the buckets and entries of several keys
+   before resolving any of them. ads_map_get_batch fills entries[i] (NULL when keys[i] isn't in
+   the map) and out[i] (only when found), both optional, and returns the number of keys found.
+   ads_map_insert_batch stops at the first failure, the keys before it stay inserted */
+size_t ads_map_get_batch(ads_map_t* map, void** keys, size_t count, ads_map_entry_t** entries, void** out);
+ads_status_t ads_map_insert_batch(ads_map_t* map, void** keys, void** values, size_t count);
+
+/* chain lengths and empty buckets are computed on each call by walking both tables. Lookup
+   counters (hits, misses, probes per lookup) are only kept when compiled with ADS_MAP_STATS,
+   and only by ads_map_get and ads_map_get_batch: ads_map_lookup doesn't modify the map */
+void ads_map_get_stats(const ads_map_t* map, ads_map_stats_t* stats);
+void ads_map_reset_stats(ads_map_t* map);
+void ads_map_dump_stats(const ads_map_t* map, FILE* out);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef ADS_MAPFILE_H
+#define ADS_MAPFILE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "error.h"
+#include "map.h"
+
+/*
+  on-disk, memory-mappable format for maps with string or uint64 keys
+
+  ads_mapfile_write serializes an ads_map_t into a file that only uses offsets, never pointers.
+  ads_mapfile_open maps it read-only and the lookups work directly on the mapped pages, so
+  opening is O(1) whatever the size of the map, and every process that opens the same file
+  shares its pages in the page cache.
+
+  Layout (native byte order, all offsets from the start of the file):
+
+    header   ads_mapfile_header_t
+    slots    open-addressing table of ads_mapfile_slot_t, a power of two, at most half full
+    records  one per entry, 8-byte aligned:
+               string keys: uint64 key size, uint64 value size, key bytes + '\0', value bytes
+               uint64 keys: uint64 key,      uint64 value size, value bytes
+
+  The hashes stored in the file don't depend on ads_hash_set_seed, so a file can be opened by
+  any process.
+*/
+
+#define ADS_MAPFILE_MAGIC   "ADSMAP\0\0"
+#define ADS_MAPFILE_VERSION 1
+
+typedef enum {
+  ADS_MAPFILE_STRING = 1, // keys are NUL-terminated strings (ADS_MAP_HASH_STRING/ADS_MAP_COMPARE_STRING maps)
+  ADS_MAPFILE_UINT64 = 2  // keys are ads_map_uint64_key values (ADS_MAP_HASH_UINT64/ADS_MAP_COMPARE_UINT64 maps)
+} ads_mapfile_key_t;
+
+typedef struct ads_mapfile_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_type;
+  uint64_t size;
+  uint64_t slots;
+  uint64_t slots_offset;
+  uint64_t file_size;
+} ads_mapfile_header_t;
+
+typedef struct ads_mapfile_slot {
+  uint64_t hash;
+  uint64_t offset; // offset of the record, 0 = empty slot
+} ads_mapfile_slot_t;
+
+typedef struct ads_mapfile {
+  const char* base; // start of the mapping
+  size_t file_size;
+  size_t size;
+  size_t slots;
+  ads_mapfile_key_t key_type;
+  const ads_mapfile_slot_t* table;
+} ads_mapfile_t;
+
+/* bytes stored for `value`; NULL serializer = values are NUL-terminated strings. It's called
+   twice per value, to size the record and then to write it, and must give the same size both
+   times. The bytes only need to stay valid until the next call, so a buffer can be reused */
+typedef const void* (*ads_mapfile_serialize_f)(void* value, size_t* size);
+
+#define ads_mapfile_get_size(file) ((file)->size)
+
+/* the file is written to a temporary file of its own next to `path` (mode 0644) and renamed
+   over it once complete, so processes that open `path` meanwhile see either the old or the
+   new file, even with several writers. ADS_INVALID if the serializer changed a size */
+ads_status_t
+ads_mapfile_write(ads_map_t*              map,
+                  const char*             path,
+                  ads_mapfile_key_t       key_type,
+                  ads_mapfile_serialize_f serialize);
+
+ads_status_t ads_mapfile_open(ads_mapfile_t* file, const char* path);
+void ads_mapfile_close(ads_mapfile_t* file);
+
+// pointers into the mapped file, valid until ads_mapfile_close; NULL if the key isn't there
+const void* ads_mapfile_get_string(const ads_mapfile_t* file, const char* key, size_t* value_size);
+const void* ads_mapfile_get_uint64(const ads_mapfile_t* file, uint64_t key, size_t* value_size);
+
+#endif
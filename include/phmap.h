@@ -0,0 +1,70 @@
+#ifndef ADS_PHMAP_H
+#define ADS_PHMAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "error.h"
+#include "map.h"
+
+/*
+  frozen map based on a minimal perfect hash (hash and displace, CHD-like)
+
+  Built once from a fixed set of keys, then read only: the keys are spread over n/4 groups and
+  each group gets a displacement that sends all its keys to distinct slots of an n-slot table.
+  A lookup is one call to `hash`, one displacement read and one `compare`, with no chains.
+  The displacements and the slots live in a single contiguous allocation.
+
+  Uses the same compare/hash callbacks as ads_map_t, and its entries are ads_map_entry_t.
+*/
+
+#define ADS_PHMAP_GROUP_SIZE 4 // average number of keys per displacement
+
+typedef struct ads_phmap {
+  void* block;              // single allocation holding displacements and slots
+  uint32_t* displacements;  // one per group
+  ads_map_entry_t* slots;   // exactly `size` slots
+  size_t size;
+  size_t groups;
+  size_t seed;
+  const ads_allocator_t* allocator; // of the block
+
+  void   (*destroy)(void* value); // destroy the value store into the map (NULL when built from an ads_map_t)
+  int    (*compare)(void* key1, void* key2); // function to compare two keys
+  size_t (*hash)(void* key); // hash function
+} ads_phmap_t;
+
+#define ads_phmap_get_size(phmap) ((phmap)->size)
+
+/* build from `count` keys/values. Returns ADS_INVALID if two keys are equal or if two
+   different keys have the same hash, since no displacement can ever separate them.
+   A failed build leaves an empty map, which can still be passed to ads_phmap_destroy */
+ads_status_t
+ads_phmap_build(ads_phmap_t* phmap,
+                void**       keys,
+                void**       values,
+                size_t       count,
+                void   (*destroy)(void* value),
+                int    (*compare)(void* key1, void* key2),
+                size_t (*hash)(void* key));
+
+// the block comes from `allocator`, NULL for the default one (see allocator.h)
+ads_status_t
+ads_phmap_build_allocator(ads_phmap_t* phmap,
+                          void**       keys,
+                          void**       values,
+                          size_t       count,
+                          const ads_allocator_t* allocator,
+                          void   (*destroy)(void* value),
+                          int    (*compare)(void* key1, void* key2),
+                          size_t (*hash)(void* key));
+
+/* build from the entries of `map`, reusing their cached hashes. Keys and values are shared:
+   they still belong to `map`, which must outlive the frozen map. The block comes from the
+   allocator of `map` */
+ads_status_t ads_phmap_build_from_map(ads_phmap_t* phmap, ads_map_t* map);
+
+void ads_phmap_destroy(ads_phmap_t* phmap);
+
+ads_map_entry_t* ads_phmap_get(const ads_phmap_t* phmap, void* key, void** out);
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef ADS_RCUMAP_H
+#define ADS_RCUMAP_H
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "error.h"
+#include "allocator.h"
+
+/*
+  map for read-mostly data: readers never take a lock nor write to a shared cache line
+
+  Writers are serialized by a mutex and never modify a node that readers can reach: an update
+  publishes a new node in place of the old one, a remove unlinks the node and a resize
+  publishes a whole new bucket array, always with a single atomic store. The memory that was
+  unlinked is reclaimed with epochs: every reader thread registers a slot (its own cache line)
+  where it announces the epoch it is reading at, and a writer frees retired memory only when
+  no reader can still see it.
+
+  Usage on the read side:
+
+    ads_rcumap_reader_t* reader = ads_rcumap_reader_register(&map); // once per thread
+    ...
+    ads_rcumap_read_lock(reader);
+    if(ads_rcumap_get(&map, key, &value) == ADS_SUCCESS)
+      use(value); // valid until ads_rcumap_read_unlock
+    ads_rcumap_read_unlock(reader);
+
+  Read sections must not be nested and a thread must not write to the map inside one.
+*/
+
+#define ADS_RCUMAP_CACHE_LINE 64
+#define ADS_RCUMAP_MAX_LOAD_FACTOR 1.0 // publish a table twice as big when size / buckets goes above it
+
+typedef struct ads_rcumap ads_rcumap_t;
+
+typedef struct ads_rcumap_node {
+  _Atomic(struct ads_rcumap_node*) next;
+  void* key;
+  void* value;
+  size_t hash;
+
+  // only touched by writers, once the node is unlinked
+  struct ads_rcumap_node* retired_next;
+  size_t retired_epoch;
+  int destroy_value;
+} ads_rcumap_node_t;
+
+typedef struct ads_rcumap_table {
+  size_t buckets;
+
+  struct ads_rcumap_table* retired_next;
+  size_t retired_epoch;
+
+  _Atomic(ads_rcumap_node_t*) htable[]; // same allocation as the table
+} ads_rcumap_table_t;
+
+typedef struct ads_rcumap_reader {
+  _Alignas(ADS_RCUMAP_CACHE_LINE) _Atomic size_t epoch; // 0 = outside a read section
+  _Atomic int in_use;
+  ads_rcumap_t* map;
+} ads_rcumap_reader_t;
+
+typedef struct ads_rcumap {
+  // read by readers, written only by writers (rarely)
+  _Alignas(ADS_RCUMAP_CACHE_LINE) _Atomic(ads_rcumap_table_t*) table;
+  _Atomic size_t epoch;
+
+  ads_rcumap_reader_t* readers;
+  size_t max_readers;
+
+  int    (*compare)(void* key1, void* key2); // function to compare two keys
+  size_t (*hash)(void* key); // hash function
+  void   (*destroy)(void* value); // destroy the value store into the map
+  const ads_allocator_t* allocator; // of the tables, the nodes and the reader slots
+
+  // writers only
+  _Alignas(ADS_RCUMAP_CACHE_LINE) pthread_mutex_t write_lock;
+  size_t size;
+  ads_rcumap_node_t* retired_nodes;
+  ads_rcumap_table_t* retired_tables;
+} ads_rcumap_t;
+
+#define ads_rcumap_get_size(map) ((map)->size)
+
+// `max_readers` is the number of threads that can be registered at once, ADS_INVALID if 0
+ads_status_t
+ads_rcumap_init(ads_rcumap_t* map,
+                size_t buckets,
+                size_t max_readers,
+                void   (*destroy)(void* value),
+                int    (*compare)(void* key1, void* key2),
+                size_t (*hash)(void* key));
+
+/* NULL uses the default allocator (see allocator.h). Only writers call it, one at a time under
+   write_lock, so it doesn't need to be thread-safe, but it may be called from different threads */
+ads_status_t
+ads_rcumap_init_allocator(ads_rcumap_t* map,
+                          size_t buckets,
+                          size_t max_readers,
+                          const ads_allocator_t* allocator,
+                          void   (*destroy)(void* value),
+                          int    (*compare)(void* key1, void* key2),
+                          size_t (*hash)(void* key));
+
+// no reader may be inside a read section
+void ads_rcumap_destroy(ads_rcumap_t* map);
+
+// NULL if all the `max_readers` slots are taken
+ads_rcumap_reader_t* ads_rcumap_reader_register(ads_rcumap_t* map);
+void ads_rcumap_reader_unregister(ads_rcumap_reader_t* reader);
+
+void ads_rcumap_read_lock(ads_rcumap_reader_t* reader);
+void ads_rcumap_read_unlock(ads_rcumap_reader_t* reader);
+
+// must be called inside a read section
+ads_status_t ads_rcumap_get(ads_rcumap_t* map, void* key, void** out);
+
+/* writers. When `out` is given to ads_rcumap_remove, readers may still be using the value:
+   call ads_rcumap_synchronize before releasing it */
+ads_status_t ads_rcumap_insert(ads_rcumap_t* map, void* key, void* value);
+ads_status_t ads_rcumap_remove(ads_rcumap_t* map, void* key, void** out);
+
+// wait until every reader left the read sections it was in, then free all retired memory
+void ads_rcumap_synchronize(ads_rcumap_t* map);
+
+#endif
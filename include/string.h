@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include "error.h"
+#include "allocator.h"
 
 // compile with -DADS_STRING_EXTENDED option
 #ifdef ADS_STRING_EXTENDED
@@ -19,6 +20,7 @@ typedef struct ads_string {
   size_t size;     // number of characters
   size_t capacity; // number of characters the string can hold at all
   char* buf;       // pointer to basic_str(strings up to 15 chars) or to a region in free store(heap)
+  const ads_allocator_t* allocator; // of buf when it's in the free store
 
   /* optimization: the string will be stored in this buffer if the numbers of characters in the
      string is up to 15. Small strings can be stored on the stack */
@@ -35,6 +37,12 @@ typedef struct ads_string {
   ads_string_init(&(var_name), init_str) \
 
 ads_status_t ads_string_init(ads_string_t* restrict str, const char* restrict init_str);
+
+// NULL uses the default allocator (see allocator.h)
+ads_status_t
+ads_string_init_allocator(ads_string_t* restrict str,
+                          const char*   restrict init_str,
+                          const ads_allocator_t* allocator);
 void ads_string_destroy(ads_string_t* str);
 
 ads_status_t ads_string_concat(ads_string_t* dest, const ads_string_t* src);
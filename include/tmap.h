@@ -0,0 +1,243 @@
+#ifndef ADS_TMAP_H
+#define ADS_TMAP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "error.h"
+#include "hash.h"
+
+/*
+  type-specialized maps, generated by macro and header only
+
+  ADS_MAP_DEFINE(name, key_t, val_t, hash_fn, eq_fn) emits the type name##_t and static inline
+  functions name##_init, name##_destroy, name##_insert, name##_get, name##_remove,
+  name##_reserve and name##_next. Keys and values are stored by value, and hash_fn and eq_fn
+  are called directly, not through pointers, so the compiler can inline them:
+
+    size_t hash_fn(key_t key);
+    int    eq_fn(key_t key1, key_t key2); // non-zero when equal
+
+  Both may also be macros. Keys and values are plain copies: nothing is freed by the map, and
+  a key that owns memory (e.g. a char*) must outlive its slot.
+
+  The table uses open addressing with linear probing. Each slot has a control byte holding a
+  7-bit tag of the key's hash, so eq_fn is only called on a probable match. The capacity is a
+  power of two and the table is rehashed when it would be more than 7/8 full, tombstones
+  included.
+
+  Example:
+
+    ADS_MAP_DEFINE(idmap, uint64_t, double, ADS_TMAP_HASH_UINT64, ADS_TMAP_EQ)
+
+    idmap_t map;
+    idmap_init(&map, 0);
+    idmap_insert(&map, 42, 1.5);
+    double* value = idmap_get(&map, 42);
+*/
+
+#define ADS_TMAP_MIN_CAPACITY 8
+
+// control bytes: a full slot has the high bit set and the tag in the low 7 bits
+#define ADS_TMAP_EMPTY   0x00
+#define ADS_TMAP_DELETED 0x01
+
+#define ads_tmap_get_size(map)     ((map)->size)
+#define ads_tmap_get_capacity(map) ((map)->capacity)
+#define ads_tmap_is_empty(map)     (ads_tmap_get_size((map)) == 0)
+
+#define ads_tmap_max_load(capacity) ((capacity) - (capacity) / 8)
+
+// same final mix as ADS_MAP_POW2 (see map.h): the mask keeps the low bits, so they must be good
+static inline size_t
+ads_tmap_mix(size_t hash) {
+  hash ^= hash >> 32;
+  hash *= 0x9e3779b97f4a7c15;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+#define ads_tmap_tag(hash) ((uint8_t) (0x80 | ((hash) >> 57)))
+
+static inline size_t
+ads_tmap_round_pow2(size_t capacity) {
+  size_t pow2 = ADS_TMAP_MIN_CAPACITY;
+  while(pow2 < capacity)
+    pow2 <<= 1;
+  return pow2;
+}
+
+// ready-made hash/eq functions for integer and string keys
+static inline size_t ADS_TMAP_HASH_UINT64(uint64_t key) { return (size_t) key; }
+
+// same hash as ADS_MAP_HASH_STRING (see hash.h), so the program must be linked with hash.c
+static inline size_t
+ADS_TMAP_HASH_STRING(const char* key) {
+  return ads_hash_bytes(key, strlen(key), ads_hash_get_seed());
+}
+
+#define ADS_TMAP_EQ(key1, key2)        ((key1) == (key2))
+#define ADS_TMAP_EQ_STRING(key1, key2) (strcmp((key1), (key2)) == 0)
+
+#define ADS_MAP_DEFINE(name, key_t, val_t, hash_fn, eq_fn)                                     \
+                                                                                                \
+typedef struct name##_slot {                                                                    \
+  key_t key;                                                                                    \
+  val_t value;                                                                                  \
+} name##_slot_t;                                                                                \
+                                                                                                \
+typedef struct name {                                                                           \
+  uint8_t* ctrl;         /* capacity control bytes */                                           \
+  name##_slot_t* slots;  /* capacity slots */                                                   \
+  size_t capacity;       /* always a power of two */                                            \
+  size_t size;                                                                                  \
+  size_t used;           /* full and deleted slots */                                           \
+} name##_t;                                                                                     \
+                                                                                                \
+static inline void                                                                              \
+name##_destroy(name##_t* map) {                                                                 \
+  free(map->ctrl);                                                                              \
+  free(map->slots);                                                                             \
+  map->ctrl  = NULL;                                                                            \
+  map->slots = NULL;                                                                            \
+  map->size  = 0;                                                                               \
+}                                                                                               \
+                                                                                                \
+/* room for `capacity` entries before the first rehash */                                       \
+static inline ads_status_t                                                                      \
+name##_init(name##_t* map, size_t capacity) {                                                   \
+  capacity = ads_tmap_round_pow2(capacity + capacity / 7 + 1);                                  \
+  map->ctrl = calloc(capacity, sizeof(uint8_t));                                                \
+  map->slots = malloc(capacity * sizeof(name##_slot_t));                                        \
+  map->capacity = capacity;                                                                     \
+  map->size     = 0;                                                                            \
+  map->used     = 0;                                                                            \
+                                                                                                \
+  if(!map->ctrl || !map->slots) {                                                               \
+    name##_destroy(map);                                                                        \
+    return ADS_NOMEM;                                                                           \
+  }                                                                                             \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* index of the slot holding `key`, or capacity if it isn't in the map */                      \
+static inline size_t                                                                            \
+name##_find(const name##_t* map, key_t key, size_t hash) {                                      \
+  size_t mask = map->capacity - 1;                                                              \
+  uint8_t tag = ads_tmap_tag(hash);                                                             \
+                                                                                                \
+  for(size_t i = hash & mask;; i = (i + 1) & mask) {                                            \
+    if(map->ctrl[i] == tag && eq_fn(map->slots[i].key, key))                                    \
+      return i;                                                                                 \
+    if(map->ctrl[i] == ADS_TMAP_EMPTY)                                                          \
+      return map->capacity;                                                                     \
+  }                                                                                             \
+}                                                                                               \
+                                                                                                \
+/* place an entry known not to be in the map, reusing the first tombstone on the way */         \
+static inline void                                                                              \
+name##_place(name##_t* map, key_t key, val_t value, size_t hash) {                              \
+  size_t mask = map->capacity - 1;                                                              \
+  size_t i = hash & mask;                                                                       \
+  while(map->ctrl[i] & 0x80)                                                                    \
+    i = (i + 1) & mask;                                                                         \
+                                                                                                \
+  if(map->ctrl[i] == ADS_TMAP_EMPTY)                                                            \
+    map->used++;                                                                                \
+  map->ctrl[i] = ads_tmap_tag(hash);                                                            \
+  map->slots[i].key   = key;                                                                    \
+  map->slots[i].value = value;                                                                  \
+  map->size++;                                                                                  \
+}                                                                                               \
+                                                                                                \
+/* move the entries to a new table with room for `size` entries, dropping the tombstones */     \
+static inline ads_status_t                                                                      \
+name##_rehash(name##_t* map, size_t size) {                                                     \
+  name##_t new_map;                                                                             \
+  ads_status_t status = name##_init(&new_map, size);                                            \
+  if(status != ADS_SUCCESS)                                                                     \
+    return status;                                                                              \
+                                                                                                \
+  for(size_t i = 0; i < map->capacity; i++) {                                                   \
+    if(map->ctrl[i] & 0x80)                                                                     \
+      name##_place(&new_map, map->slots[i].key, map->slots[i].value,                            \
+                   ads_tmap_mix(hash_fn(map->slots[i].key)));                                   \
+  }                                                                                             \
+                                                                                                \
+  name##_destroy(map);                                                                          \
+  *map = new_map;                                                                               \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* make room for `size` entries without rehashing */                                            \
+static inline ads_status_t                                                                      \
+name##_reserve(name##_t* map, size_t size) {                                                    \
+  if(size <= ads_tmap_max_load(map->capacity))                                                  \
+    return ADS_SUCCESS;                                                                         \
+  return name##_rehash(map, size);                                                              \
+}                                                                                               \
+                                                                                                \
+/* insert `key`, or replace its value if it's already in the map */                             \
+static inline ads_status_t                                                                      \
+name##_insert(name##_t* map, key_t key, val_t value) {                                          \
+  size_t hash = ads_tmap_mix(hash_fn(key));                                                     \
+  size_t index = name##_find(map, key, hash);                                                   \
+  if(index != map->capacity) {                                                                  \
+    map->slots[index].value = value;                                                            \
+    return ADS_SUCCESS;                                                                         \
+  }                                                                                             \
+                                                                                                \
+  if(map->used + 1 > ads_tmap_max_load(map->capacity)) {                                        \
+    /* double the capacity, or keep it when the table is mostly tombstones */                   \
+    size_t size = map->size + 1 > map->capacity / 2 ? map->capacity : map->capacity / 2;        \
+    ads_status_t status = name##_rehash(map, size);                                             \
+    if(status != ADS_SUCCESS)                                                                   \
+      return status;                                                                            \
+  }                                                                                             \
+                                                                                                \
+  name##_place(map, key, value, hash);                                                          \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* pointer to the value of `key` (valid until the next insert), NULL if it isn't in the map */  \
+static inline val_t*                                                                            \
+name##_get(const name##_t* map, key_t key) {                                                    \
+  size_t index = name##_find(map, key, ads_tmap_mix(hash_fn(key)));                             \
+  return index == map->capacity ? NULL : &map->slots[index].value;                              \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_remove(name##_t* map, key_t key, val_t* out) {                                           \
+  size_t index = name##_find(map, key, ads_tmap_mix(hash_fn(key)));                             \
+  if(index == map->capacity)                                                                    \
+    return ADS_NOTFOUND;                                                                        \
+                                                                                                \
+  if(out) *out = map->slots[index].value;                                                       \
+                                                                                                \
+  /* no tombstone is needed when the next slot already stops every probe */                    \
+  size_t next = (index + 1) & (map->capacity - 1);                                              \
+  if(map->ctrl[next] == ADS_TMAP_EMPTY) {                                                       \
+    map->ctrl[index] = ADS_TMAP_EMPTY;                                                          \
+    map->used--;                                                                                \
+  }                                                                                             \
+  else                                                                                          \
+    map->ctrl[index] = ADS_TMAP_DELETED;                                                        \
+                                                                                                \
+  map->size--;                                                                                  \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* first entry at or after slot `index`, NULL if there is none. Iterate with:                   \
+     for(size_t i = 0; (slot = name##_next(&map, &i)); i++) */                                  \
+static inline name##_slot_t*                                                                    \
+name##_next(const name##_t* map, size_t* index) {                                               \
+  for(size_t i = *index; i < map->capacity; i++) {                                              \
+    if(map->ctrl[i] & 0x80) {                                                                   \
+      *index = i;                                                                               \
+      return &map->slots[i];                                                                    \
+    }                                                                                           \
+  }                                                                                             \
+  return NULL;                                                                                  \
+}
+
+#endif
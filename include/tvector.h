@@ -0,0 +1,178 @@
+#ifndef ADS_TVECTOR_H
+#define ADS_TVECTOR_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+
+/*
+  type-specialized vectors, generated by macro and header only
+
+  ADS_VECTOR_DEFINE(name, T) emits the type name##_t, a T* buffer with size and capacity, and
+  static inline functions name##_init, name##_destroy, name##_clear, name##_reserve,
+  name##_shrink_to_fit, name##_push, name##_pop, name##_insert, name##_erase, name##_append_n
+  and name##_at. Elements are plain T values, so loops over name##_t.data compile to ordinary
+  array code. name##_insert and name##_erase shift the elements after `index` with memmove, so
+  elements must stay valid when moved in memory.
+
+  ADS_VECTOR_DEFINE_HOOKS(name, T, copy_fn, destroy_fn) does the same with per-type hooks,
+  called directly (and inlinable) where ads_vector_t (see vector.h) calls through pointers:
+
+    void copy_fn(T* dest, T const* src);  // copy an element into uninitialized memory
+    void destroy_fn(T* elem);             // release what an element owns
+
+  Both may also be macros. ADS_VECTOR_DEFINE uses plain assignment and no destroy, so the
+  copy loops of name##_push and name##_append_n reduce to stores the compiler can vectorize.
+
+  Example:
+
+    ADS_VECTOR_DEFINE(dvec, double)
+
+    dvec_t vec;
+    dvec_init(&vec, 0);
+    dvec_push(&vec, 1.5);
+    for(size_t i = 0; i < vec.size; i++)
+      sum += vec.data[i];
+*/
+
+#define ADS_TVECTOR_PRE_ALLOCATE 4
+
+#define ADS_TVECTOR_ASSIGN(dest, src)  (*(dest) = *(src))
+#define ADS_TVECTOR_NO_DESTROY(elem)   ((void) (elem))
+
+#define ads_tvector_get_size(vec)     ((vec)->size)
+#define ads_tvector_get_capacity(vec) ((vec)->capacity)
+#define ads_tvector_is_empty(vec)     (ads_tvector_get_size((vec)) == 0)
+
+#define ADS_VECTOR_DEFINE(name, T) \
+  ADS_VECTOR_DEFINE_HOOKS(name, T, ADS_TVECTOR_ASSIGN, ADS_TVECTOR_NO_DESTROY)
+
+#define ADS_VECTOR_DEFINE_HOOKS(name, T, copy_fn, destroy_fn)                                  \
+                                                                                                \
+typedef struct name {                                                                           \
+  T* data;                                                                                      \
+  size_t size;                                                                                  \
+  size_t capacity;                                                                              \
+} name##_t;                                                                                     \
+                                                                                                \
+/* exactly `capacity` elements, 0 allocates nothing */                                          \
+static inline ads_status_t                                                                      \
+name##_set_capacity(name##_t* vec, size_t capacity) {                                           \
+  if(capacity == 0) {                                                                           \
+    free(vec->data);                                                                            \
+    vec->data = NULL;                                                                           \
+    vec->capacity = 0;                                                                          \
+    return ADS_SUCCESS;                                                                         \
+  }                                                                                             \
+                                                                                                \
+  T* data = realloc(vec->data, capacity * sizeof(T));                                           \
+  if(data == NULL)                                                                              \
+    return ADS_NOMEM;                                                                           \
+                                                                                                \
+  vec->data = data;                                                                             \
+  vec->capacity = capacity;                                                                     \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_init(name##_t* vec, size_t capacity) {                                                   \
+  vec->data = NULL;                                                                             \
+  vec->size = 0;                                                                                \
+  vec->capacity = 0;                                                                            \
+  return name##_set_capacity(vec, capacity);                                                    \
+}                                                                                               \
+                                                                                                \
+static inline void                                                                              \
+name##_clear(name##_t* vec) {                                                                   \
+  for(size_t i = 0; i < vec->size; i++)                                                         \
+    destroy_fn(&vec->data[i]);                                                                  \
+  vec->size = 0;                                                                                \
+}                                                                                               \
+                                                                                                \
+static inline void                                                                              \
+name##_destroy(name##_t* vec) {                                                                 \
+  name##_clear(vec);                                                                            \
+  name##_set_capacity(vec, 0);                                                                  \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_reserve(name##_t* vec, size_t capacity) {                                                \
+  return capacity <= vec->capacity ? ADS_SUCCESS : name##_set_capacity(vec, capacity);          \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_shrink_to_fit(name##_t* vec) {                                                           \
+  return vec->size == vec->capacity ? ADS_SUCCESS : name##_set_capacity(vec, vec->size);        \
+}                                                                                               \
+                                                                                                \
+/* room for `needed` elements, doubling the capacity */                                         \
+static inline ads_status_t                                                                      \
+name##_grow(name##_t* vec, size_t needed) {                                                     \
+  if(needed <= vec->capacity)                                                                   \
+    return ADS_SUCCESS;                                                                         \
+                                                                                                \
+  size_t capacity = vec->capacity ? vec->capacity * 2 : ADS_TVECTOR_PRE_ALLOCATE;               \
+  return name##_set_capacity(vec, capacity < needed ? needed : capacity);                       \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_push(name##_t* vec, T value) {                                                           \
+  if(vec->size == vec->capacity && name##_grow(vec, vec->size + 1) != ADS_SUCCESS)              \
+    return ADS_NOMEM;                                                                           \
+                                                                                                \
+  copy_fn(&vec->data[vec->size], &value);                                                       \
+  vec->size++;                                                                                  \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+static inline void                                                                              \
+name##_pop(name##_t* vec) {                                                                     \
+  if(vec->size > 0)                                                                             \
+    destroy_fn(&vec->data[--vec->size]);                                                        \
+}                                                                                               \
+                                                                                                \
+/* `value` goes at `index` (at most size), the elements from there move one place up */         \
+static inline ads_status_t                                                                      \
+name##_insert(name##_t* vec, size_t index, T value) {                                           \
+  if(index > vec->size)                                                                         \
+    return ADS_OUTOFBOUNDS;                                                                     \
+                                                                                                \
+  if(vec->size == vec->capacity && name##_grow(vec, vec->size + 1) != ADS_SUCCESS)              \
+    return ADS_NOMEM;                                                                           \
+                                                                                                \
+  memmove(&vec->data[index + 1], &vec->data[index], (vec->size - index) * sizeof(T));           \
+  copy_fn(&vec->data[index], &value);                                                           \
+  vec->size++;                                                                                  \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+static inline ads_status_t                                                                      \
+name##_erase(name##_t* vec, size_t index) {                                                     \
+  if(index >= vec->size)                                                                        \
+    return ADS_OUTOFBOUNDS;                                                                     \
+                                                                                                \
+  destroy_fn(&vec->data[index]);                                                                \
+  memmove(&vec->data[index], &vec->data[index + 1], (vec->size - index - 1) * sizeof(T));       \
+  vec->size--;                                                                                  \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* `values` must not point into the vector, it may move when growing */                         \
+static inline ads_status_t                                                                      \
+name##_append_n(name##_t* vec, T const* values, size_t count) {                                 \
+  if(name##_grow(vec, vec->size + count) != ADS_SUCCESS)                                        \
+    return ADS_NOMEM;                                                                           \
+                                                                                                \
+  for(size_t i = 0; i < count; i++)                                                             \
+    copy_fn(&vec->data[vec->size + i], &values[i]);                                             \
+  vec->size += count;                                                                           \
+  return ADS_SUCCESS;                                                                           \
+}                                                                                               \
+                                                                                                \
+/* unchecked, like indexing data directly */                                                    \
+static inline T*                                                                                \
+name##_at(const name##_t* vec, size_t index) {                                                  \
+  return &vec->data[index];                                                                     \
+}
+
+#endif
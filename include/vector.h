@@ -3,6 +3,15 @@
 
 #include <stdlib.h>
 #include "error.h"
+#include "allocator.h"
+
+#define ADS_VECTOR_PRE_ALLOCATE   4           // capacity given by ads_vector_init
+#define ADS_VECTOR_GROWTH_FACTOR  2.0         // default: capacity is multiplied by it when full
+#define ADS_VECTOR_MMAP_THRESHOLD (1 << 20)   // buffers of this many bytes or more are mmap'ed
+#define ADS_VECTOR_HUGEPAGE_THRESHOLD (2 << 20) // mapped buffers from this size get MADV_HUGEPAGE
+
+// flags for ads_vector_init_aligned
+#define ADS_VECTOR_HUGEPAGE 0x1 // ask for transparent huge pages on large buffers
 
 typedef struct ads_vector ads_vector_t;
 
@@ -15,6 +24,15 @@ typedef struct ads_vector {
   size_t capacity;
   void* buf;
 
+  double growth_factor;
+  int mapped; // buf comes from mmap and grows with mremap, so its pages are never copied
+  const ads_allocator_t* allocator; // of the heap buffers
+  int flags;
+  size_t alignment; // of buf, 0 for malloc's default
+
+  void* inline_buf;       // storage given by the caller to ads_vector_init_inline, or NULL
+  size_t inline_capacity; // elements that fit in inline_buf
+
   ads_vector_copy_f    copy;
   ads_vector_destroy_f destroy;
 } ads_vector_t;
@@ -22,6 +40,16 @@ typedef struct ads_vector {
 #define ads_vector_is_full(vec) ((vec)->size == (vec)->capacity)
 #define ads_vector_get_idx_address(vec, index) ( &((char*)(vec)->buf)[(index) * (vec)->data_size] )
 #define ads_vector_get_as(vec, type) ((type)(vec)->buf)
+#define ads_vector_is_inline(vec) ((vec)->buf != NULL && (vec)->buf == (vec)->inline_buf)
+
+/* a vector with room for `n` elements of `type` next to it, like the basic_str of
+   ads_string_t (see string.h). Declare it with ADS_SMALL_VECTOR(type, n) name; and initialize
+   it with ads_small_vector_init(&name, copy, destroy); then use &name.vec as any vector */
+#define ADS_SMALL_VECTOR(type, n) struct { ads_vector_t vec; type storage[(n)]; }
+
+#define ads_small_vector_init(svec, copy, destroy)                                              \
+  ads_vector_init_inline(&(svec)->vec, sizeof((svec)->storage[0]), (svec)->storage,             \
+                         sizeof((svec)->storage) / sizeof((svec)->storage[0]), (copy), (destroy))
 
 ads_status_t
 ads_vector_init(ads_vector_t*        vec,
@@ -29,6 +57,58 @@ ads_vector_init(ads_vector_t*        vec,
                 ads_vector_copy_f    copy,
                 ads_vector_destroy_f destroy);
 
+/* `capacity` elements are allocated up front (0 allocates nothing until the first insertion)
+   and the capacity is multiplied by `growth_factor` whenever the vector is full. A factor
+   below 2, like 1.5, lets the allocator reuse the memory of previous buffers */
+ads_status_t
+ads_vector_init_capacity(ads_vector_t*        vec,
+                         size_t               data_size,
+                         size_t               capacity,
+                         double               growth_factor,
+                         ads_vector_copy_f    copy,
+                         ads_vector_destroy_f destroy);
+
+/* same as ads_vector_init_capacity with the default growth factor, but the buffers come from
+   `allocator` (NULL for the default one, see allocator.h). Only vectors on ads_allocator_std
+   map their large buffers */
+ads_status_t
+ads_vector_init_allocator(ads_vector_t*          vec,
+                          size_t                 data_size,
+                          size_t                 capacity,
+                          const ads_allocator_t* allocator,
+                          ads_vector_copy_f      copy,
+                          ads_vector_destroy_f   destroy);
+
+/* same as ads_vector_init_capacity with the default growth factor, but buf is always aligned
+   to `alignment` bytes (a power of two, e.g. 32 for AVX2 or 64 for AVX-512 and cache lines),
+   also after growing or shrinking. ADS_INVALID if `alignment` isn't a power of two or is above the page size */
+ads_status_t
+ads_vector_init_aligned(ads_vector_t*        vec,
+                        size_t               data_size,
+                        size_t               capacity,
+                        size_t               alignment,
+                        int                  flags,
+                        ads_vector_copy_f    copy,
+                        ads_vector_destroy_f destroy);
+
+/* the elements are kept in `storage`, room for `capacity` elements owned by the caller, until
+   the vector outgrows it and moves to the heap. Nothing is allocated before that, and the
+   vector moves back when shrunk to fit in `storage`. The vector must not outlive `storage`;
+   an ads_vector_copy of it always lives on the heap */
+ads_status_t
+ads_vector_init_inline(ads_vector_t*        vec,
+                       size_t               data_size,
+                       void*                storage,
+                       size_t               capacity,
+                       ads_vector_copy_f    copy,
+                       ads_vector_destroy_f destroy);
+
+// make room for at least `capacity` elements; the capacity never decreases
+ads_status_t ads_vector_reserve(ads_vector_t* vec, size_t capacity);
+
+// release the unused capacity
+ads_status_t ads_vector_shrink_to_fit(ads_vector_t* vec);
+
 void ads_vector_clear(ads_vector_t* vec);
 void ads_vector_destroy(ads_vector_t* vec);
 
@@ -42,4 +122,12 @@ ads_status_t ads_vector_insert_at(ads_vector_t* vec, ssize_t index, void* data);
 ads_status_t ads_vector_get_at(ads_vector_t* vec, ssize_t index, void** out);
 ads_status_t ads_vector_copy(ads_vector_t* dest, const ads_vector_t* src);
 
+/* `data` points to `count` contiguous elements, outside of the vector. The vector grows at
+   most once and the elements after `index` are moved with a single memmove */
+ads_status_t ads_vector_append_n(ads_vector_t* vec, const void* data, size_t count);
+ads_status_t ads_vector_insert_range(ads_vector_t* vec, ssize_t index, const void* data, size_t count);
+
+// destroy the elements in [index, index + count) and close the gap
+ads_status_t ads_vector_erase_range(ads_vector_t* vec, ssize_t index, size_t count);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "../include/allocator.h"
+
+static void*
+ads_std_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+
+  // aligned_alloc wants a multiple of the alignment
+  return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void*
+ads_std_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  (void) ctx; (void) old_size;
+  return realloc(ptr, new_size);
+}
+
+static void
+ads_std_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx; (void) size;
+  free(ptr);
+}
+
+const ads_allocator_t ads_allocator_std = {
+  .alloc   = ads_std_alloc,
+  .realloc = ads_std_realloc,
+  .free    = ads_std_free,
+  .ctx     = NULL
+};
+
+static _Atomic(const ads_allocator_t*) ads_allocator_default = &ads_allocator_std;
+
+void ads_allocator_set_default(const ads_allocator_t* allocator) {
+  atomic_store(&ads_allocator_default, ads_allocator_or_std(allocator));
+}
+
+const ads_allocator_t* ads_allocator_get_default(void) {
+  return atomic_load_explicit(&ads_allocator_default, memory_order_acquire);
+}
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/arena.h"
+
+/* ----- ALLOCATOR INTERFACE ----- */
+
+static void*
+ads_arena_allocator_alloc(void* ctx, size_t size, size_t alignment) {
+  return ads_arena_alloc(ctx, size, alignment);
+}
+
+static void*
+ads_arena_allocator_realloc(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+  return ads_arena_realloc(ctx, ptr, old_size, new_size);
+}
+
+/* ---------- */
+
+void ads_arena_init(ads_arena_t* arena, size_t chunk_size) {
+  arena->chunk      = NULL;
+  arena->chunk_size = chunk_size ? chunk_size : ADS_ARENA_CHUNK_SIZE;
+  arena->next_size  = arena->chunk_size;
+  arena->last       = NULL;
+
+  arena->allocator.alloc   = ads_arena_allocator_alloc;
+  arena->allocator.realloc = ads_arena_allocator_realloc;
+  arena->allocator.free    = NULL; // memory is only released with the arena
+  arena->allocator.ctx     = arena;
+}
+
+void ads_arena_destroy(ads_arena_t* arena) {
+  while(arena->chunk) {
+    ads_arena_chunk_t* prev = arena->chunk->prev;
+    free(arena->chunk);
+    arena->chunk = prev;
+  }
+
+  arena->next_size = arena->chunk_size;
+  arena->last      = NULL;
+}
+
+// `size` bytes aligned to `alignment` from the free space of `chunk`, or NULL if they don't fit
+static inline void*
+ads_arena_bump(ads_arena_chunk_t* chunk, size_t size, size_t alignment) {
+  uintptr_t start   = (uintptr_t) &chunk->data[chunk->used];
+  uintptr_t aligned = (start + alignment - 1) & ~((uintptr_t) alignment - 1);
+  size_t offset     = aligned - (uintptr_t) chunk->data;
+
+  if(offset > chunk->size || size > chunk->size - offset)
+    return NULL;
+
+  chunk->used = offset + size;
+  return (void*) aligned;
+}
+
+// a new chunk with at least `needed` bytes, which becomes the current one
+static ads_arena_chunk_t*
+ads_arena_add_chunk(ads_arena_t* arena, size_t needed) {
+  size_t size = arena->next_size < needed ? needed : arena->next_size;
+
+  ads_arena_chunk_t* chunk = malloc(sizeof(ads_arena_chunk_t) + size);
+  if(!chunk)
+    return NULL;
+
+  chunk->prev = arena->chunk;
+  chunk->size = size;
+  chunk->used = 0;
+  arena->chunk = chunk;
+
+  if(arena->next_size < ADS_ARENA_MAX_CHUNK_SIZE)
+    arena->next_size *= 2;
+
+  return chunk;
+}
+
+void* ads_arena_alloc(ads_arena_t* arena, size_t size, size_t alignment) {
+  if(alignment < ADS_ARENA_ALIGNMENT)
+    alignment = ADS_ARENA_ALIGNMENT;
+
+  void* ptr = arena->chunk ? ads_arena_bump(arena->chunk, size, alignment) : NULL;
+  if(!ptr) {
+    // the free space left in the current chunk is given up
+    if(size > SIZE_MAX - alignment || !ads_arena_add_chunk(arena, size + alignment - 1))
+      return NULL;
+
+    ptr = ads_arena_bump(arena->chunk, size, alignment);
+  }
+
+  arena->last = ptr;
+  return ptr;
+}
+
+void* ads_arena_realloc(ads_arena_t* arena, void* ptr, size_t old_size, size_t new_size) {
+  if(ptr == NULL)
+    return ads_arena_alloc(arena, new_size, 0);
+
+  ads_arena_chunk_t* chunk = arena->chunk;
+  if(ptr == arena->last) {
+    size_t offset = (unsigned char*) ptr - chunk->data;
+    if(new_size <= chunk->size - offset) {
+      chunk->used = offset + new_size;
+      return ptr;
+    }
+  }
+  else if(new_size <= old_size)
+    return ptr;
+
+  void* new_ptr = ads_arena_alloc(arena, new_size, 0);
+  if(new_ptr)
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+
+  return new_ptr;
+}
+
+void ads_arena_mark(const ads_arena_t* arena, ads_arena_mark_t* mark) {
+  mark->chunk = arena->chunk;
+  mark->used  = arena->chunk ? arena->chunk->used : 0;
+}
+
+void ads_arena_reset(ads_arena_t* arena, const ads_arena_mark_t* mark) {
+  ads_arena_chunk_t* keep = mark ? mark->chunk : NULL;
+
+  // without a mark, the oldest chunk is kept
+  while(arena->chunk && arena->chunk != keep && (mark || arena->chunk->prev)) {
+    ads_arena_chunk_t* prev = arena->chunk->prev;
+    free(arena->chunk);
+    arena->chunk = prev;
+  }
+
+  if(arena->chunk)
+    arena->chunk->used = mark ? mark->used : 0;
+
+  arena->last = NULL;
+}
+
+size_t ads_arena_get_capacity(const ads_arena_t* arena) {
+  size_t capacity = 0;
+  for(ads_arena_chunk_t* chunk = arena->chunk; chunk; chunk = chunk->prev)
+    capacity += chunk->size;
+
+  return capacity;
+}
+
+/* ----- THREAD ARENAS ----- */
+
+static pthread_key_t  ads_arena_key;
+static pthread_once_t ads_arena_key_once = PTHREAD_ONCE_INIT;
+
+static void
+ads_arena_thread_exit(void* arena) {
+  ads_arena_destroy(arena);
+  free(arena);
+}
+
+static void
+ads_arena_create_key(void) {
+  pthread_key_create(&ads_arena_key, ads_arena_thread_exit);
+}
+
+ads_arena_t* ads_arena_thread(void) {
+  pthread_once(&ads_arena_key_once, ads_arena_create_key);
+
+  ads_arena_t* arena = pthread_getspecific(ads_arena_key);
+  if(arena)
+    return arena;
+
+  arena = malloc(sizeof(ads_arena_t));
+  if(!arena)
+    return NULL;
+
+  ads_arena_init(arena, 0);
+  if(pthread_setspecific(ads_arena_key, arena) != 0) {
+    free(arena);
+    return NULL;
+  }
+
+  return arena;
+}
@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/bloom.h"
+
+// odd multipliers, one per word of the block, each one picks the bit set in that word
+static const uint64_t ads_bloom_salt[ADS_BLOOM_BLOCK_WORDS] = {
+  0x47b6137b44974d91, 0x8824ad5ba2b7289d, 0x705495c72df1424b, 0x9efc49475c6bfb31,
+  0x1ee6aa4a2a9f9a63, 0x5c6bfb31f2ab0dd5, 0x2df1424bb1b7a0d1, 0xa2b7289d6bd3ae7f
+};
+
+/* the hash is mixed once more so that the block doesn't depend on the same bits that pick
+   the bucket of a map using the same hash */
+static inline uint64_t
+ads_bloom_mix(size_t hash) {
+  uint64_t h = hash;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  return h;
+}
+
+static inline uint64_t*
+ads_bloom_block_of(const ads_bloom_t* bloom, uint64_t h) {
+  // the high 32 bits scaled to [0, n_blocks), no division needed
+  size_t block = (size_t) (((h >> 32) * (uint64_t) bloom->n_blocks) >> 32);
+  return &bloom->blocks[block * ADS_BLOOM_BLOCK_WORDS];
+}
+
+// bit of word `i` for the low 32 bits of the hash
+#define ads_bloom_bit(h, i) (UINT64_C(1) << ((((uint32_t) (h)) * ads_bloom_salt[(i)]) >> 58))
+
+ads_status_t ads_bloom_init(ads_bloom_t* bloom, size_t capacity) {
+  return ads_bloom_init_allocator(bloom, capacity, NULL);
+}
+
+ads_status_t
+ads_bloom_init_allocator(ads_bloom_t* bloom, size_t capacity, const ads_allocator_t* allocator) {
+  size_t bits = capacity * ADS_BLOOM_BITS_PER_KEY;
+  size_t n_blocks = (bits + ADS_BLOOM_BLOCK_SIZE * 8 - 1) / (ADS_BLOOM_BLOCK_SIZE * 8);
+  if(n_blocks == 0)
+    n_blocks = 1;
+
+  // the scaling in ads_bloom_block_of only reaches 2^32 blocks
+  if(n_blocks > UINT32_MAX)
+    n_blocks = UINT32_MAX;
+
+  bloom->allocator = allocator ? allocator : ads_allocator_get_default();
+  bloom->blocks = ads_alloc_aligned(bloom->allocator, n_blocks * ADS_BLOOM_BLOCK_SIZE,
+                                    ADS_BLOOM_BLOCK_SIZE);
+  if(!bloom->blocks)
+    return ADS_NOMEM;
+
+  bloom->n_blocks = n_blocks;
+  ads_bloom_clear(bloom);
+
+  return ADS_SUCCESS;
+}
+
+void ads_bloom_destroy(ads_bloom_t* bloom) {
+  ads_free(bloom->allocator, bloom->blocks, bloom->n_blocks * ADS_BLOOM_BLOCK_SIZE);
+  bloom->blocks   = NULL;
+  bloom->n_blocks = 0;
+  bloom->count    = 0;
+}
+
+void ads_bloom_clear(ads_bloom_t* bloom) {
+  memset(bloom->blocks, 0, bloom->n_blocks * ADS_BLOOM_BLOCK_SIZE);
+  bloom->count = 0;
+}
+
+void ads_bloom_add(ads_bloom_t* bloom, size_t hash) {
+  uint64_t h = ads_bloom_mix(hash);
+  uint64_t* block = ads_bloom_block_of(bloom, h);
+
+  for(size_t i = 0; i < ADS_BLOOM_BLOCK_WORDS; i++)
+    block[i] |= ads_bloom_bit(h, i);
+
+  bloom->count++;
+}
+
+int ads_bloom_may_contain(const ads_bloom_t* bloom, size_t hash) {
+  uint64_t h = ads_bloom_mix(hash);
+  const uint64_t* block = ads_bloom_block_of(bloom, h);
+
+  // no early exit: the block is already in cache and the loop is branch-free
+  uint64_t missing = 0;
+  for(size_t i = 0; i < ADS_BLOOM_BLOCK_WORDS; i++)
+    missing |= ads_bloom_bit(h, i) & ~block[i];
+
+  return missing == 0;
+}
@@ -0,0 +1,591 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/btree.h"
+
+/* ----- COMPARE FUNCTIONS ----- */
+
+int ADS_BTREE_COMPARE_STRING(void* key_string1, void* key_string2) {
+  return strcmp(key_string1, key_string2);
+}
+
+int ADS_BTREE_COMPARE_UINT64(void* key_uint64a, void* key_uint64b) {
+  size_t a = (size_t) key_uint64a;
+  size_t b = (size_t) key_uint64b;
+  return (a > b) - (a < b);
+}
+
+/* ----- NODES ----- */
+
+#define ads_btree_as_leaf(node)  ((ads_btree_leaf_t*) (node))
+#define ads_btree_as_inner(node) ((ads_btree_inner_t*) (node))
+
+// bytes of a node, rounded up to its alignment
+#define ads_btree_node_size(leaf) \
+  (((leaf) ? sizeof(ads_btree_leaf_t) : sizeof(ads_btree_inner_t)) + ADS_BTREE_NODE_ALIGN - 1) \
+    / ADS_BTREE_NODE_ALIGN * ADS_BTREE_NODE_ALIGN
+
+// nodes are aligned so that the keys of a node are exactly a pair of cache lines
+static void*
+ads_btree_alloc_node(const ads_btree_t* tree, int leaf) {
+  size_t size = ads_btree_node_size(leaf);
+
+  ads_btree_node_t* node = ads_alloc_aligned(tree->allocator, size, ADS_BTREE_NODE_ALIGN);
+  if(node) {
+    memset(node, 0, size);
+    node->leaf = leaf;
+  }
+
+  return node;
+}
+
+#define ads_btree_new_leaf(tree)  ((ads_btree_leaf_t*)  ads_btree_alloc_node((tree), 1))
+#define ads_btree_new_inner(tree) ((ads_btree_inner_t*) ads_btree_alloc_node((tree), 0))
+
+static inline void
+ads_btree_release_node(const ads_btree_t* tree, void* node) {
+  ads_free(tree->allocator, node, ads_btree_node_size(((ads_btree_node_t*) node)->leaf));
+}
+
+// free `node` and its subtree
+static void
+ads_btree_free_node(const ads_btree_t* tree, ads_btree_node_t* node, void (*destroy)(void* value)) {
+  if(node->leaf) {
+    if(destroy) {
+      for(size_t i = 0; i < node->count; i++)
+        destroy(ads_btree_as_leaf(node)->values[i]);
+    }
+  }
+  else {
+    for(size_t i = 0; i <= node->count; i++)
+      ads_btree_free_node(tree, ads_btree_as_inner(node)->children[i], destroy);
+  }
+
+  ads_btree_release_node(tree, node);
+}
+
+// number of keys of `node` that are < key (or <= key when `after_equal`), by binary search
+static size_t
+ads_btree_search(const ads_btree_t* tree, const ads_btree_node_t* node, void* key, int after_equal) {
+  size_t low = 0, high = node->count;
+
+  while(low < high) {
+    size_t mid = (low + high) / 2;
+    int cmp = tree->compare(node->keys[mid], key);
+    if(cmp < 0 || (cmp == 0 && after_equal))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return low;
+}
+
+// a separator is the smallest key of the subtree on its right, so equal keys go right
+#define ads_btree_child_index(tree, node, key) ads_btree_search((tree), (node), (key), 1)
+
+static ads_btree_leaf_t*
+ads_btree_find_leaf(const ads_btree_t* tree, void* key) {
+  ads_btree_node_t* node = tree->root;
+  while(!node->leaf)
+    node = ads_btree_as_inner(node)->children[ads_btree_child_index(tree, node, key)];
+  return ads_btree_as_leaf(node);
+}
+
+static void*
+ads_btree_min_key(ads_btree_node_t* node) {
+  while(!node->leaf)
+    node = ads_btree_as_inner(node)->children[0];
+  return node->keys[0];
+}
+
+ads_status_t
+ads_btree_init(ads_btree_t* tree,
+               void (*destroy)(void* value),
+               int  (*compare)(void* key1, void* key2))
+{
+  return ads_btree_init_allocator(tree, NULL, destroy, compare);
+}
+
+ads_status_t
+ads_btree_init_allocator(ads_btree_t* tree,
+                         const ads_allocator_t* allocator,
+                         void (*destroy)(void* value),
+                         int  (*compare)(void* key1, void* key2))
+{
+  tree->allocator = allocator ? allocator : ads_allocator_get_default();
+  tree->root = (ads_btree_node_t*) ads_btree_new_leaf(tree);
+  if(!tree->root)
+    return ADS_NOMEM;
+
+  tree->size    = 0;
+  tree->destroy = destroy;
+  tree->compare = compare;
+
+  return ADS_SUCCESS;
+}
+
+void ads_btree_destroy(ads_btree_t* tree) {
+  if(tree->root)
+    ads_btree_free_node(tree, tree->root, tree->destroy);
+
+  tree->root = NULL;
+  tree->size = 0;
+}
+
+/* ----- INSERTION ----- */
+
+/*
+  full nodes are split on the way down, before going into them, so a split never goes back up:
+  the parent always has room for the new separator. A node is only allocated when a split
+  actually happens, and each split leaves the tree valid, so running out of memory midway
+  just leaves the key out.
+
+  A leaf keeps the lower half of its entries and the first key of the new right leaf is copied
+  to the parent. An inner node keeps the keys before its middle one, which moves up.
+*/
+
+// split parent->children[i], which is full, and insert the separator in `parent`, which isn't
+static ads_status_t
+ads_btree_split_child(const ads_btree_t* tree, ads_btree_inner_t* parent, size_t i) {
+  ads_btree_node_t* child = parent->children[i];
+  ads_btree_node_t* right = NULL;
+  void* separator = NULL;
+
+  if(child->leaf) {
+    ads_btree_leaf_t* leaf = ads_btree_as_leaf(child);
+    ads_btree_leaf_t* split = ads_btree_new_leaf(tree);
+    if(!split)
+      return ADS_NOMEM;
+
+    size_t half = (ADS_BTREE_NODE_KEYS + 1) / 2;
+    split->node.count = ADS_BTREE_NODE_KEYS - half;
+    memcpy(split->node.keys, &child->keys[half], split->node.count * sizeof(void*));
+    memcpy(split->values, &leaf->values[half], split->node.count * sizeof(void*));
+    child->count = half;
+
+    split->next = leaf->next;
+    split->prev = leaf;
+    if(leaf->next) leaf->next->prev = split;
+    leaf->next = split;
+
+    right = (ads_btree_node_t*) split;
+    separator = split->node.keys[0];
+  }
+  else {
+    ads_btree_inner_t* inner = ads_btree_as_inner(child);
+    ads_btree_inner_t* split = ads_btree_new_inner(tree);
+    if(!split)
+      return ADS_NOMEM;
+
+    // the middle key moves up, the keys and children after it go to the new node
+    size_t half = ADS_BTREE_NODE_KEYS / 2;
+    split->node.count = ADS_BTREE_NODE_KEYS - half - 1;
+    memcpy(split->node.keys, &child->keys[half + 1], split->node.count * sizeof(void*));
+    memcpy(split->children, &inner->children[half + 1], (split->node.count + 1) * sizeof(ads_btree_node_t*));
+    child->count = half;
+
+    right = (ads_btree_node_t*) split;
+    separator = child->keys[half];
+  }
+
+  size_t count = parent->node.count;
+  memmove(&parent->node.keys[i + 1], &parent->node.keys[i], (count - i) * sizeof(void*));
+  memmove(&parent->children[i + 2], &parent->children[i + 1], (count - i) * sizeof(ads_btree_node_t*));
+  parent->node.keys[i] = separator;
+  parent->children[i + 1] = right;
+  parent->node.count++;
+
+  return ADS_SUCCESS;
+}
+
+// `leaf` has room for one more entry
+static void
+ads_btree_insert_leaf(ads_btree_t* tree, ads_btree_leaf_t* leaf, void* key, void* value) {
+  size_t pos = ads_btree_search(tree, &leaf->node, key, 0);
+
+  // the key is already in the tree, replace the value
+  if(pos < leaf->node.count && tree->compare(leaf->node.keys[pos], key) == 0) {
+    if(tree->destroy) tree->destroy(leaf->values[pos]);
+    leaf->values[pos] = value;
+    return;
+  }
+
+  memmove(&leaf->node.keys[pos + 1], &leaf->node.keys[pos], (leaf->node.count - pos) * sizeof(void*));
+  memmove(&leaf->values[pos + 1], &leaf->values[pos], (leaf->node.count - pos) * sizeof(void*));
+  leaf->node.keys[pos] = key;
+  leaf->values[pos] = value;
+  leaf->node.count++;
+  tree->size++;
+}
+
+ads_status_t ads_btree_insert(ads_btree_t* tree, void* key, void* value) {
+  // a full root is split under a new root, the tree then grows by one level
+  if(tree->root->count == ADS_BTREE_NODE_KEYS) {
+    ads_btree_inner_t* root = ads_btree_new_inner(tree);
+    if(!root)
+      return ADS_NOMEM;
+
+    root->children[0] = tree->root;
+    if(ads_btree_split_child(tree, root, 0) != ADS_SUCCESS) {
+      ads_btree_release_node(tree, root);
+      return ADS_NOMEM;
+    }
+    tree->root = (ads_btree_node_t*) root;
+  }
+
+  ads_btree_node_t* node = tree->root;
+  while(!node->leaf) {
+    ads_btree_inner_t* inner = ads_btree_as_inner(node);
+    size_t i = ads_btree_child_index(tree, node, key);
+
+    if(inner->children[i]->count == ADS_BTREE_NODE_KEYS) {
+      if(ads_btree_split_child(tree, inner, i) != ADS_SUCCESS)
+        return ADS_NOMEM;
+
+      // equal keys go right of the new separator
+      if(tree->compare(node->keys[i], key) <= 0)
+        i++;
+    }
+
+    node = inner->children[i];
+  }
+
+  ads_btree_insert_leaf(tree, ads_btree_as_leaf(node), key, value);
+
+  return ADS_SUCCESS;
+}
+
+/* ----- REMOVAL ----- */
+
+// remove keys[index] and children[index + 1] of an inner node
+static void
+ads_btree_inner_erase(ads_btree_inner_t* inner, size_t index) {
+  size_t count = inner->node.count;
+  memmove(&inner->node.keys[index], &inner->node.keys[index + 1], (count - index - 1) * sizeof(void*));
+  memmove(&inner->children[index + 1], &inner->children[index + 2], (count - index - 1) * sizeof(ads_btree_node_t*));
+  inner->node.count--;
+}
+
+// append the entries of `right` to `left` and free `right`
+static void
+ads_btree_merge_leaves(const ads_btree_t* tree, ads_btree_leaf_t* left, ads_btree_leaf_t* right) {
+  memcpy(&left->node.keys[left->node.count], right->node.keys, right->node.count * sizeof(void*));
+  memcpy(&left->values[left->node.count], right->values, right->node.count * sizeof(void*));
+  left->node.count += right->node.count;
+
+  left->next = right->next;
+  if(right->next) right->next->prev = left;
+  ads_btree_release_node(tree, right);
+}
+
+// append `separator` and the keys and children of `right` to `left` and free `right`
+static void
+ads_btree_merge_inners(const ads_btree_t* tree, ads_btree_inner_t* left, void* separator, ads_btree_inner_t* right) {
+  size_t count = left->node.count;
+  left->node.keys[count] = separator;
+  memcpy(&left->node.keys[count + 1], right->node.keys, right->node.count * sizeof(void*));
+  memcpy(&left->children[count + 1], right->children, (right->node.count + 1) * sizeof(ads_btree_node_t*));
+  left->node.count += right->node.count + 1;
+  ads_btree_release_node(tree, right);
+}
+
+// children[i] of `parent` is below ADS_BTREE_MIN_KEYS: borrow from a sibling or merge with it
+static void
+ads_btree_rebalance(const ads_btree_t* tree, ads_btree_inner_t* parent, size_t i) {
+  ads_btree_node_t* child = parent->children[i];
+  ads_btree_node_t* left  = i > 0 ? parent->children[i - 1] : NULL;
+  ads_btree_node_t* right = i < parent->node.count ? parent->children[i + 1] : NULL;
+
+  if(child->leaf) {
+    ads_btree_leaf_t* leaf = ads_btree_as_leaf(child);
+
+    if(left && left->count > ADS_BTREE_MIN_KEYS) {
+      ads_btree_leaf_t* from = ads_btree_as_leaf(left);
+      memmove(&child->keys[1], child->keys, child->count * sizeof(void*));
+      memmove(&leaf->values[1], leaf->values, child->count * sizeof(void*));
+      child->keys[0] = left->keys[left->count - 1];
+      leaf->values[0] = from->values[left->count - 1];
+      child->count++;
+      left->count--;
+      parent->node.keys[i - 1] = child->keys[0];
+    }
+    else if(right && right->count > ADS_BTREE_MIN_KEYS) {
+      ads_btree_leaf_t* from = ads_btree_as_leaf(right);
+      child->keys[child->count] = right->keys[0];
+      leaf->values[child->count] = from->values[0];
+      child->count++;
+      memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(void*));
+      memmove(from->values, &from->values[1], (right->count - 1) * sizeof(void*));
+      right->count--;
+      parent->node.keys[i] = right->keys[0];
+    }
+    else if(left) {
+      ads_btree_merge_leaves(tree, ads_btree_as_leaf(left), leaf);
+      ads_btree_inner_erase(parent, i - 1);
+    }
+    else {
+      ads_btree_merge_leaves(tree, leaf, ads_btree_as_leaf(right));
+      ads_btree_inner_erase(parent, i);
+    }
+    return;
+  }
+
+  ads_btree_inner_t* inner = ads_btree_as_inner(child);
+
+  // borrowing rotates through the parent: its separator moves down, the sibling's key moves up
+  if(left && left->count > ADS_BTREE_MIN_KEYS) {
+    ads_btree_inner_t* from = ads_btree_as_inner(left);
+    memmove(&child->keys[1], child->keys, child->count * sizeof(void*));
+    memmove(&inner->children[1], inner->children, (child->count + 1) * sizeof(ads_btree_node_t*));
+    child->keys[0] = parent->node.keys[i - 1];
+    inner->children[0] = from->children[left->count];
+    child->count++;
+    parent->node.keys[i - 1] = left->keys[left->count - 1];
+    left->count--;
+  }
+  else if(right && right->count > ADS_BTREE_MIN_KEYS) {
+    ads_btree_inner_t* from = ads_btree_as_inner(right);
+    child->keys[child->count] = parent->node.keys[i];
+    inner->children[child->count + 1] = from->children[0];
+    child->count++;
+    parent->node.keys[i] = right->keys[0];
+    memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(void*));
+    memmove(from->children, &from->children[1], right->count * sizeof(ads_btree_node_t*));
+    right->count--;
+  }
+  else if(left) {
+    ads_btree_merge_inners(tree, ads_btree_as_inner(left), parent->node.keys[i - 1], inner);
+    ads_btree_inner_erase(parent, i - 1);
+  }
+  else {
+    ads_btree_merge_inners(tree, inner, parent->node.keys[i], ads_btree_as_inner(right));
+    ads_btree_inner_erase(parent, i);
+  }
+}
+
+/*
+  the removed key may also be a separator in the inner nodes on its path (it was the smallest
+  key of their right subtree). The caller may free the key as soon as it's removed, so each of
+  those separators is replaced by the new smallest key of its subtree, found by pointer.
+*/
+static ads_status_t
+ads_btree_remove_node(ads_btree_t* tree, ads_btree_node_t* node, void* key, void** removed_key, void** out) {
+  if(node->leaf) {
+    ads_btree_leaf_t* leaf = ads_btree_as_leaf(node);
+    size_t pos = ads_btree_search(tree, node, key, 0);
+    if(pos == node->count || tree->compare(node->keys[pos], key) != 0)
+      return ADS_NOTFOUND;
+
+    *removed_key = node->keys[pos];
+    if(out)
+      *out = leaf->values[pos];
+    else if(tree->destroy)
+      tree->destroy(leaf->values[pos]);
+
+    memmove(&node->keys[pos], &node->keys[pos + 1], (node->count - pos - 1) * sizeof(void*));
+    memmove(&leaf->values[pos], &leaf->values[pos + 1], (node->count - pos - 1) * sizeof(void*));
+    node->count--;
+    tree->size--;
+
+    return ADS_SUCCESS;
+  }
+
+  ads_btree_inner_t* inner = ads_btree_as_inner(node);
+  size_t i = ads_btree_child_index(tree, node, key);
+
+  ads_status_t status = ads_btree_remove_node(tree, inner->children[i], key, removed_key, out);
+  if(status != ADS_SUCCESS)
+    return status;
+
+  for(size_t j = 0; j < node->count; j++) {
+    if(node->keys[j] == *removed_key)
+      node->keys[j] = ads_btree_min_key(inner->children[j + 1]);
+  }
+
+  if(inner->children[i]->count < ADS_BTREE_MIN_KEYS)
+    ads_btree_rebalance(tree, inner, i);
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_btree_remove(ads_btree_t* tree, void* key, void** out) {
+  void* removed_key = NULL;
+
+  ads_status_t status = ads_btree_remove_node(tree, tree->root, key, &removed_key, out);
+  if(status != ADS_SUCCESS)
+    return status;
+
+  // the root lost its last separator, its only child becomes the root
+  if(!tree->root->leaf && tree->root->count == 0) {
+    ads_btree_node_t* root = tree->root;
+    tree->root = ads_btree_as_inner(root)->children[0];
+    ads_btree_release_node(tree, root);
+  }
+
+  return ADS_SUCCESS;
+}
+
+/* ----- LOOKUP ----- */
+
+ads_status_t ads_btree_get(const ads_btree_t* tree, void* key, void** out) {
+  ads_btree_leaf_t* leaf = ads_btree_find_leaf(tree, key);
+
+  size_t pos = ads_btree_search(tree, &leaf->node, key, 0);
+  if(pos == leaf->node.count || tree->compare(leaf->node.keys[pos], key) != 0)
+    return ADS_NOTFOUND;
+
+  if(out) *out = leaf->values[pos];
+  return ADS_SUCCESS;
+}
+
+// a position past the last entry of a leaf moves to the start of the next one
+static void
+ads_btree_cursor_fix(ads_btree_cursor_t* cursor) {
+  while(cursor->leaf && cursor->index >= cursor->leaf->node.count) {
+    cursor->leaf  = cursor->leaf->next;
+    cursor->index = 0;
+  }
+}
+
+void ads_btree_first(const ads_btree_t* tree, ads_btree_cursor_t* cursor) {
+  ads_btree_node_t* node = tree->root;
+  while(!node->leaf)
+    node = ads_btree_as_inner(node)->children[0];
+
+  cursor->leaf  = ads_btree_as_leaf(node);
+  cursor->index = 0;
+  ads_btree_cursor_fix(cursor);
+}
+
+void ads_btree_lower_bound(const ads_btree_t* tree, void* key, ads_btree_cursor_t* cursor) {
+  cursor->leaf  = ads_btree_find_leaf(tree, key);
+  cursor->index = ads_btree_search(tree, &cursor->leaf->node, key, 0);
+  ads_btree_cursor_fix(cursor);
+}
+
+void ads_btree_upper_bound(const ads_btree_t* tree, void* key, ads_btree_cursor_t* cursor) {
+  cursor->leaf  = ads_btree_find_leaf(tree, key);
+  cursor->index = ads_btree_search(tree, &cursor->leaf->node, key, 1);
+  ads_btree_cursor_fix(cursor);
+}
+
+void ads_btree_cursor_next(ads_btree_cursor_t* cursor) {
+  cursor->index++;
+  ads_btree_cursor_fix(cursor);
+}
+
+void ads_btree_range(const ads_btree_t* tree, void* from, void* to, ads_btree_range_t* range) {
+  if(from)
+    ads_btree_lower_bound(tree, from, &range->begin);
+  else
+    ads_btree_first(tree, &range->begin);
+
+  if(to)
+    ads_btree_lower_bound(tree, to, &range->end);
+  else
+    range->end.leaf = NULL, range->end.index = 0;
+
+  // an empty or reversed interval
+  if(from && to && tree->compare(from, to) >= 0)
+    range->begin = range->end;
+
+  range->cursor = range->begin;
+}
+
+/* ----- BULK LOADING ----- */
+
+/*
+  the leaves are filled left to right with the sorted entries, then each level of inner nodes
+  is built over the one below, until a single node is left. The nodes of a level share the
+  entries (or children) evenly, so none is below the minimum and no split ever happens.
+*/
+
+// number of nodes for `count` items, at most `max` per node
+#define ads_btree_nodes_for(count, max) (((count) + (max) - 1) / (max))
+
+ads_status_t ads_btree_bulk_load(ads_btree_t* tree, void** keys, void** values, size_t count) {
+  if(tree->size != 0)
+    return ADS_INVALID;
+
+  for(size_t i = 1; i < count; i++) {
+    if(tree->compare(keys[i - 1], keys[i]) >= 0)
+      return ADS_INVALID;
+  }
+
+  if(count == 0)
+    return ADS_SUCCESS;
+
+  size_t n = ads_btree_nodes_for(count, ADS_BTREE_NODE_KEYS);
+  // scratch arrays, freed before returning: they stay on malloc, only the nodes use the allocator
+  ads_btree_node_t** level = malloc(n * sizeof(ads_btree_node_t*));
+  void** mins = malloc(n * sizeof(void*)); // smallest key of each node of the level
+  if(!level || !mins) {
+    free(level);
+    free(mins);
+    return ADS_NOMEM;
+  }
+
+  size_t built = 0, next = 0;
+  ads_btree_leaf_t* prev = NULL;
+  for(; built < n; built++) {
+    ads_btree_leaf_t* leaf = ads_btree_new_leaf(tree);
+    if(!leaf)
+      goto fail;
+
+    size_t take = (count - next) / (n - built);
+    memcpy(leaf->node.keys, &keys[next], take * sizeof(void*));
+    memcpy(leaf->values, &values[next], take * sizeof(void*));
+    leaf->node.count = take;
+    next += take;
+
+    leaf->prev = prev;
+    if(prev) prev->next = leaf;
+    prev = leaf;
+
+    level[built] = (ads_btree_node_t*) leaf;
+    mins[built]  = leaf->node.keys[0];
+  }
+
+  while(n > 1) {
+    size_t parents = ads_btree_nodes_for(n, ADS_BTREE_NODE_KEYS + 1);
+
+    next = 0;
+    for(built = 0; built < parents; built++) {
+      ads_btree_inner_t* inner = ads_btree_new_inner(tree);
+      if(!inner) {
+        // level[0, built) are the new parents, owning the nodes before level[next]
+        memmove(&level[built], &level[next], (n - next) * sizeof(ads_btree_node_t*));
+        built += n - next;
+        goto fail;
+      }
+
+      size_t take = (n - next) / (parents - built);
+      memcpy(inner->children, &level[next], take * sizeof(ads_btree_node_t*));
+      memcpy(inner->node.keys, &mins[next + 1], (take - 1) * sizeof(void*));
+      inner->node.count = take - 1;
+
+      // `level` and `mins` are rewritten in place, slot `built` was already read
+      void* min = mins[next];
+      next += take;
+      level[built] = (ads_btree_node_t*) inner;
+      mins[built]  = min;
+    }
+
+    n = parents;
+  }
+
+  ads_btree_free_node(tree, tree->root, NULL);
+  tree->root = level[0];
+  tree->size = count;
+
+  free(level);
+  free(mins);
+  return ADS_SUCCESS;
+
+fail:
+  for(size_t i = 0; i < built; i++)
+    ads_btree_free_node(tree, level[i], NULL);
+  free(level);
+  free(mins);
+  return ADS_NOMEM;
+}
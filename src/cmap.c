@@ -0,0 +1,183 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/cmap.h"
+
+static inline size_t
+ads_cmap_round_pow2(size_t n) {
+  size_t pow2 = 1;
+  while(pow2 < n)
+    pow2 <<= 1;
+  return pow2;
+}
+
+// the key is hashed once, the same hash picks the stripe and is passed to ads_map_*_hashed
+#define ads_cmap_hash(map, key) ((map)->stripes[0].map.hash((key)))
+
+// stripes are picked with the high bits of the hash, the buckets of each stripe use the low ones
+static inline ads_cmap_stripe_t*
+ads_cmap_get_stripe(ads_cmap_t* map, size_t hash) {
+  hash *= 0x9e3779b97f4a7c15;
+  return &map->stripes[(hash >> 32) & (map->n_stripes - 1)];
+}
+
+// destroy the first `n` stripes, which are fully initialized, and free the array
+static void
+ads_cmap_destroy_stripes(ads_cmap_t* map, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+    ads_map_destroy(&map->stripes[i].map);
+    pthread_rwlock_destroy(&map->stripes[i].lock);
+  }
+
+  ads_free(map->allocator, map->stripes, map->n_stripes * sizeof(ads_cmap_stripe_t));
+}
+
+ads_status_t
+ads_cmap_init(ads_cmap_t* map,
+              size_t stripes,
+              size_t buckets,
+              void   (*destroy)(void* value),
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key))
+{
+  return ads_cmap_init_allocator(map, stripes, buckets, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_cmap_init_allocator(ads_cmap_t* map,
+                        size_t stripes,
+                        size_t buckets,
+                        const ads_allocator_t* allocator,
+                        void   (*destroy)(void* value),
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key))
+{
+  stripes = ads_cmap_round_pow2(stripes);
+
+  map->allocator = allocator ? allocator : ads_allocator_get_default();
+  map->n_stripes = stripes; // the size of the array, for ads_cmap_destroy_stripes
+  map->stripes   = ads_alloc_aligned(map->allocator, stripes * sizeof(ads_cmap_stripe_t),
+                                     ADS_CMAP_CACHE_LINE);
+  if(!map->stripes)
+    return ADS_NOMEM;
+
+  // `buckets` is for the whole map, split among the stripes
+  size_t stripe_buckets = buckets / stripes;
+
+  for(size_t i = 0; i < stripes; i++) {
+    ads_map_t* stripe = &map->stripes[i].map;
+    if(ads_map_init_allocator(stripe, stripe_buckets, 0, map->allocator, destroy, compare, hash) != ADS_SUCCESS) {
+      ads_cmap_destroy_stripes(map, i);
+      return ADS_NOMEM;
+    }
+
+    if(pthread_rwlock_init(&map->stripes[i].lock, NULL) != 0) {
+      ads_map_destroy(&map->stripes[i].map);
+      ads_cmap_destroy_stripes(map, i);
+      return ADS_NOMEM;
+    }
+  }
+
+  return ADS_SUCCESS;
+}
+
+void ads_cmap_destroy(ads_cmap_t* map) {
+  ads_cmap_destroy_stripes(map, map->n_stripes);
+  memset(map, 0, sizeof(ads_cmap_t));
+}
+
+size_t ads_cmap_get_size(ads_cmap_t* map) {
+  size_t size = 0;
+
+  for(size_t i = 0; i < map->n_stripes; i++) {
+    pthread_rwlock_rdlock(&map->stripes[i].lock);
+    size += ads_map_get_size(&map->stripes[i].map);
+    pthread_rwlock_unlock(&map->stripes[i].lock);
+  }
+
+  return size;
+}
+
+ads_status_t ads_cmap_insert(ads_cmap_t* map, void* key, void* value) {
+  size_t hash = ads_cmap_hash(map, key);
+  ads_cmap_stripe_t* stripe = ads_cmap_get_stripe(map, hash);
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  ads_status_t status = ads_map_insert_hashed(&stripe->map, key, value, hash);
+  pthread_rwlock_unlock(&stripe->lock);
+
+  return status;
+}
+
+ads_status_t ads_cmap_remove(ads_cmap_t* map, void* key, void** out) {
+  size_t hash = ads_cmap_hash(map, key);
+  ads_cmap_stripe_t* stripe = ads_cmap_get_stripe(map, hash);
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  ads_status_t status = ads_map_remove_hashed(&stripe->map, key, hash, out);
+  pthread_rwlock_unlock(&stripe->lock);
+
+  return status;
+}
+
+ads_status_t ads_cmap_get(ads_cmap_t* map, void* key, void** out) {
+  size_t hash = ads_cmap_hash(map, key);
+  ads_cmap_stripe_t* stripe = ads_cmap_get_stripe(map, hash);
+
+  // ads_map_lookup_hashed doesn't move buckets of an ongoing rehash, so a shared lock is enough
+  pthread_rwlock_rdlock(&stripe->lock);
+  ads_map_entry_t* entry = ads_map_lookup_hashed(&stripe->map, key, hash, out);
+  pthread_rwlock_unlock(&stripe->lock);
+
+  return entry ? ADS_SUCCESS : ADS_NOTFOUND;
+}
+
+ads_status_t ads_cmap_get_or_insert(ads_cmap_t* map, void* key, void* value, void** out) {
+  size_t hash = ads_cmap_hash(map, key);
+  ads_cmap_stripe_t* stripe = ads_cmap_get_stripe(map, hash);
+  ads_status_t status = ADS_SUCCESS;
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  if(!ads_map_get_hashed(&stripe->map, key, hash, out)) {
+    status = ads_map_insert_hashed(&stripe->map, key, value, hash);
+    if(status == ADS_SUCCESS && out)
+      *out = value;
+  }
+  pthread_rwlock_unlock(&stripe->lock);
+
+  return status;
+}
+
+ads_status_t
+ads_cmap_compute_if_absent(ads_cmap_t*        map,
+                           void*              key,
+                           ads_cmap_compute_f compute,
+                           void*              arg,
+                           void**             out)
+{
+  size_t hash = ads_cmap_hash(map, key);
+  ads_cmap_stripe_t* stripe = ads_cmap_get_stripe(map, hash);
+  ads_status_t status = ADS_SUCCESS;
+
+  // most calls find the key, so try first with a shared lock
+  pthread_rwlock_rdlock(&stripe->lock);
+  ads_map_entry_t* entry = ads_map_lookup_hashed(&stripe->map, key, hash, out);
+  pthread_rwlock_unlock(&stripe->lock);
+  if(entry)
+    return ADS_SUCCESS;
+
+  // another thread may have inserted the key in between, so look again under the write lock
+  pthread_rwlock_wrlock(&stripe->lock);
+  if(!ads_map_get_hashed(&stripe->map, key, hash, out)) {
+    void* value = compute(key, arg);
+    if(value == NULL)
+      status = ADS_NOTFOUND;
+    else {
+      status = ads_map_insert_hashed(&stripe->map, key, value, hash);
+      if(status == ADS_SUCCESS && out)
+        *out = value;
+    }
+  }
+  pthread_rwlock_unlock(&stripe->lock);
+
+  return status;
+}
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <memory.h>
+#include "../include/deque.h"
+
+ads_status_t
+ads_deque_init(ads_deque_t*         deque,
+               size_t               data_size,
+               ads_vector_copy_f    copy,
+               ads_vector_destroy_f destroy)
+{
+  return ads_deque_init_allocator(deque, data_size, NULL, copy, destroy);
+}
+
+ads_status_t
+ads_deque_init_allocator(ads_deque_t*           deque,
+                         size_t                 data_size,
+                         const ads_allocator_t* allocator,
+                         ads_vector_copy_f      copy,
+                         ads_vector_destroy_f   destroy)
+{
+  deque->allocator = allocator ? allocator : ads_allocator_get_default();
+
+  deque->buf = ads_calloc(deque->allocator, ADS_DEQUE_PRE_ALLOCATE, data_size);
+  if(deque->buf == NULL)
+    return ADS_NOMEM;
+
+  deque->data_size = data_size;
+  deque->size      = 0;
+  deque->capacity  = ADS_DEQUE_PRE_ALLOCATE;
+  deque->head      = 0;
+
+  deque->copy    = copy ? copy : memcpy;
+  deque->destroy = destroy;
+
+  return ADS_SUCCESS;
+}
+
+void ads_deque_clear(ads_deque_t* deque) {
+  if(deque->destroy) {
+    for(size_t i = 0; i < deque->size; i++)
+      deque->destroy(ads_deque_get_idx_address(deque, i));
+  }
+
+  deque->size = 0;
+  deque->head = 0;
+}
+
+void ads_deque_destroy(ads_deque_t* deque) {
+  ads_deque_clear(deque);
+  ads_free(deque->allocator, deque->buf, deque->capacity * deque->data_size);
+  deque->buf = NULL;
+  deque->capacity = 0;
+}
+
+/*
+  the buffer is reallocated to `capacity` slots (a power of two). If the elements wrapped
+  around the old end, the wrapped part [0, head + size - old capacity) is moved right after
+  the old end, where the new buffer continues them
+*/
+static ads_status_t
+ads_deque_set_capacity(ads_deque_t* deque, size_t capacity) {
+  size_t old = deque->capacity;
+
+  void* buf = ads_realloc(deque->allocator, deque->buf, old * deque->data_size, capacity * deque->data_size);
+  if(buf == NULL)
+    return ADS_NOMEM;
+
+  deque->buf = buf;
+  deque->capacity = capacity;
+
+  if(deque->head + deque->size > old) {
+    size_t wrapped = deque->head + deque->size - old;
+    memcpy((char*) buf + old * deque->data_size, buf, wrapped * deque->data_size);
+  }
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_deque_reserve(ads_deque_t* deque, size_t capacity) {
+  if(capacity <= deque->capacity)
+    return ADS_SUCCESS;
+
+  size_t pow2 = deque->capacity;
+  while(pow2 < capacity)
+    pow2 <<= 1;
+
+  return ads_deque_set_capacity(deque, pow2);
+}
+
+static inline ads_status_t
+ads_deque_grow_if_full(ads_deque_t* deque) {
+  if(!ads_deque_is_full(deque))
+    return ADS_SUCCESS;
+
+  return ads_deque_set_capacity(deque, deque->capacity * 2);
+}
+
+ads_status_t ads_deque_push_back(ads_deque_t* deque, void* data) {
+  if(ads_deque_grow_if_full(deque) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  deque->copy(ads_deque_get_idx_address(deque, deque->size), data, deque->data_size);
+  deque->size++;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_deque_push_front(ads_deque_t* deque, void* data) {
+  if(ads_deque_grow_if_full(deque) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  deque->copy(ads_deque_get_idx_address(deque, 0), data, deque->data_size);
+  deque->size++;
+
+  return ADS_SUCCESS;
+}
+
+// hand the element at `slot` to the caller, or destroy it
+static inline void
+ads_deque_take(ads_deque_t* deque, void* slot, void* out) {
+  if(out)
+    memcpy(out, slot, deque->data_size);
+  else if(deque->destroy)
+    deque->destroy(slot);
+}
+
+ads_status_t ads_deque_pop_back(ads_deque_t* deque, void* out) {
+  if(ads_deque_is_empty(deque))
+    return ADS_NOTFOUND;
+
+  deque->size--;
+  ads_deque_take(deque, ads_deque_get_idx_address(deque, deque->size), out);
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_deque_pop_front(ads_deque_t* deque, void* out) {
+  if(ads_deque_is_empty(deque))
+    return ADS_NOTFOUND;
+
+  ads_deque_take(deque, ads_deque_get_idx_address(deque, 0), out);
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->size--;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_deque_get_at(ads_deque_t* deque, ssize_t index, void** out) {
+  if(index < 0 || (size_t) index >= deque->size)
+    return ADS_OUTOFBOUNDS;
+
+  if(out)
+    *out = ads_deque_get_idx_address(deque, index);
+
+  return ADS_SUCCESS;
+}
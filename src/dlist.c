@@ -3,10 +3,15 @@
 #include <memory.h>
 
 void ads_dlist_init(ads_dlist_t* dlist, void (*destroy)(void*)) {
-  dlist->destroy = destroy;
-  dlist->head    = NULL;
-  dlist->tail    = NULL;
-  dlist->size    = 0;
+  ads_dlist_init_allocator(dlist, destroy, NULL);
+}
+
+void ads_dlist_init_allocator(ads_dlist_t* dlist, void (*destroy)(void*), const ads_allocator_t* allocator) {
+  dlist->destroy   = destroy;
+  dlist->head      = NULL;
+  dlist->tail      = NULL;
+  dlist->size      = 0;
+  dlist->allocator = allocator ? allocator : ads_allocator_get_default();
 }
 
 void ads_dlist_clean(ads_dlist_t* list) {
@@ -15,9 +20,7 @@ void ads_dlist_clean(ads_dlist_t* list) {
 }
 
 void ads_dlist_destroy(ads_dlist_t* list) {
-  if(list->destroy == NULL)
-    ads_dlist_clean(list);
-  else {
+  if(list->destroy) {
     void* data = NULL;
 
     while(!ads_dlist_is_empty(list)) {
@@ -25,13 +28,16 @@ void ads_dlist_destroy(ads_dlist_t* list) {
       list->destroy(data);
     }
   }
+  // an allocator without free (e.g. an arena) releases the nodes by itself
+  else if(ads_allocator_frees(list->allocator))
+    ads_dlist_clean(list);
 
   memset(list, 0, sizeof(ads_dlist_t));
 }
 
 static inline 
-ads_dlist_node_t* ads_dlist_new_node(void* data) {
-  ads_dlist_node_t* new_node = malloc(sizeof(ads_dlist_node_t));
+ads_dlist_node_t* ads_dlist_new_node(ads_dlist_t* dlist, void* data) {
+  ads_dlist_node_t* new_node = ads_alloc(dlist->allocator, sizeof(ads_dlist_node_t));
   if(new_node) {
     new_node->data = data;
     new_node->next = NULL;
@@ -42,7 +48,7 @@ ads_dlist_node_t* ads_dlist_new_node(void* data) {
 }
 
 ads_status_t ads_dlist_push_front(ads_dlist_t* dlist, void* data) {
-  ads_dlist_node_t* new_node = ads_dlist_new_node(data);
+  ads_dlist_node_t* new_node = ads_dlist_new_node(dlist, data);
   if(new_node == NULL)
     return ADS_NOMEM;
 
@@ -62,7 +68,7 @@ ads_status_t ads_dlist_push_front(ads_dlist_t* dlist, void* data) {
 }
 
 ads_status_t ads_dlist_push_back(ads_dlist_t* dlist, void* data) {
-  ads_dlist_node_t* new_node = ads_dlist_new_node(data);
+  ads_dlist_node_t* new_node = ads_dlist_new_node(dlist, data);
   if(new_node == NULL)
     return ADS_NOMEM;
   
@@ -91,7 +97,7 @@ ads_dlist_add_next(ads_dlist_t* dlist,
   else if(node == ads_dlist_get_tail(dlist))
     return ads_dlist_push_back(dlist, data);
 
-  ads_dlist_node_t* new_node = ads_dlist_new_node(data);
+  ads_dlist_node_t* new_node = ads_dlist_new_node(dlist, data);
   if(new_node == NULL)
     return ADS_NOMEM;
 
@@ -114,7 +120,7 @@ ads_dlist_add_prev(ads_dlist_t* dlist,
   if(node == ads_dlist_get_head(dlist) || node == NULL)
     return ads_dlist_push_front(dlist, data);
 
-  ads_dlist_node_t* new_node = ads_dlist_new_node(data);
+  ads_dlist_node_t* new_node = ads_dlist_new_node(dlist, data);
   if(new_node == NULL)
     return ADS_NOMEM;
 
@@ -142,7 +148,7 @@ void ads_dlist_pop_front(ads_dlist_t* dlist, void** ret_data) {
   dlist->head = old_head->next;
 
   dlist->size--;
-  free(old_head);
+  ads_free(dlist->allocator, old_head, sizeof(ads_dlist_node_t));
 
   if(ads_dlist_is_empty(dlist))
     dlist->tail = NULL;
@@ -163,7 +169,7 @@ void ads_dlist_pop_back(ads_dlist_t* dlist, void** ret_data) {
   dlist->tail = old_tail->prev;
 
   dlist->size--;
-  free(old_tail);
+  ads_free(dlist->allocator, old_tail, sizeof(ads_dlist_node_t));
 
   if(ads_dlist_is_empty(dlist))
     dlist->head = NULL;
@@ -192,7 +198,7 @@ void ads_dlist_remove_next(ads_dlist_t* dlist,
       node->next->prev = node;
 
     dlist->size--;
-    free(rem_node);
+    ads_free(dlist->allocator, rem_node, sizeof(ads_dlist_node_t));
   }
 }
 
@@ -222,4 +228,43 @@ ads_dlist_node_t* ads_dlist_get_at(ads_dlist_t* dlist, ssize_t index) {
     return ads_dlist_look_backward(dlist->tail, (dlist_size - 1) - index);
   else
     return ads_dlist_look_forward(dlist->head, index);
+}
+
+// detach `node` from `dlist`; the node isn't freed and can be linked into another list
+void ads_dlist_unlink(ads_dlist_t* dlist, ads_dlist_node_t* node) {
+  if(node->prev)
+    node->prev->next = node->next;
+  else
+    dlist->head = node->next;
+
+  if(node->next)
+    node->next->prev = node->prev;
+  else
+    dlist->tail = node->prev;
+
+  node->next = NULL;
+  node->prev = NULL;
+  dlist->size--;
+}
+
+// link an already allocated (and detached) node at the head of `dlist`
+void ads_dlist_link_front(ads_dlist_t* dlist, ads_dlist_node_t* node) {
+  node->prev = NULL;
+  node->next = dlist->head;
+
+  if(ads_dlist_is_empty(dlist))
+    dlist->tail = node;
+  else
+    dlist->head->prev = node;
+
+  dlist->head = node;
+  dlist->size++;
+}
+
+void ads_dlist_move_to_front(ads_dlist_t* dlist, ads_dlist_node_t* node) {
+  if(node == dlist->head)
+    return;
+
+  ads_dlist_unlink(dlist, node);
+  ads_dlist_link_front(dlist, node);
 }
\ No newline at end of file
@@ -4,7 +4,10 @@ static const char*
 ads_status_description[] = {
   "success",                // ADS_SUCCESS
   "cannot allocate memory", // ADS_NOMEM
-  "index out of bounds"     // ADS_OUTOFBOUNDS
+  "index out of bounds",    // ADS_OUTOFBOUNDS
+  "not found",              // ADS_NOTFOUND
+  "invalid argument",       // ADS_INVALID
+  "input/output error"      // ADS_IOERROR
 };
 
 const char* ads_status_message(ads_status_t status) {
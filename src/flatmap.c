@@ -0,0 +1,321 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/flatmap.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+  control bytes:
+    EMPTY   (0x80) - slot never used since the last rehash, stops a probe
+    DELETED (0xfe) - tombstone left by ads_flatmap_remove, a probe goes past it
+    0..127         - slot in use, the value is the 7-bit tag (h2) of the key's hash
+
+  The first GROUP_WIDTH control bytes are cloned after the last one, so a group that starts
+  near the end of the table can be loaded without wrapping around.
+*/
+
+#define ADS_FLATMAP_EMPTY   ((int8_t) -128)
+#define ADS_FLATMAP_DELETED ((int8_t) -2)
+
+#define ADS_FLATMAP_MIN_CAPACITY ADS_FLATMAP_GROUP_WIDTH
+
+// the table is rehashed when it would be more than 7/8 full
+#define ads_flatmap_max_load(capacity) ((capacity) - (capacity) / 8)
+
+#define ads_flatmap_is_full(ctrl) ((ctrl) >= 0)
+
+typedef uint32_t ads_flatmap_mask_t; // bit i is set when the i-th byte of a group matches
+
+/* ----- GROUP SCANNING ----- */
+
+#ifdef __SSE2__
+
+static inline ads_flatmap_mask_t
+ads_flatmap_match(const int8_t* group, int8_t h2) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+}
+
+// EMPTY and DELETED are the only control bytes with the sign bit set
+static inline ads_flatmap_mask_t
+ads_flatmap_match_empty_or_deleted(const int8_t* group) {
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+}
+
+#else
+
+static inline ads_flatmap_mask_t
+ads_flatmap_match(const int8_t* group, int8_t h2) {
+  ads_flatmap_mask_t mask = 0;
+  for(int i = 0; i < ADS_FLATMAP_GROUP_WIDTH; i++)
+    mask |= (ads_flatmap_mask_t) (group[i] == h2) << i;
+  return mask;
+}
+
+static inline ads_flatmap_mask_t
+ads_flatmap_match_empty_or_deleted(const int8_t* group) {
+  ads_flatmap_mask_t mask = 0;
+  for(int i = 0; i < ADS_FLATMAP_GROUP_WIDTH; i++)
+    mask |= (ads_flatmap_mask_t) (group[i] < 0) << i;
+  return mask;
+}
+
+#endif
+
+#define ads_flatmap_match_empty(group) ads_flatmap_match((group), ADS_FLATMAP_EMPTY)
+
+/* ----- HASHING AND PROBING ----- */
+
+// spread the user's hash so that both h1 (position) and h2 (tag) get good bits
+static inline size_t
+ads_flatmap_mix(size_t hash) {
+  hash *= 0x9e3779b97f4a7c15;
+  return hash ^ (hash >> 32);
+}
+
+#define ads_flatmap_h1(hash) ((hash) >> 7)
+#define ads_flatmap_h2(hash) ((int8_t) ((hash) & 0x7f))
+
+// set a control byte and its clone (if it is one of the first GROUP_WIDTH bytes)
+static inline void
+ads_flatmap_set_ctrl(ads_flatmap_t* map, size_t index, int8_t value) {
+  size_t mask = map->capacity - 1;
+
+  map->ctrl[index] = value;
+  map->ctrl[((index - ADS_FLATMAP_GROUP_WIDTH) & mask) + ADS_FLATMAP_GROUP_WIDTH] = value;
+}
+
+// first EMPTY or DELETED slot in the probe sequence of `hash`
+static size_t
+ads_flatmap_find_free_slot(ads_flatmap_t* map, size_t hash) {
+  size_t mask = map->capacity - 1;
+  size_t pos = ads_flatmap_h1(hash) & mask;
+
+  // triangular probing over groups, visits every group when capacity is a power of two
+  for(size_t stride = ADS_FLATMAP_GROUP_WIDTH; ; stride += ADS_FLATMAP_GROUP_WIDTH) {
+    ads_flatmap_mask_t free_slots = ads_flatmap_match_empty_or_deleted(&map->ctrl[pos]);
+    if(free_slots)
+      return (pos + __builtin_ctz(free_slots)) & mask;
+
+    pos = (pos + stride) & mask;
+  }
+}
+
+// index of the slot holding `key`, or map->capacity if the key isn't in the map
+static size_t
+ads_flatmap_find(ads_flatmap_t* map, void* key, size_t hash) {
+  size_t mask = map->capacity - 1;
+  size_t pos = ads_flatmap_h1(hash) & mask;
+  int8_t h2 = ads_flatmap_h2(hash);
+
+  for(size_t stride = ADS_FLATMAP_GROUP_WIDTH; ; stride += ADS_FLATMAP_GROUP_WIDTH) {
+    const int8_t* group = &map->ctrl[pos];
+
+    // only slots with the same tag are compared
+    ads_flatmap_mask_t match = ads_flatmap_match(group, h2);
+    while(match) {
+      size_t index = (pos + __builtin_ctz(match)) & mask;
+      if(map->compare(key, map->slots[index].key))
+        return index;
+      match &= match - 1;
+    }
+
+    // an EMPTY slot means the key was never pushed further along the probe sequence
+    if(ads_flatmap_match_empty(group))
+      return map->capacity;
+
+    pos = (pos + stride) & mask;
+  }
+}
+
+/* ----- TABLE ALLOCATION ----- */
+
+#define ads_flatmap_table_size(capacity) \
+  ((capacity) * sizeof(ads_flatmap_entry_t) + (capacity) + ADS_FLATMAP_GROUP_WIDTH)
+
+// slots and control bytes share a single allocation, with every control byte set to EMPTY
+static ads_status_t
+ads_flatmap_alloc_table(ads_flatmap_t* map, size_t capacity) {
+  size_t slots_size = capacity * sizeof(ads_flatmap_entry_t);
+
+  char* table = ads_alloc(map->allocator, ads_flatmap_table_size(capacity));
+  if(!table)
+    return ADS_NOMEM;
+
+  map->slots = (ads_flatmap_entry_t*) table;
+  map->ctrl  = (int8_t*) (table + slots_size);
+  memset(map->ctrl, (uint8_t) ADS_FLATMAP_EMPTY, capacity + ADS_FLATMAP_GROUP_WIDTH);
+
+  map->capacity    = capacity;
+  map->growth_left = ads_flatmap_max_load(capacity) - map->size;
+
+  return ADS_SUCCESS;
+}
+
+// move every entry to a new table; tombstones are dropped on the way
+static ads_status_t
+ads_flatmap_rehash(ads_flatmap_t* map, size_t capacity) {
+  int8_t* old_ctrl = map->ctrl;
+  ads_flatmap_entry_t* old_slots = map->slots;
+  size_t old_capacity = map->capacity;
+
+  if(ads_flatmap_alloc_table(map, capacity) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  for(size_t i = 0; i < old_capacity; i++) {
+    if(!ads_flatmap_is_full(old_ctrl[i]))
+      continue;
+
+    size_t hash = ads_flatmap_mix(map->hash(old_slots[i].key));
+    size_t index = ads_flatmap_find_free_slot(map, hash);
+
+    ads_flatmap_set_ctrl(map, index, ads_flatmap_h2(hash));
+    map->slots[index] = old_slots[i];
+  }
+
+  ads_free(map->allocator, old_slots, ads_flatmap_table_size(old_capacity));
+
+  return ADS_SUCCESS;
+}
+
+static inline size_t
+ads_flatmap_round_capacity(size_t capacity) {
+  size_t pow2 = ADS_FLATMAP_MIN_CAPACITY;
+  while(pow2 < capacity)
+    pow2 <<= 1;
+  return pow2;
+}
+
+/* ---------- */
+
+ads_status_t
+ads_flatmap_init(ads_flatmap_t* map,
+                 size_t capacity,
+                 void   (*destroy)(void* value),
+                 int    (*compare)(void* key1, void* key2),
+                 size_t (*hash)(void* key))
+{
+  return ads_flatmap_init_allocator(map, capacity, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_flatmap_init_allocator(ads_flatmap_t* map,
+                           size_t capacity,
+                           const ads_allocator_t* allocator,
+                           void   (*destroy)(void* value),
+                           int    (*compare)(void* key1, void* key2),
+                           size_t (*hash)(void* key))
+{
+  map->allocator = allocator ? allocator : ads_allocator_get_default();
+  map->size    = 0;
+  map->destroy = destroy;
+  map->compare = compare;
+  map->hash    = hash;
+
+  return ads_flatmap_alloc_table(map, ads_flatmap_round_capacity(capacity));
+}
+
+void ads_flatmap_destroy(ads_flatmap_t* map) {
+  if(map->destroy) {
+    for(size_t i = 0; i < map->capacity && map->size > 0; i++) {
+      if(ads_flatmap_is_full(map->ctrl[i])) {
+        map->destroy(map->slots[i].value);
+        map->size--;
+      }
+    }
+  }
+
+  ads_free(map->allocator, map->slots, ads_flatmap_table_size(map->capacity));
+  memset(map, 0, sizeof(ads_flatmap_t));
+}
+
+ads_flatmap_entry_t*
+ads_flatmap_get(ads_flatmap_t* map, void* key, void** out) {
+  size_t hash = ads_flatmap_mix(map->hash(key));
+  size_t index = ads_flatmap_find(map, key, hash);
+  if(index == map->capacity)
+    return NULL;
+
+  ads_flatmap_entry_t* entry = &map->slots[index];
+  if(out) *out = entry->value;
+
+  return entry;
+}
+
+ads_status_t
+ads_flatmap_insert(ads_flatmap_t* map,
+                   void*          key,
+                   void*          value)
+{
+  size_t hash = ads_flatmap_mix(map->hash(key));
+
+  // key already exist, so we need to update with the new value, and free the old one
+  size_t index = ads_flatmap_find(map, key, hash);
+  if(index != map->capacity) {
+    if(map->destroy) map->destroy(map->slots[index].value);
+    map->slots[index].value = value;
+    return ADS_SUCCESS;
+  }
+
+  index = ads_flatmap_find_free_slot(map, hash);
+
+  // reusing a tombstone never needs a rehash, filling an EMPTY slot may
+  if(map->growth_left == 0 && map->ctrl[index] == ADS_FLATMAP_EMPTY) {
+    // lots of tombstones: rehash in place, otherwise double the table
+    size_t capacity = map->capacity;
+    if(map->size >= ads_flatmap_max_load(capacity) / 2)
+      capacity *= 2;
+
+    if(ads_flatmap_rehash(map, capacity) != ADS_SUCCESS)
+      return ADS_NOMEM;
+    index = ads_flatmap_find_free_slot(map, hash);
+  }
+
+  if(map->ctrl[index] == ADS_FLATMAP_EMPTY)
+    map->growth_left--;
+
+  ads_flatmap_set_ctrl(map, index, ads_flatmap_h2(hash));
+  map->slots[index].key   = key;
+  map->slots[index].value = value;
+  map->size++;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_flatmap_remove(ads_flatmap_t* map, void* key, void** out) {
+  size_t hash = ads_flatmap_mix(map->hash(key));
+  size_t index = ads_flatmap_find(map, key, hash);
+  if(index == map->capacity)
+    return ADS_NOTFOUND;
+
+  void* value = map->slots[index].value;
+  if(out)
+    *out = value;
+  else if(map->destroy)
+    map->destroy(value);
+
+  /* if there is an EMPTY slot within GROUP_WIDTH slots on both sides, no probe sequence
+     has ever gone past this slot without stopping, so it can become EMPTY again instead
+     of a tombstone */
+  size_t mask = map->capacity - 1;
+  size_t before = (index - ADS_FLATMAP_GROUP_WIDTH) & mask;
+
+  ads_flatmap_mask_t empty_after  = ads_flatmap_match_empty(&map->ctrl[index]);
+  ads_flatmap_mask_t empty_before = ads_flatmap_match_empty(&map->ctrl[before]);
+
+  int was_never_full = empty_before && empty_after &&
+    (size_t) (__builtin_ctz(empty_after) + __builtin_clz(empty_before) - 16) < ADS_FLATMAP_GROUP_WIDTH;
+
+  if(was_never_full) {
+    ads_flatmap_set_ctrl(map, index, ADS_FLATMAP_EMPTY);
+    map->growth_left++;
+  }
+  else
+    ads_flatmap_set_ctrl(map, index, ADS_FLATMAP_DELETED);
+
+  map->size--;
+
+  return ADS_SUCCESS;
+}
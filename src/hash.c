@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/hash.h"
+
+static size_t ads_hash_seed = 0;
+
+static const uint64_t ads_hash_secret[4] = {
+  0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47
+};
+
+/* ----- 64x64 -> 128 BITS MULTIPLICATION ----- */
+
+#ifdef __SIZEOF_INT128__
+
+__extension__ typedef unsigned __int128 ads_hash_uint128_t;
+
+static inline void
+ads_hash_mum(uint64_t* a, uint64_t* b) {
+  ads_hash_uint128_t r = (ads_hash_uint128_t) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+}
+
+#else
+
+static inline void
+ads_hash_mum(uint64_t* a, uint64_t* b) {
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+}
+
+#endif
+
+static inline uint64_t
+ads_hash_mix(uint64_t a, uint64_t b) {
+  ads_hash_mum(&a, &b);
+  return a ^ b;
+}
+
+/* ----- UNALIGNED READS ----- */
+
+static inline uint64_t ads_hash_read8(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t ads_hash_read4(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// 1 to 3 bytes
+static inline uint64_t ads_hash_read3(const uint8_t* p, size_t k) {
+  return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+/* ---------- */
+
+size_t ads_hash_bytes(const void* data, size_t size, size_t seed) {
+  const uint8_t* p = data;
+  const uint64_t* secret = ads_hash_secret;
+  uint64_t a, b;
+
+  seed ^= ads_hash_mix(seed ^ secret[0], secret[1]);
+
+  if(size <= 16) {
+    // short keys: two overlapping reads, no loop
+    if(size >= 4) {
+      a = (ads_hash_read4(p) << 32) | ads_hash_read4(p + ((size >> 3) << 2));
+      b = (ads_hash_read4(p + size - 4) << 32) | ads_hash_read4(p + size - 4 - ((size >> 3) << 2));
+    }
+    else if(size > 0) {
+      a = ads_hash_read3(p, size);
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else {
+    size_t i = size;
+
+    // long keys: three independent lanes of 16 bytes, so the multiplications can overlap
+    if(i > 48) {
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed  = ads_hash_mix(ads_hash_read8(p)      ^ secret[1], ads_hash_read8(p + 8)  ^ seed);
+        seed1 = ads_hash_mix(ads_hash_read8(p + 16) ^ secret[2], ads_hash_read8(p + 24) ^ seed1);
+        seed2 = ads_hash_mix(ads_hash_read8(p + 32) ^ secret[3], ads_hash_read8(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while(i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+
+    while(i > 16) {
+      seed = ads_hash_mix(ads_hash_read8(p) ^ secret[1], ads_hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+
+    // last 16 bytes, may overlap with the ones already read
+    a = ads_hash_read8(p + i - 16);
+    b = ads_hash_read8(p + i - 8);
+  }
+
+  a ^= secret[1];
+  b ^= seed;
+  ads_hash_mum(&a, &b);
+
+  return ads_hash_mix(a ^ secret[0] ^ size, b ^ secret[1]);
+}
+
+void ads_hash_set_seed(size_t seed) {
+  ads_hash_seed = seed;
+}
+
+size_t ads_hash_get_seed(void) {
+  return ads_hash_seed;
+}
@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/imap.h"
+
+#define ads_imap_index_of(hash, buckets) ((hash) % (buckets))
+
+static ads_status_t
+ads_imap_init_internal(ads_imap_t* map,
+                       size_t buckets,
+                       int    intrusive,
+                       const ads_allocator_t* allocator,
+                       void   (*destroy)(void* value),
+                       int    (*compare)(void* key1, void* key2),
+                       size_t (*hash)(void* key))
+{
+  if(buckets == 0)
+    buckets = 1;
+
+  map->allocator = allocator ? allocator : ads_allocator_get_default();
+  map->htable = ads_calloc(map->allocator, buckets, sizeof(ads_imap_link_t*));
+  if(!map->htable)
+    return ADS_NOMEM;
+
+  map->buckets   = buckets;
+  map->size      = 0;
+  map->intrusive = intrusive;
+  map->destroy   = destroy;
+  map->compare   = compare;
+  map->hash      = hash;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t
+ads_imap_init(ads_imap_t* map,
+              size_t buckets,
+              void   (*destroy)(void* value),
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key))
+{
+  return ads_imap_init_internal(map, buckets, 0, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_imap_init_intrusive(ads_imap_t* map,
+                        size_t buckets,
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key))
+{
+  return ads_imap_init_internal(map, buckets, 1, NULL, NULL, compare, hash);
+}
+
+ads_status_t
+ads_imap_init_allocator(ads_imap_t* map,
+                        size_t buckets,
+                        const ads_allocator_t* allocator,
+                        void   (*destroy)(void* value),
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key))
+{
+  return ads_imap_init_internal(map, buckets, 0, allocator, destroy, compare, hash);
+}
+
+ads_status_t
+ads_imap_init_intrusive_allocator(ads_imap_t* map,
+                                  size_t buckets,
+                                  const ads_allocator_t* allocator,
+                                  int    (*compare)(void* key1, void* key2),
+                                  size_t (*hash)(void* key))
+{
+  return ads_imap_init_internal(map, buckets, 1, allocator, NULL, compare, hash);
+}
+
+void ads_imap_destroy(ads_imap_t* map) {
+  /* in intrusive mode the links belong to the caller. Entries of an allocator that doesn't
+     free are only visited for `destroy` */
+  int walk = !map->intrusive && (map->destroy || ads_allocator_frees(map->allocator));
+  for(size_t i = 0; i < map->buckets && walk && map->size > 0; i++) {
+    ads_imap_link_t* link = map->htable[i];
+    while(link) {
+      ads_imap_entry_t* entry = ads_imap_container_of(link, ads_imap_entry_t, link);
+      link = link->next;
+
+      if(map->destroy)
+        map->destroy(entry->value);
+      ads_free(map->allocator, entry, sizeof(ads_imap_entry_t));
+      map->size--;
+    }
+  }
+
+  ads_free(map->allocator, map->htable, map->buckets * sizeof(ads_imap_link_t*));
+  memset(map, 0, sizeof(ads_imap_t));
+}
+
+// double the number of buckets; the cached hashes are reused, so `hash` isn't called
+static void
+ads_imap_grow(ads_imap_t* map) {
+  size_t buckets = map->buckets * 2;
+
+  ads_imap_link_t** htable = ads_calloc(map->allocator, buckets, sizeof(ads_imap_link_t*));
+  if(!htable)
+    return; // keep the current table, the chains just get longer
+
+  for(size_t i = 0; i < map->buckets; i++) {
+    ads_imap_link_t* link = map->htable[i];
+    while(link) {
+      ads_imap_link_t* next = link->next;
+      size_t index = ads_imap_index_of(link->hash, buckets);
+
+      link->next = htable[index];
+      htable[index] = link;
+      link = next;
+    }
+  }
+
+  ads_free(map->allocator, map->htable, map->buckets * sizeof(ads_imap_link_t*));
+  map->htable  = htable;
+  map->buckets = buckets;
+}
+
+// address of the pointer that points to the link holding `key` (or to the NULL ending its chain)
+static ads_imap_link_t**
+ads_imap_find_ref(ads_imap_t* map, void* key, size_t hash) {
+  ads_imap_link_t** ref = &map->htable[ads_imap_index_of(hash, map->buckets)];
+
+  while(*ref) {
+    ads_imap_link_t* link = *ref;
+    if(link->hash == hash && map->compare(key, link->key))
+      break;
+    ref = &link->next;
+  }
+
+  return ref;
+}
+
+static inline void
+ads_imap_push(ads_imap_t* map, ads_imap_link_t* link) {
+  ads_imap_link_t** head = &map->htable[ads_imap_index_of(link->hash, map->buckets)];
+
+  link->next = *head;
+  *head = link;
+  map->size++;
+
+  if(map->size > map->buckets * ADS_IMAP_MAX_LOAD_FACTOR)
+    ads_imap_grow(map);
+}
+
+/* ----- INTRUSIVE MODE ----- */
+
+ads_imap_link_t* ads_imap_link(ads_imap_t* map, ads_imap_link_t* link, void* key) {
+  link->hash = map->hash(key);
+  link->key  = key;
+
+  // replace the link that already holds `key` and give it back to the caller
+  ads_imap_link_t** ref = ads_imap_find_ref(map, key, link->hash);
+  ads_imap_link_t* old = *ref;
+  if(old) {
+    link->next = old->next;
+    *ref = link;
+    old->next = NULL;
+    return old;
+  }
+
+  ads_imap_push(map, link);
+  return NULL;
+}
+
+ads_imap_link_t* ads_imap_unlink(ads_imap_t* map, void* key) {
+  ads_imap_link_t** ref = ads_imap_find_ref(map, key, map->hash(key));
+  ads_imap_link_t* link = *ref;
+  if(link) {
+    *ref = link->next;
+    link->next = NULL;
+    map->size--;
+  }
+
+  return link;
+}
+
+ads_imap_link_t* ads_imap_find(ads_imap_t* map, void* key) {
+  return *ads_imap_find_ref(map, key, map->hash(key));
+}
+
+/* ----- MANAGED MODE ----- */
+
+ads_status_t ads_imap_insert(ads_imap_t* map, void* key, void* value) {
+  size_t hash = map->hash(key);
+
+  // key already exist, so we need to update with the new value, and free the old one
+  ads_imap_link_t* link = *ads_imap_find_ref(map, key, hash);
+  if(link) {
+    ads_imap_entry_t* entry = ads_imap_container_of(link, ads_imap_entry_t, link);
+    if(map->destroy) map->destroy(entry->value);
+    entry->value = value;
+    return ADS_SUCCESS;
+  }
+
+  // the only allocation of the insert: link, cached hash, key and value together
+  ads_imap_entry_t* entry = ads_alloc(map->allocator, sizeof(ads_imap_entry_t));
+  if(!entry)
+    return ADS_NOMEM;
+
+  entry->link.hash = hash;
+  entry->link.key  = key;
+  entry->value     = value;
+  ads_imap_push(map, &entry->link);
+
+  return ADS_SUCCESS;
+}
+
+ads_imap_entry_t* ads_imap_get(ads_imap_t* map, void* key, void** out) {
+  ads_imap_link_t* link = ads_imap_find(map, key);
+  if(!link)
+    return NULL;
+
+  ads_imap_entry_t* entry = ads_imap_container_of(link, ads_imap_entry_t, link);
+  if(out) *out = entry->value;
+
+  return entry;
+}
+
+ads_status_t ads_imap_remove(ads_imap_t* map, void* key, void** out) {
+  ads_imap_link_t* link = ads_imap_unlink(map, key);
+  if(!link)
+    return ADS_NOTFOUND;
+
+  ads_imap_entry_t* entry = ads_imap_container_of(link, ads_imap_entry_t, link);
+  if(out)
+    *out = entry->value;
+  else if(map->destroy)
+    map->destroy(entry->value);
+
+  ads_free(map->allocator, entry, sizeof(ads_imap_entry_t));
+
+  return ADS_SUCCESS;
+}
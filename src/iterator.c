@@ -3,6 +3,8 @@
 #include "../include/list.h"
 #include "../include/dlist.h"
 #include "../include/string.h"
+#include "../include/map.h"
+#include "../include/btree.h"
 
 
 /**           DEFAULT ITERATORS            **/
@@ -43,6 +45,58 @@ ads_iterator_dlist(ads_iterator_t* it) {
   return it->curr_position == NULL ? 0 : 1;
 }
 
+static int
+ads_iterator_map(ads_iterator_t* it) {
+  ads_map_t* map = it->data_structure;
+  ads_dlist_node_t* node = NULL;
+
+  if(it->curr_position == NULL) {
+    // entries must stay in their buckets until the iteration ends
+    ads_map_pause_rehash(map);
+
+    it->index = 0;
+    ads_dlist_t* bucket = ads_map_next_bucket(map, &it->index);
+    if(bucket)
+      node = ads_dlist_get_head(bucket);
+  }
+  else
+    node = it->next_position;
+
+  if(node == NULL) {
+    ads_map_resume_rehash(map);
+    it->curr_position = NULL;
+    it->next_position = NULL;
+    return 0;
+  }
+
+  // find the next node now, so the caller can remove the current entry
+  it->next_position = ads_dlist_get_next(node);
+  if(it->next_position == NULL) {
+    it->index++;
+    ads_dlist_t* bucket = ads_map_next_bucket(map, &it->index);
+    if(bucket)
+      it->next_position = ads_dlist_get_head(bucket);
+  }
+
+  it->curr_position = ads_dlist_get_data_as(node, ads_map_entry_t*);
+  return 1;
+}
+
+static int
+ads_iterator_btree(ads_iterator_t* it) {
+  ads_btree_range_t* range = it->data_structure;
+
+  if(it->curr_position == NULL)
+    range->cursor = range->begin;
+  else
+    ads_btree_cursor_next(&range->cursor);
+
+  int end = range->cursor.leaf == range->end.leaf && range->cursor.index == range->end.index;
+  it->curr_position = end ? NULL : &range->cursor;
+
+  return it->curr_position == NULL ? 0 : 1;
+}
+
 /** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 
 void ads_iterator_init(ads_iterator_t* it,
@@ -52,10 +106,14 @@ void ads_iterator_init(ads_iterator_t* it,
   it->data_structure = data_structure;
   it->it_func = it_func;
   it->curr_position = NULL;
+  it->next_position = NULL;
+  it->index = 0;
 
   if     (it_func == ADS_ITERATOR_LIST)    it->it_func = ads_iterator_list;
   else if(it_func == ADS_ITERATOR_DLIST)   it->it_func = ads_iterator_dlist;
   else if(it_func == ADS_ITERATOR_STRING)  it->it_func = ads_iterator_string;
+  else if(it_func == ADS_ITERATOR_MAP)     it->it_func = ads_iterator_map;
+  else if(it_func == ADS_ITERATOR_BTREE)   it->it_func = ads_iterator_btree;
   else                                     it->it_func = it_func;
 }
 
@@ -68,6 +126,16 @@ int ads_iterator_iterate(ads_iterator_t* it, void** value) {
   return ret;
 }
 
+void ads_iterator_reset(ads_iterator_t* it) {
+  // a map iteration that didn't reach the end still holds the map's rehashing
+  if(it->it_func == ads_iterator_map && it->curr_position != NULL)
+    ads_map_resume_rehash((ads_map_t*) it->data_structure);
+
+  it->curr_position = NULL;
+  it->next_position = NULL;
+}
+
 void ads_iterator_destroy(ads_iterator_t* it) {
+  ads_iterator_reset(it);
   memset(it, 0, sizeof(ads_iterator_t));
 }
\ No newline at end of file
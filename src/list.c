@@ -3,10 +3,15 @@
 #include <memory.h>
 
 void ads_list_init(ads_list_t* list, void (*destroy)(void*)) {
-  list->destroy = destroy;
-  list->head    = NULL;
-  list->tail    = NULL;
-  list->size    = 0;
+  ads_list_init_allocator(list, destroy, NULL);
+}
+
+void ads_list_init_allocator(ads_list_t* list, void (*destroy)(void*), const ads_allocator_t* allocator) {
+  list->destroy   = destroy;
+  list->head      = NULL;
+  list->tail      = NULL;
+  list->size      = 0;
+  list->allocator = allocator ? allocator : ads_allocator_get_default();
 }
 
 void ads_list_clean(ads_list_t* list) {
@@ -15,9 +20,7 @@ void ads_list_clean(ads_list_t* list) {
 }
 
 void ads_list_destroy(ads_list_t* list) {
-  if(list->destroy == NULL)
-    ads_list_clean(list);
-  else {
+  if(list->destroy) {
     void* data = NULL;
 
     while(!ads_list_is_empty(list)) {
@@ -25,13 +28,16 @@ void ads_list_destroy(ads_list_t* list) {
       list->destroy(data);
     }
   }
+  // an allocator without free (e.g. an arena) releases the nodes by itself
+  else if(ads_allocator_frees(list->allocator))
+    ads_list_clean(list);
 
   memset(list, 0, sizeof(ads_list_t));
 }
 
 static inline 
-ads_list_node_t* ads_list_new_node(void* data) {
-  ads_list_node_t* new_node = malloc(sizeof(ads_list_node_t));
+ads_list_node_t* ads_list_new_node(ads_list_t* list, void* data) {
+  ads_list_node_t* new_node = ads_alloc(list->allocator, sizeof(ads_list_node_t));
   if(new_node) {
     new_node->data = data;
     new_node->next = NULL;
@@ -41,7 +47,7 @@ ads_list_node_t* ads_list_new_node(void* data) {
 }
 
 ads_status_t ads_list_push_back(ads_list_t* list, void* data) {
-  ads_list_node_t* new_node = ads_list_new_node(data);
+  ads_list_node_t* new_node = ads_list_new_node(list, data);
   if(new_node == NULL)
     return ADS_NOMEM;
 
@@ -58,7 +64,7 @@ ads_status_t ads_list_push_back(ads_list_t* list, void* data) {
 }
 
 ads_status_t ads_list_push_front(ads_list_t* list, void* data) {
-  ads_list_node_t* new_node = ads_list_new_node(data);
+  ads_list_node_t* new_node = ads_list_new_node(list, data);
   if(new_node == NULL)
     return ADS_NOMEM;
 
@@ -83,7 +89,7 @@ ads_list_add_next(ads_list_t*      list,
   else if(node == ads_list_get_tail(list))
     return ads_list_push_back(list, data);
 
-  ads_list_node_t* new_node = ads_list_new_node(data);
+  ads_list_node_t* new_node = ads_list_new_node(list, data);
   if(new_node == NULL)
     return ADS_NOMEM;
   
@@ -116,7 +122,7 @@ void ads_list_pop_front(ads_list_t* list, void** ret_data) {
 
   list->head = node->next;
 
-  free(node);
+  ads_free(list->allocator, node, sizeof(ads_list_node_t));
   list->size--;
 
   if(ads_list_get_size(list) == 0)
@@ -138,7 +144,7 @@ void ads_list_remove_next(ads_list_t*      list,
     if(node->next == NULL)
       list->tail = node;
 
-    free(rem_node);
+    ads_free(list->allocator, rem_node, sizeof(ads_list_node_t));
     list->size--;
   }
 }
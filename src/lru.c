@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lru.h"
+
+/* an entry of the cache: its node of `order` and its item in a single allocation. node.data
+   points to item, so the list handles it like any other node, but never allocates or frees it */
+typedef struct ads_lru_node {
+  ads_dlist_node_t node;
+  ads_lru_item_t item;
+} ads_lru_node_t;
+
+ads_status_t
+ads_lru_init(ads_lru_t* lru,
+             size_t capacity,
+             ads_lru_evict_f evict,
+             int    (*compare)(void* key1, void* key2),
+             size_t (*hash)(void* key))
+{
+  return ads_lru_init_allocator(lru, capacity, NULL, evict, compare, hash);
+}
+
+ads_status_t
+ads_lru_init_allocator(ads_lru_t* lru,
+                       size_t capacity,
+                       const ads_allocator_t* allocator,
+                       ads_lru_evict_f evict,
+                       int    (*compare)(void* key1, void* key2),
+                       size_t (*hash)(void* key))
+{
+  // the map only holds pointers to nodes of `order`, the entries are freed by the cache
+  ads_status_t status = ads_map_init_allocator(&lru->map, 16, 0, allocator, NULL, compare, hash);
+  if(status != ADS_SUCCESS)
+    return status;
+
+  // the entries are allocated from the allocator of the list, see ads_lru_insert_hashed
+  ads_dlist_init_allocator(&lru->order, NULL, lru->map.allocator);
+  lru->capacity  = capacity;
+  lru->cost      = 0;
+  lru->hits      = 0;
+  lru->misses    = 0;
+  lru->evictions = 0;
+  lru->evict     = evict;
+
+  return ADS_SUCCESS;
+}
+
+// unlink and free the entry of `node`; the key must already be out of the map
+static void
+ads_lru_drop(ads_lru_t* lru, ads_dlist_node_t* node) {
+  ads_lru_node_t* entry = (ads_lru_node_t*) node;
+
+  ads_dlist_unlink(&lru->order, node);
+
+  lru->cost -= entry->item.cost;
+  if(lru->evict)
+    lru->evict(entry->item.key, entry->item.value);
+  ads_free(lru->order.allocator, entry, sizeof(ads_lru_node_t));
+}
+
+void ads_lru_destroy(ads_lru_t* lru) {
+  ads_map_destroy(&lru->map);
+
+  while(!ads_dlist_is_empty(&lru->order))
+    ads_lru_drop(lru, ads_dlist_get_head(&lru->order));
+}
+
+void ads_lru_trim(ads_lru_t* lru, size_t cost) {
+  while(lru->cost > cost && !ads_dlist_is_empty(&lru->order)) {
+    ads_dlist_node_t* node = ads_dlist_get_tail(&lru->order);
+
+    ads_map_remove(&lru->map, ads_dlist_get_data_as(node, ads_lru_item_t*)->key, NULL);
+    ads_lru_drop(lru, node);
+    lru->evictions++;
+  }
+}
+
+/* the *_hashed functions take the hash of `key` already computed (lru->map.hash), for
+   ads_clru_t, which hashes the key once to pick the shard */
+
+static ads_status_t
+ads_lru_insert_hashed(ads_lru_t* lru, void* key, void* value, size_t cost, size_t hash) {
+  if(cost > lru->capacity)
+    return ADS_OUTOFBOUNDS;
+
+  ads_map_entry_t* entry = ads_map_get_hashed(&lru->map, key, hash, NULL);
+  if(entry) {
+    ads_dlist_node_t* node = entry->value;
+    ads_lru_item_t* item = ads_dlist_get_data_as(node, ads_lru_item_t*);
+
+    // the same key pointer may be inserted again, then it must not be released
+    if(lru->evict)
+      lru->evict(item->key == key ? NULL : item->key, item->value);
+
+    entry->key  = key;
+    item->key   = key;
+    item->value = value;
+    lru->cost  += cost - item->cost;
+    item->cost  = cost;
+
+    ads_dlist_move_to_front(&lru->order, node);
+    ads_lru_trim(lru, lru->capacity);
+    return ADS_SUCCESS;
+  }
+
+  // allocate everything first, so that a failure leaves the cache as it was
+  ads_lru_node_t* node = ads_alloc(lru->order.allocator, sizeof(ads_lru_node_t));
+  if(!node)
+    return ADS_NOMEM;
+
+  node->item.key   = key;
+  node->item.value = value;
+  node->item.cost  = cost;
+  node->node.data  = &node->item;
+
+  ads_status_t status = ads_map_insert_hashed(&lru->map, key, &node->node, hash);
+  if(status != ADS_SUCCESS) {
+    ads_free(lru->order.allocator, node, sizeof(ads_lru_node_t));
+    return status;
+  }
+
+  ads_dlist_link_front(&lru->order, &node->node);
+
+  /* then make room. The new entry isn't counted in lru->cost yet, so the trim stops before
+     reaching it at the head of the list */
+  ads_lru_trim(lru, lru->capacity - cost);
+  lru->cost += cost;
+
+  return ADS_SUCCESS;
+}
+
+static ads_lru_item_t*
+ads_lru_get_hashed(ads_lru_t* lru, void* key, size_t hash, void** out) {
+  void* found = NULL;
+  if(!ads_map_get_hashed(&lru->map, key, hash, &found)) {
+    lru->misses++;
+    return NULL;
+  }
+
+  ads_dlist_node_t* node = found;
+  ads_dlist_move_to_front(&lru->order, node);
+  lru->hits++;
+
+  ads_lru_item_t* item = ads_dlist_get_data_as(node, ads_lru_item_t*);
+  if(out) *out = item->value;
+  return item;
+}
+
+ads_lru_item_t* ads_lru_peek(const ads_lru_t* lru, void* key, void** out) {
+  void* found = NULL;
+  if(!ads_map_lookup(&lru->map, key, &found))
+    return NULL;
+
+  ads_dlist_node_t* node = found;
+  ads_lru_item_t* item = ads_dlist_get_data_as(node, ads_lru_item_t*);
+  if(out) *out = item->value;
+  return item;
+}
+
+static ads_status_t
+ads_lru_remove_hashed(ads_lru_t* lru, void* key, size_t hash, void** out) {
+  void* found = NULL;
+  if(ads_map_remove_hashed(&lru->map, key, hash, &found) != ADS_SUCCESS)
+    return ADS_NOTFOUND;
+
+  ads_dlist_node_t* node = found;
+  if(out) {
+    // the caller takes the value, evict only releases the key
+    ads_lru_item_t* item = ads_dlist_get_data_as(node, ads_lru_item_t*);
+    *out = item->value;
+    item->value = NULL;
+  }
+
+  ads_lru_drop(lru, node);
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_lru_insert(ads_lru_t* lru, void* key, void* value, size_t cost) {
+  return ads_lru_insert_hashed(lru, key, value, cost, lru->map.hash(key));
+}
+
+ads_lru_item_t* ads_lru_get(ads_lru_t* lru, void* key, void** out) {
+  return ads_lru_get_hashed(lru, key, lru->map.hash(key), out);
+}
+
+ads_status_t ads_lru_remove(ads_lru_t* lru, void* key, void** out) {
+  return ads_lru_remove_hashed(lru, key, lru->map.hash(key), out);
+}
+
+void ads_lru_get_stats(const ads_lru_t* lru, ads_lru_stats_t* stats) {
+  stats->size      = ads_lru_get_size(lru);
+  stats->cost      = lru->cost;
+  stats->hits      = lru->hits;
+  stats->misses    = lru->misses;
+  stats->evictions = lru->evictions;
+}
+
+/* ----- SHARDED CACHE ----- */
+
+static inline size_t
+ads_clru_round_pow2(size_t n) {
+  size_t pow2 = 1;
+  while(pow2 < n)
+    pow2 <<= 1;
+  return pow2;
+}
+
+// the key is hashed once, the same hash picks the shard and is passed to ads_lru_*_hashed
+#define ads_clru_hash(lru, key) ((lru)->shards[0].lru.map.hash((key)))
+
+// same split as ads_cmap_t: shards use the high bits of the hash, the map buckets the low ones
+static inline ads_clru_shard_t*
+ads_clru_get_shard(ads_clru_t* lru, size_t hash) {
+  hash *= 0x9e3779b97f4a7c15;
+  return &lru->shards[(hash >> 32) & (lru->n_shards - 1)];
+}
+
+// destroy the first `n` shards, which are fully initialized, and free the array
+static void
+ads_clru_destroy_shards(ads_clru_t* lru, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+    ads_lru_destroy(&lru->shards[i].lru);
+    pthread_mutex_destroy(&lru->shards[i].lock);
+  }
+
+  ads_free(lru->allocator, lru->shards, lru->n_shards * sizeof(ads_clru_shard_t));
+}
+
+ads_status_t
+ads_clru_init(ads_clru_t* lru,
+              size_t shards,
+              size_t capacity,
+              ads_lru_evict_f evict,
+              int    (*compare)(void* key1, void* key2),
+              size_t (*hash)(void* key))
+{
+  return ads_clru_init_allocator(lru, shards, capacity, NULL, evict, compare, hash);
+}
+
+ads_status_t
+ads_clru_init_allocator(ads_clru_t* lru,
+                        size_t shards,
+                        size_t capacity,
+                        const ads_allocator_t* allocator,
+                        ads_lru_evict_f evict,
+                        int    (*compare)(void* key1, void* key2),
+                        size_t (*hash)(void* key))
+{
+  shards = ads_clru_round_pow2(shards);
+
+  // every shard must be able to hold at least one entry of cost 1
+  if(capacity < shards)
+    return ADS_INVALID;
+
+  lru->allocator = allocator ? allocator : ads_allocator_get_default();
+  lru->n_shards  = shards; // the size of the array, for ads_clru_destroy_shards
+  lru->shards    = ads_alloc_aligned(lru->allocator, shards * sizeof(ads_clru_shard_t),
+                                     ADS_CLRU_CACHE_LINE);
+  if(!lru->shards)
+    return ADS_NOMEM;
+
+  for(size_t i = 0; i < shards; i++) {
+    // the remainder of the split goes to the first shards, so the capacities add up to `capacity`
+    size_t shard_capacity = capacity / shards + (i < capacity % shards);
+
+    ads_lru_t* shard = &lru->shards[i].lru;
+    if(ads_lru_init_allocator(shard, shard_capacity, lru->allocator, evict, compare, hash) != ADS_SUCCESS) {
+      ads_clru_destroy_shards(lru, i);
+      return ADS_NOMEM;
+    }
+
+    if(pthread_mutex_init(&lru->shards[i].lock, NULL) != 0) {
+      ads_lru_destroy(&lru->shards[i].lru);
+      ads_clru_destroy_shards(lru, i);
+      return ADS_NOMEM;
+    }
+  }
+
+  return ADS_SUCCESS;
+}
+
+void ads_clru_destroy(ads_clru_t* lru) {
+  ads_clru_destroy_shards(lru, lru->n_shards);
+  memset(lru, 0, sizeof(ads_clru_t));
+}
+
+ads_status_t ads_clru_insert(ads_clru_t* lru, void* key, void* value, size_t cost) {
+  size_t hash = ads_clru_hash(lru, key);
+  ads_clru_shard_t* shard = ads_clru_get_shard(lru, hash);
+
+  pthread_mutex_lock(&shard->lock);
+  ads_status_t status = ads_lru_insert_hashed(&shard->lru, key, value, cost, hash);
+  pthread_mutex_unlock(&shard->lock);
+
+  return status;
+}
+
+ads_status_t ads_clru_get(ads_clru_t* lru, void* key, void** out) {
+  size_t hash = ads_clru_hash(lru, key);
+  ads_clru_shard_t* shard = ads_clru_get_shard(lru, hash);
+
+  // a hit reorders the shard's list, so even reads take the lock exclusively
+  pthread_mutex_lock(&shard->lock);
+  ads_lru_item_t* item = ads_lru_get_hashed(&shard->lru, key, hash, out);
+  pthread_mutex_unlock(&shard->lock);
+
+  return item ? ADS_SUCCESS : ADS_NOTFOUND;
+}
+
+ads_status_t ads_clru_visit(ads_clru_t* lru, void* key, ads_clru_visit_f visit, void* arg) {
+  size_t hash = ads_clru_hash(lru, key);
+  ads_clru_shard_t* shard = ads_clru_get_shard(lru, hash);
+
+  pthread_mutex_lock(&shard->lock);
+  ads_lru_item_t* item = ads_lru_get_hashed(&shard->lru, key, hash, NULL);
+  if(item)
+    visit(item->key, item->value, arg);
+  pthread_mutex_unlock(&shard->lock);
+
+  return item ? ADS_SUCCESS : ADS_NOTFOUND;
+}
+
+ads_status_t ads_clru_remove(ads_clru_t* lru, void* key, void** out) {
+  size_t hash = ads_clru_hash(lru, key);
+  ads_clru_shard_t* shard = ads_clru_get_shard(lru, hash);
+
+  pthread_mutex_lock(&shard->lock);
+  ads_status_t status = ads_lru_remove_hashed(&shard->lru, key, hash, out);
+  pthread_mutex_unlock(&shard->lock);
+
+  return status;
+}
+
+void ads_clru_get_stats(ads_clru_t* lru, ads_lru_stats_t* stats) {
+  memset(stats, 0, sizeof(ads_lru_stats_t));
+
+  for(size_t i = 0; i < lru->n_shards; i++) {
+    ads_lru_stats_t shard;
+
+    pthread_mutex_lock(&lru->shards[i].lock);
+    ads_lru_get_stats(&lru->shards[i].lru, &shard);
+    pthread_mutex_unlock(&lru->shards[i].lock);
+
+    stats->size      += shard.size;
+    stats->cost      += shard.cost;
+    stats->hits      += shard.hits;
+    stats->misses    += shard.misses;
+    stats->evictions += shard.evictions;
+  }
+}
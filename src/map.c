@@ -1,11 +1,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../include/map.h"
+#include "../include/string.h"
 
 /* ----- STRING KEY  ----- */
 
-// djb2 string hashing algorithm
+// word-at-a-time hash, see hash.h
 size_t ADS_MAP_HASH_STRING(void* key_string) {
+  return ads_hash_bytes(key_string, strlen(key_string), ads_hash_get_seed());
+}
+
+// djb2 string hashing algorithm
+size_t ADS_MAP_HASH_STRING_DJB2(void* key_string) {
   size_t hash = 5381;
   char* str = key_string;
   
@@ -20,6 +26,20 @@ int ADS_MAP_COMPARE_STRING(void* key_string1, void* key_string2) {
   return strcmp(key_string1, key_string2) == 0;
 }
 
+/* ----- ADS_STRING_T KEY  ----- */
+
+size_t ADS_MAP_HASH_ADS_STRING(void* key_ads_string) {
+  ads_string_t* str = key_ads_string;
+  return ads_hash_bytes(str->buf, str->size, ads_hash_get_seed());
+}
+
+int ADS_MAP_COMPARE_ADS_STRING(void* key_ads_string1, void* key_ads_string2) {
+  ads_string_t* str1 = key_ads_string1;
+  ads_string_t* str2 = key_ads_string2;
+
+  return str1->size == str2->size && memcmp(str1->buf, str2->buf, str1->size) == 0;
+}
+
 /* ----- UNSIGNED INTEGER64 KEY  ----- */
 
 // MurmurHash3 integer hashing algorithm by David Stafford
@@ -42,6 +62,65 @@ int ADS_MAP_COMPARE_UINT64(void* key_uint64a, void* key_uint64b) {
 
 /* ---------- */
 
+/* occupancy bitmap: bit i is set when bucket i isn't empty, so scans of sparse tables skip
+   64 empty buckets at a time */
+#define ads_map_bitmap_words(buckets) (((buckets) + 63) / 64)
+#define ads_map_bitmap_set(bitmap, i)   ((bitmap)[(i) / 64] |=  ((uint64_t) 1 << ((i) % 64)))
+#define ads_map_bitmap_clear(bitmap, i) ((bitmap)[(i) / 64] &= ~((uint64_t) 1 << ((i) % 64)))
+
+// index of the first set bit at or after `index`, or `buckets` if there is none
+static inline size_t
+ads_map_bitmap_next(const uint64_t* bitmap, size_t buckets, size_t index) {
+  if(index >= buckets)
+    return buckets;
+
+  size_t word = index / 64;
+  uint64_t bits = bitmap[word] & (~(uint64_t) 0 << (index % 64));
+
+  while(bits == 0) {
+    if(++word == ads_map_bitmap_words(buckets))
+      return buckets;
+    bits = bitmap[word];
+  }
+
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+static ads_dlist_t*
+ads_map_create_table(const ads_map_t* map, size_t buckets, uint64_t** occupied) {
+  // allocate memory for each bucket
+  ads_dlist_t* htable = ads_calloc(map->allocator, buckets, sizeof(ads_dlist_t));
+  if(!htable)
+    return NULL;
+
+  *occupied = ads_calloc(map->allocator, ads_map_bitmap_words(buckets), sizeof(uint64_t));
+  if(!*occupied) {
+    ads_free(map->allocator, htable, buckets * sizeof(ads_dlist_t));
+    return NULL;
+  }
+
+  /* create a linked lists in each bucket. Its nodes come from the map's allocator, and the
+     entries are released by the map itself, never by the list */
+  for(size_t i = 0; i < buckets; i++)
+    ads_dlist_init_allocator(&htable[i], NULL, map->allocator);
+
+  return htable;
+}
+
+static void
+ads_map_free_table(const ads_map_t* map, ads_dlist_t* htable, uint64_t* occupied, size_t buckets) {
+  ads_free(map->allocator, htable, buckets * sizeof(ads_dlist_t));
+  ads_free(map->allocator, occupied, ads_map_bitmap_words(buckets) * sizeof(uint64_t));
+}
+
+static inline size_t
+ads_map_round_pow2(size_t buckets) {
+  size_t pow2 = 1;
+  while(pow2 < buckets)
+    pow2 <<= 1;
+  return pow2;
+}
+
 ads_status_t
 ads_map_init(ads_map_t* map,
              size_t buckets,
@@ -49,134 +128,689 @@ ads_map_init(ads_map_t* map,
              int    (*compare)(void* key1, void* key2),
              size_t (*hash)(void* key))
 {
-  // allocate memory for each bucket
-  map->htable = calloc(buckets, sizeof(ads_dlist_t));
+  return ads_map_init_flags(map, buckets, 0, destroy, compare, hash);
+}
+
+ads_status_t
+ads_map_init_flags(ads_map_t* map,
+                   size_t buckets,
+                   int    flags,
+                   void   (*destroy)(void* value),
+                   int    (*compare)(void* key1, void* key2),
+                   size_t (*hash)(void* key))
+{
+  return ads_map_init_allocator(map, buckets, flags, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_map_init_allocator(ads_map_t* map,
+                       size_t buckets,
+                       int    flags,
+                       const ads_allocator_t* allocator,
+                       void   (*destroy)(void* value),
+                       int    (*compare)(void* key1, void* key2),
+                       size_t (*hash)(void* key))
+{
+  if(buckets == 0)
+    buckets = 1;
+
+  // growing and shrinking double/halve the table, so it stays a power of two
+  if(flags & ADS_MAP_POW2)
+    buckets = ads_map_round_pow2(buckets);
+
+  map->allocator = allocator ? allocator : ads_allocator_get_default();
+  map->htable = ads_map_create_table(map, buckets, &map->occupied);
   if(!map->htable)
     return ADS_NOMEM;
 
-  // create a linked lists in each bucket
-  for(size_t i = 0; i < buckets; i++)
-    ads_dlist_init(&map->htable[i], free);
-
   map->buckets = buckets;
+  map->size    = 0;
   map->destroy = destroy;
   map->compare = compare;
   map->hash    = hash;
 
+  map->old_htable   = NULL;
+  map->old_occupied = NULL;
+  map->old_buckets  = 0;
+  map->rehash_index = 0;
+  map->min_buckets  = buckets;
+  map->iterators    = 0;
+
+  map->max_load_factor = ADS_MAP_MAX_LOAD_FACTOR;
+  map->min_load_factor = ADS_MAP_MIN_LOAD_FACTOR;
+  map->flags = flags;
+  ads_map_reset_stats(map);
+
+  map->bloom.blocks = NULL;
+  map->old_bloom.blocks = NULL;
+  if(flags & ADS_MAP_BLOOM) {
+    size_t capacity = (size_t) (buckets * map->max_load_factor) + 1;
+    if(ads_bloom_init_allocator(&map->bloom, capacity, map->allocator) != ADS_SUCCESS) {
+      ads_map_free_table(map, map->htable, map->occupied, buckets);
+      return ADS_NOMEM;
+    }
+  }
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t
+ads_map_set_load_factor(ads_map_t* map,
+                        double max_load_factor,
+                        double min_load_factor)
+{
+  /* halving the table doubles its load, which must stay at most max_load_factor, or the
+     shrink would be followed by a grow. Written so that NaN fails too */
+  if(!(max_load_factor > 0) || !(min_load_factor >= 0) || !(min_load_factor * 2 <= max_load_factor))
+    return ADS_INVALID;
+
+  map->max_load_factor = max_load_factor;
+  map->min_load_factor = min_load_factor;
+
+  return ADS_SUCCESS;
+}
+
+/* ----- INCREMENTAL REHASHING ----- */
+
+// move every node of the bucket `index` of the old table to the current table
+static void
+ads_map_rehash_bucket(ads_map_t* map, size_t index) {
+  ads_dlist_t* old = &map->old_htable[index];
+
+  // the nodes are relinked, so no memory is allocated or freed
+  while(!ads_dlist_is_empty(old)) {
+    ads_dlist_node_t* node = ads_dlist_get_head(old);
+    ads_map_entry_t* entry = ads_dlist_get_data_as(node, ads_map_entry_t*);
+
+    ads_dlist_unlink(old, node);
+    size_t new_index = ads_map_index_of(map, entry->hash, map->buckets);
+    ads_dlist_link_front(&map->htable[new_index], node);
+    ads_map_bitmap_set(map->occupied, new_index);
+
+    // the filter of the current table is filled as its entries arrive
+    if(map->flags & ADS_MAP_BLOOM)
+      ads_bloom_add(&map->bloom, entry->hash);
+  }
+
+  ads_map_bitmap_clear(map->old_occupied, index);
+}
+
+// move up to `steps` non-empty buckets of the old table, visiting at most steps * 10 empty ones
+static void
+ads_map_rehash_step(ads_map_t* map, size_t steps) {
+  size_t empty_visits = steps * 10;
+
+  // iterators rely on the entries staying in their buckets
+  if(map->iterators > 0)
+    return;
+
+  while(steps > 0 && map->rehash_index < map->old_buckets) {
+    ads_dlist_t* old = &map->old_htable[map->rehash_index];
+    if(ads_dlist_is_empty(old)) {
+      map->rehash_index++;
+      if(--empty_visits == 0)
+        break;
+      continue;
+    }
+
+    ads_map_rehash_bucket(map, map->rehash_index++);
+    steps--;
+  }
+
+  // every bucket was moved, the old table can be released
+  if(map->rehash_index == map->old_buckets) {
+    ads_map_free_table(map, map->old_htable, map->old_occupied, map->old_buckets);
+    if(map->flags & ADS_MAP_BLOOM)
+      ads_bloom_destroy(&map->old_bloom);
+
+    map->old_htable   = NULL;
+    map->old_occupied = NULL;
+    map->old_buckets  = 0;
+    map->rehash_index = 0;
+  }
+}
+
+// a paused rehash (see ads_map_pause_rehash) is left as it is, steps would never move a bucket
+static void
+ads_map_rehash_all(ads_map_t* map) {
+  while(ads_map_is_rehashing(map) && map->iterators == 0)
+    ads_map_rehash_step(map, map->old_buckets);
+}
+
+/* ---------- */
+
+static ads_status_t ads_map_resize(ads_map_t* map, size_t buckets);
+
+/* forget the removed hashes once they outnumber both the keys and the blocks of the filter.
+   The filter is rebuilt by moving the entries to a new table of the same size, so the cost
+   is spread over the next operations like the one of a resize */
+static void
+ads_map_bloom_purge_if_needed(ads_map_t* map) {
+  // while rehashing, the old filter is dropped anyway once every bucket is moved
+  if(ads_map_is_rehashing(map))
+    return;
+
+  size_t stale = ads_bloom_get_count(&map->bloom) - map->size;
+  if(stale <= map->size || stale < ads_bloom_get_blocks(&map->bloom))
+    return;
+
+  ads_map_resize(map, map->buckets); // on failure, just keep the current filter
+}
+
+/* allocate a table with `buckets` buckets and start moving the entries to it. With
+   ADS_MAP_BLOOM, the current table gets an empty filter and the old one keeps its own */
+static ads_status_t
+ads_map_resize(ads_map_t* map, size_t buckets) {
+  // the table can't change under an iterator, the resize is just skipped
+  if(map->iterators > 0)
+    return ADS_SUCCESS;
+
+  // a previous resize must be finished before starting a new one
+  ads_map_rehash_all(map);
+
+  uint64_t* occupied = NULL;
+  ads_dlist_t* htable = ads_map_create_table(map, buckets, &occupied);
+  if(!htable)
+    return ADS_NOMEM;
+
+  ads_bloom_t bloom = {0};
+  if((map->flags & ADS_MAP_BLOOM) &&
+     ads_bloom_init_allocator(&bloom, (size_t) (buckets * map->max_load_factor) + 1,
+                              map->allocator) != ADS_SUCCESS) {
+    ads_map_free_table(map, htable, occupied, buckets);
+    return ADS_NOMEM;
+  }
+
+  map->old_htable   = map->htable;
+  map->old_occupied = map->occupied;
+  map->old_buckets  = map->buckets;
+  map->rehash_index = 0;
+
+  map->htable   = htable;
+  map->occupied = occupied;
+  map->buckets  = buckets;
+
+  if(map->flags & ADS_MAP_BLOOM) {
+    map->old_bloom = map->bloom;
+    map->bloom     = bloom;
+  }
+
+  // nothing to move, release the old table right away
+  if(map->size == 0)
+    ads_map_rehash_all(map);
+
   return ADS_SUCCESS;
 }
 
+static inline void
+ads_map_grow_if_needed(ads_map_t* map) {
+  if(!ads_map_is_rehashing(map) && map->size > map->buckets * map->max_load_factor)
+    ads_map_resize(map, map->buckets * 2); // on failure, just keep the current table
+}
+
+static inline void
+ads_map_shrink_if_needed(ads_map_t* map) {
+  if(ads_map_is_rehashing(map) || map->buckets <= map->min_buckets)
+    return;
+
+  if(map->size < map->buckets * map->min_load_factor) {
+    size_t buckets = map->buckets / 2;
+    ads_map_resize(map, buckets < map->min_buckets ? map->min_buckets : buckets);
+  }
+}
+
+ads_status_t ads_map_reserve(ads_map_t* map, size_t size) {
+  // the table can't be replaced under an iterator, and the caller relies on the room being there
+  if(map->iterators > 0)
+    return ADS_INVALID;
+
+  size_t buckets = (size_t) (size / map->max_load_factor) + 1;
+  if(map->flags & ADS_MAP_POW2)
+    buckets = ads_map_round_pow2(buckets);
+
+  if(buckets <= map->buckets)
+    return ADS_SUCCESS;
+
+  // the caller asked for the room right now, so the whole table is moved at once
+  ads_status_t status = ads_map_resize(map, buckets);
+  if(status == ADS_SUCCESS)
+    ads_map_rehash_all(map);
+
+  return status;
+}
+
+/* ---------- */
+
 static ads_map_entry_t* 
-ads_map_create_entry(void* key, void* value) {
-  ads_map_entry_t* entry = calloc(1, sizeof(ads_map_entry_t));
+ads_map_create_entry(const ads_map_t* map, void* key, void* value, size_t hash) {
+  ads_map_entry_t* entry = ads_alloc(map->allocator, sizeof(ads_map_entry_t));
   if(entry) {
     entry->key = key;
     entry->value = value;
+    entry->hash = hash;
   }
 
   return entry;
 }
 
-ads_status_t 
-ads_map_insert(ads_map_t*  map,
-               void*       key,
-               void*       value)
-{
+static ads_dlist_node_t*
+ads_map_find_in_bucket(const ads_map_t* map, ads_dlist_t* dlist, void* key, size_t hash, size_t* probes) {
+  ads_dlist_node_t* node = ads_dlist_get_head(dlist);
+  while(node) {
+    if(probes) (*probes)++;
+
+    // different hashes can't be the same key, so compare is only called on a hash match
+    ads_map_entry_t* entry = ads_dlist_get_data_as(node, ads_map_entry_t*);
+    if(entry->hash == hash && map->compare(key, entry->key))
+      return node;
+
+    node = ads_dlist_get_next(node);
+  }
+
+  return NULL;
+}
+
+/* look for `key` in the current table and, while rehashing, in the old one. If `probes` isn't
+   NULL, the number of entries compared is added to it */
+static ads_dlist_node_t*
+ads_map_get_key_node(const ads_map_t* map, void* key, size_t hash, ads_dlist_t** bucket, size_t* probes) {
+  /* a negative answer of a filter is always right, its table doesn't need to be read. Each
+     table has its own filter, the keys not moved yet are only in the old one */
+  int bloom = map->flags & ADS_MAP_BLOOM;
+
+  ads_dlist_t* dlist = NULL;
+  ads_dlist_node_t* node = NULL;
+  if(!bloom || ads_bloom_may_contain(&map->bloom, hash)) {
+    dlist = &map->htable[ads_map_index_of(map, hash, map->buckets)];
+    node = ads_map_find_in_bucket(map, dlist, key, hash, probes);
+  }
+
+  if(!node && ads_map_is_rehashing(map) && (!bloom || ads_bloom_may_contain(&map->old_bloom, hash))) {
+    dlist = &map->old_htable[ads_map_index_of(map, hash, map->old_buckets)];
+    node = ads_map_find_in_bucket(map, dlist, key, hash, probes);
+  }
+
+  if(bucket) *bucket = dlist;
+  return node;
+}
+
+// insert with the hash of `key` already computed
+static ads_status_t
+ads_map_put_hashed(ads_map_t* map, void* key, void* value, size_t hash) {
   ads_status_t status = ADS_SUCCESS;
 
   // try to find the key in the map
-  ads_map_entry_t* entry = ads_map_get(map, key, NULL);
+  ads_dlist_node_t* key_node = ads_map_get_key_node(map, key, hash, NULL, NULL);
   
   // key already exist, so we need to update with the new value, and free the old one
-  if(entry) {
+  if(key_node) {
+    ads_map_entry_t* entry = ads_dlist_get_data_as(key_node, ads_map_entry_t*);
     if(map->destroy) map->destroy(entry->value);
     entry->value = value;
   }
   else { // key doens't exist, so we need to create an entry
-    entry = ads_map_create_entry(key, value);
+    ads_map_entry_t* entry = ads_map_create_entry(map, key, value, hash);
     if(entry == NULL)
       return ADS_NOMEM; // failed to create the entry
   
-    size_t index = ads_map_get_index(map, key);
-    ads_status_t status = ads_dlist_push_back(&map->htable[index], entry);
+    // new entries always go to the current table
+    size_t index = ads_map_index_of(map, hash, map->buckets);
+    status = ads_dlist_push_back(&map->htable[index], entry);
     if(status != ADS_SUCCESS)
-      free(entry); // failed to push entry in the list
-    else
+      ads_free(map->allocator, entry, sizeof(ads_map_entry_t)); // failed to push entry in the list
+    else {
+      ads_map_bitmap_set(map->occupied, index);
       map->size++;
+      if(map->flags & ADS_MAP_BLOOM)
+        ads_bloom_add(&map->bloom, hash);
+
+      ads_map_grow_if_needed(map);
+    }
   }
 
   return status;
 }
 
-void ads_map_destroy(ads_map_t* map) {
-  
-  for(size_t i = 0; i < map->buckets && map->size > 0; i++) {
-    ads_dlist_t* dlist = &map->htable[i];
+ads_status_t 
+ads_map_insert(ads_map_t*  map,
+               void*       key,
+               void*       value)
+{
+  return ads_map_insert_hashed(map, key, value, map->hash(key));
+}
+
+ads_status_t ads_map_insert_hashed(ads_map_t* map, void* key, void* value, size_t hash) {
+  if(ads_map_is_rehashing(map))
+    ads_map_rehash_step(map, ADS_MAP_REHASH_STEP);
+
+  return ads_map_put_hashed(map, key, value, hash);
+}
+
+static void
+ads_map_destroy_table(ads_map_t* map, ads_dlist_t* htable, uint64_t* occupied, size_t buckets) {
+  // the entries are released with the allocator, they don't need to be visited
+  if(map->destroy == NULL && !ads_allocator_frees(map->allocator))
+    map->size = 0;
 
-    ads_dlist_node_t* node = ads_dlist_get_head(dlist);
-    while(node) {
-      ads_map_entry_t* entry = ads_dlist_get_data_as(node, ads_map_entry_t*);
+  for(size_t i = 0; i < buckets && map->size > 0; i++) {
+    ads_dlist_t* dlist = &htable[i];
+
+    while(!ads_dlist_is_empty(dlist)) {
+      ads_map_entry_t* entry = NULL;
+      ads_dlist_pop_front(dlist, (void*) &entry);
       if(map->destroy)
         map->destroy(entry->value);
 
+      ads_free(map->allocator, entry, sizeof(ads_map_entry_t));
       map->size--;
-      node = ads_dlist_get_next(node);
     }
-    ads_dlist_destroy(dlist);
   }
 
-  free(map->htable);
+  ads_map_free_table(map, htable, occupied, buckets);
 }
 
-static ads_dlist_node_t*
-ads_map_get_key_node(ads_map_t* map, void* key) {
-  size_t index = ads_map_get_index(map, key);
-  ads_dlist_t* dlist = &map->htable[index];
+void ads_map_destroy(ads_map_t* map) {
+  if(ads_map_is_rehashing(map))
+    ads_map_destroy_table(map, map->old_htable, map->old_occupied, map->old_buckets);
 
-  ads_dlist_node_t* node = ads_dlist_get_head(dlist);
-  while(node) {
+  ads_map_destroy_table(map, map->htable, map->occupied, map->buckets);
 
-    ads_map_entry_t* entry = ads_dlist_get_data_as(node, ads_map_entry_t*);
-    if(map->compare(key, entry->key))
-      return node;
+  if(map->flags & ADS_MAP_BLOOM) {
+    ads_bloom_destroy(&map->bloom);
+    ads_bloom_destroy(&map->old_bloom); // no blocks unless rehashing
+  }
 
-    node = ads_dlist_get_next(node);
+  map->htable       = NULL;
+  map->occupied     = NULL;
+  map->old_htable   = NULL;
+  map->old_occupied = NULL;
+}
+
+/* ----- STATISTICS ----- */
+
+#ifdef ADS_MAP_STATS
+static void
+ads_map_count_lookup(ads_map_t* map, ads_dlist_node_t* key_node, size_t probes) {
+  if(key_node)
+    map->counters.hits++;
+  else
+    map->counters.misses++;
+
+  map->counters.probes[probes < ADS_MAP_STATS_PROBES ? probes : ADS_MAP_STATS_PROBES - 1]++;
+}
+
+#define ADS_MAP_PROBES(probes) (&(probes))
+#else
+// without ADS_MAP_STATS nothing is counted and the probe pointer is always NULL
+#define ADS_MAP_PROBES(probes) NULL
+#define ads_map_count_lookup(map, key_node, probes) ((void) (probes))
+#endif
+
+// chain lengths of one table, accumulated into `stats`
+static void
+ads_map_table_stats(const ads_dlist_t* htable, size_t buckets, ads_map_stats_t* stats) {
+  for(size_t i = 0; i < buckets; i++) {
+    size_t chain = ads_dlist_get_size(&htable[i]);
+    if(chain == 0)
+      stats->empty_buckets++;
+    else if(chain > stats->max_chain)
+      stats->max_chain = chain;
   }
 
-  return NULL;
+  stats->buckets += buckets;
 }
 
-ads_map_entry_t*
-ads_map_get(ads_map_t* map, void* key, void** out) {
+void ads_map_get_stats(const ads_map_t* map, ads_map_stats_t* stats) {
+  memset(stats, 0, sizeof(ads_map_stats_t));
 
-  ads_map_entry_t* entry = NULL;
-  ads_dlist_node_t* key_node = ads_map_get_key_node(map, key);
-  if(key_node) {
-    entry = ads_dlist_get_data_as(key_node, ads_map_entry_t*);
-    if(out) *out = entry->value;
+  stats->size = map->size;
+  ads_map_table_stats(map->htable, map->buckets, stats);
+  if(ads_map_is_rehashing(map))
+    ads_map_table_stats(map->old_htable, map->old_buckets, stats);
+
+  size_t used = stats->buckets - stats->empty_buckets;
+  stats->mean_chain = used ? (double) stats->size / used : 0.0;
+
+  stats->counters = map->counters;
+}
+
+void ads_map_reset_stats(ads_map_t* map) {
+  memset(&map->counters, 0, sizeof(ads_map_counters_t));
+}
+
+void ads_map_dump_stats(const ads_map_t* map, FILE* out) {
+  ads_map_stats_t stats;
+  ads_map_get_stats(map, &stats);
+
+  fprintf(out, "size: %zu\n", stats.size);
+  fprintf(out, "buckets: %zu (%zu empty)%s\n", stats.buckets, stats.empty_buckets,
+          ads_map_is_rehashing(map) ? ", rehashing" : "");
+  fprintf(out, "load factor: %.3f\n", stats.buckets ? (double) stats.size / stats.buckets : 0.0);
+  fprintf(out, "chain length: max %zu, mean %.3f\n", stats.max_chain, stats.mean_chain);
+
+#ifdef ADS_MAP_STATS
+  size_t lookups = stats.counters.hits + stats.counters.misses;
+  fprintf(out, "lookups: %zu (%zu hits, %zu misses)\n", lookups, stats.counters.hits, stats.counters.misses);
+  fprintf(out, "probes per lookup:\n");
+  for(size_t i = 0; i < ADS_MAP_STATS_PROBES; i++) {
+    if(stats.counters.probes[i] == 0)
+      continue;
+
+    fprintf(out, "  %2zu%s %zu (%.1f%%)\n", i, i == ADS_MAP_STATS_PROBES - 1 ? "+:" : ":",
+            stats.counters.probes[i], 100.0 * stats.counters.probes[i] / lookups);
   }
+#else
+  fprintf(out, "lookups: not counted, compile with -DADS_MAP_STATS\n");
+#endif
+}
+
+/* ----- LOOKUP ----- */
 
+static ads_map_entry_t*
+ads_map_entry_of(ads_dlist_node_t* key_node, void** out) {
+  if(!key_node)
+    return NULL;
+
+  ads_map_entry_t* entry = ads_dlist_get_data_as(key_node, ads_map_entry_t*);
+  if(out) *out = entry->value;
   return entry;
 }
 
+ads_map_entry_t*
+ads_map_get(ads_map_t* map, void* key, void** out) {
+  return ads_map_get_hashed(map, key, map->hash(key), out);
+}
+
+ads_map_entry_t*
+ads_map_get_hashed(ads_map_t* map, void* key, size_t hash, void** out) {
+
+  if(ads_map_is_rehashing(map))
+    ads_map_rehash_step(map, ADS_MAP_REHASH_STEP);
+
+  size_t probes = 0;
+  ads_dlist_node_t* key_node = ads_map_get_key_node(map, key, hash, NULL, ADS_MAP_PROBES(probes));
+  ads_map_count_lookup(map, key_node, probes);
+
+  return ads_map_entry_of(key_node, out);
+}
+
+ads_map_entry_t*
+ads_map_lookup(const ads_map_t* map, void* key, void** out) {
+  return ads_map_lookup_hashed(map, key, map->hash(key), out);
+}
+
+ads_map_entry_t*
+ads_map_lookup_hashed(const ads_map_t* map, void* key, size_t hash, void** out) {
+  return ads_map_entry_of(ads_map_get_key_node(map, key, hash, NULL, NULL), out);
+}
+
 ads_status_t ads_map_remove(ads_map_t* map, void* key, void** out) {
-  ads_dlist_node_t* key_node = ads_map_get_key_node(map, key);
+  return ads_map_remove_hashed(map, key, map->hash(key), out);
+}
+
+ads_status_t ads_map_remove_hashed(ads_map_t* map, void* key, size_t hash, void** out) {
+  if(ads_map_is_rehashing(map))
+    ads_map_rehash_step(map, ADS_MAP_REHASH_STEP);
+
+  ads_dlist_t* bucket = NULL;
+  ads_dlist_node_t* key_node = ads_map_get_key_node(map, key, hash, &bucket, NULL);
   if(!key_node)
     return ADS_NOTFOUND;
   
   ads_dlist_node_t* prev = key_node->prev;
 
   ads_map_entry_t* entry = NULL;
-  ads_dlist_remove_next(&map->htable[ads_map_get_index(map, key)], prev, (void*) &entry);
+  ads_dlist_remove_next(bucket, prev, (void*) &entry);
+
+  if(ads_dlist_is_empty(bucket)) {
+    size_t index = ads_map_index_of(map, entry->hash, map->buckets);
+    if(bucket == &map->htable[index])
+      ads_map_bitmap_clear(map->occupied, index);
+    else
+      ads_map_bitmap_clear(map->old_occupied, ads_map_index_of(map, entry->hash, map->old_buckets));
+  }
   
   void* value = entry->value;
   if(out)
     *out = value;
-  else
+  else if(map->destroy)
     map->destroy(value);
   
   map->size--;
-  free(entry);
+  ads_free(map->allocator, entry, sizeof(ads_map_entry_t));
+
+  if(map->flags & ADS_MAP_BLOOM)
+    ads_map_bloom_purge_if_needed(map);
+
+  ads_map_shrink_if_needed(map);
+
+  return ADS_SUCCESS;
+}
+
+/* ----- ITERATION ----- */
+
+ads_dlist_t* ads_map_next_bucket(const ads_map_t* map, size_t* index) {
+  size_t i = *index;
+  size_t base = 0; // virtual index of the first bucket of htable
+
+  if(ads_map_is_rehashing(map)) {
+    base = map->old_buckets;
+
+    if(i < base) {
+      i = ads_map_bitmap_next(map->old_occupied, map->old_buckets, i);
+      if(i < map->old_buckets) {
+        *index = i;
+        return &map->old_htable[i];
+      }
+    }
+  }
+
+  i = ads_map_bitmap_next(map->occupied, map->buckets, i < base ? 0 : i - base);
+  if(i == map->buckets)
+    return NULL;
+
+  *index = base + i;
+  return &map->htable[i];
+}
+
+/* ----- BATCHED OPERATIONS ----- */
+
+/*
+  keys are processed ADS_MAP_BATCH_SIZE at a time in three passes: hash every key and
+  prefetch its bucket, then prefetch the first node of each bucket, then prefetch the entries
+  and resolve the keys. The cache misses of a whole window are in flight at the same time
+  instead of one after the other.
+*/
+
+static inline void
+ads_map_prefetch_buckets(const ads_map_t* map, size_t hash) {
+  __builtin_prefetch(&map->htable[ads_map_index_of(map, hash, map->buckets)]);
+  if(ads_map_is_rehashing(map))
+    __builtin_prefetch(&map->old_htable[ads_map_index_of(map, hash, map->old_buckets)]);
+}
+
+static inline void
+ads_map_prefetch_heads(const ads_map_t* map, size_t hash) {
+  ads_dlist_node_t* head = ads_dlist_get_head(&map->htable[ads_map_index_of(map, hash, map->buckets)]);
+  if(head)
+    __builtin_prefetch(head);
+}
+
+static inline void
+ads_map_prefetch_entries(const ads_map_t* map, size_t hash) {
+  ads_dlist_node_t* head = ads_dlist_get_head(&map->htable[ads_map_index_of(map, hash, map->buckets)]);
+  if(head)
+    __builtin_prefetch(head->data);
+}
+
+static void
+ads_map_prefetch_batch(ads_map_t* map, void** keys, size_t count, size_t* hashes) {
+  for(size_t i = 0; i < count; i++) {
+    hashes[i] = map->hash(keys[i]);
+    ads_map_prefetch_buckets(map, hashes[i]);
+  }
+
+  for(size_t i = 0; i < count; i++)
+    ads_map_prefetch_heads(map, hashes[i]);
+
+  for(size_t i = 0; i < count; i++)
+    ads_map_prefetch_entries(map, hashes[i]);
+}
+
+size_t
+ads_map_get_batch(ads_map_t*        map,
+                  void**            keys,
+                  size_t            count,
+                  ads_map_entry_t** entries,
+                  void**            out)
+{
+  size_t hashes[ADS_MAP_BATCH_SIZE];
+  size_t found = 0;
+
+  for(size_t start = 0; start < count; start += ADS_MAP_BATCH_SIZE) {
+    size_t n = count - start < ADS_MAP_BATCH_SIZE ? count - start : ADS_MAP_BATCH_SIZE;
+
+    if(ads_map_is_rehashing(map))
+      ads_map_rehash_step(map, ADS_MAP_REHASH_STEP * n);
+
+    ads_map_prefetch_batch(map, &keys[start], n, hashes);
+
+    for(size_t i = 0; i < n; i++) {
+      size_t probes = 0;
+      ads_dlist_node_t* key_node = ads_map_get_key_node(map, keys[start + i], hashes[i], NULL, ADS_MAP_PROBES(probes));
+      ads_map_count_lookup(map, key_node, probes);
+
+      ads_map_entry_t* entry = ads_map_entry_of(key_node, out ? &out[start + i] : NULL);
+      if(entry) found++;
+      if(entries) entries[start + i] = entry;
+    }
+  }
+
+  return found;
+}
+
+ads_status_t
+ads_map_insert_batch(ads_map_t* map,
+                     void**     keys,
+                     void**     values,
+                     size_t     count)
+{
+  size_t hashes[ADS_MAP_BATCH_SIZE];
+
+  for(size_t start = 0; start < count; start += ADS_MAP_BATCH_SIZE) {
+    size_t n = count - start < ADS_MAP_BATCH_SIZE ? count - start : ADS_MAP_BATCH_SIZE;
+
+    if(ads_map_is_rehashing(map))
+      ads_map_rehash_step(map, ADS_MAP_REHASH_STEP * n);
+
+    ads_map_prefetch_batch(map, &keys[start], n, hashes);
+
+    for(size_t i = 0; i < n; i++) {
+      ads_status_t status = ads_map_put_hashed(map, keys[start + i], values[start + i], hashes[i]);
+      if(status != ADS_SUCCESS)
+        return status;
+    }
+  }
 
   return ADS_SUCCESS;
 }
\ No newline at end of file
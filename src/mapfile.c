@@ -0,0 +1,332 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/mapfile.h"
+
+#define ads_mapfile_align(size) (((size) + 7) & ~(size_t) 7)
+
+// the file's hashes must be the same in every process: no seed
+static inline uint64_t
+ads_mapfile_hash_string(const char* key, size_t key_size) {
+  return ads_hash_bytes(key, key_size, 0);
+}
+
+static inline uint64_t
+ads_mapfile_hash_uint64(uint64_t key) {
+  return ADS_MAP_HASH_UINT64(ads_map_uint64_key(key));
+}
+
+static inline uint64_t
+ads_mapfile_read_u64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* ----- WRITE ----- */
+
+typedef struct ads_mapfile_record {
+  ads_map_entry_t* entry;
+  size_t value_size;
+  size_t key_size;
+} ads_mapfile_record_t;
+
+/* bytes of the value of `entry`. The serializer may reuse its buffer on every call, so the
+   records are sized with a first call and the value is serialized again to be written */
+static inline const void*
+ads_mapfile_serialize(ads_map_entry_t* entry, ads_mapfile_serialize_f serialize, size_t* size) {
+  if(serialize)
+    return serialize(entry->value, size);
+
+  *size = entry->value ? strlen(entry->value) + 1 : 0;
+  return entry->value;
+}
+
+static inline size_t
+ads_mapfile_record_size(ads_mapfile_key_t key_type, const ads_mapfile_record_t* record) {
+  size_t key_size = key_type == ADS_MAPFILE_STRING ? record->key_size + 1 : 0;
+  return ads_mapfile_align(2 * sizeof(uint64_t) + key_size + record->value_size);
+}
+
+static ads_status_t
+ads_mapfile_write_records(FILE* out,
+                          ads_mapfile_key_t key_type,
+                          ads_mapfile_serialize_f serialize,
+                          ads_mapfile_record_t* records,
+                          size_t count)
+{
+  static const char padding[8] = {0};
+
+  for(size_t i = 0; i < count; i++) {
+    // the offsets in the table were computed with the first size
+    size_t value_size = 0;
+    const void* value = ads_mapfile_serialize(records[i].entry, serialize, &value_size);
+    if(value_size != records[i].value_size)
+      return ADS_INVALID;
+
+    uint64_t head[2] = {
+      key_type == ADS_MAPFILE_STRING ? records[i].key_size : (uint64_t) (size_t) records[i].entry->key,
+      records[i].value_size
+    };
+
+    size_t written = fwrite(head, sizeof(head), 1, out);
+    if(key_type == ADS_MAPFILE_STRING)
+      written += fwrite(records[i].entry->key, records[i].key_size + 1, 1, out);
+    else
+      written++;
+    if(records[i].value_size > 0)
+      written += fwrite(value, records[i].value_size, 1, out);
+    else
+      written++;
+
+    size_t unaligned = ads_mapfile_record_size(key_type, &records[i])
+                     - (sizeof(head) + (key_type == ADS_MAPFILE_STRING ? records[i].key_size + 1 : 0) + records[i].value_size);
+    if(unaligned > 0)
+      written += fwrite(padding, unaligned, 1, out);
+    else
+      written++;
+
+    if(written != 4)
+      return ADS_IOERROR;
+  }
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t
+ads_mapfile_write(ads_map_t*              map,
+                  const char*             path,
+                  ads_mapfile_key_t       key_type,
+                  ads_mapfile_serialize_f serialize)
+{
+  size_t count = ads_map_get_size(map);
+
+  size_t slots = 2;
+  while(slots < count * 2)
+    slots <<= 1;
+
+  ads_mapfile_record_t* records = calloc(count + 1, sizeof(ads_mapfile_record_t));
+  ads_mapfile_slot_t* table = calloc(slots, sizeof(ads_mapfile_slot_t));
+  char* tmp_path = malloc(strlen(path) + sizeof(".XXXXXX"));
+  FILE* out = NULL;
+  int created = 0;
+
+  ads_status_t status = ADS_NOMEM;
+  if(!records || !table || !tmp_path)
+    goto cleanup;
+
+  // collect the entries and place each record in the table
+  size_t n = 0, index = 0;
+  uint64_t offset = sizeof(ads_mapfile_header_t) + slots * sizeof(ads_mapfile_slot_t);
+
+  ads_dlist_t* bucket = NULL;
+  while((bucket = ads_map_next_bucket(map, &index))) {
+    ads_dlist_node_t* node = ads_dlist_get_head(bucket);
+    for(; node; node = ads_dlist_get_next(node), n++) {
+      ads_mapfile_record_t* record = &records[n];
+      record->entry = ads_dlist_get_data_as(node, ads_map_entry_t*);
+      ads_mapfile_serialize(record->entry, serialize, &record->value_size);
+
+      uint64_t hash;
+      if(key_type == ADS_MAPFILE_STRING) {
+        record->key_size = strlen(record->entry->key);
+        hash = ads_mapfile_hash_string(record->entry->key, record->key_size);
+      }
+      else
+        hash = ads_mapfile_hash_uint64((size_t) record->entry->key);
+
+      size_t slot = hash & (slots - 1);
+      while(table[slot].offset != 0)
+        slot = (slot + 1) & (slots - 1);
+
+      table[slot].hash   = hash;
+      table[slot].offset = offset;
+      offset += ads_mapfile_record_size(key_type, record);
+    }
+    index++;
+  }
+
+  ads_mapfile_header_t header = {
+    .magic        = ADS_MAPFILE_MAGIC,
+    .version      = ADS_MAPFILE_VERSION,
+    .key_type     = key_type,
+    .size         = count,
+    .slots        = slots,
+    .slots_offset = sizeof(ads_mapfile_header_t),
+    .file_size    = offset
+  };
+
+  /* a name of its own in the same directory, so concurrent writers of `path` never share the
+     temporary file and rename doesn't cross file systems */
+  status = ADS_IOERROR;
+  sprintf(tmp_path, "%s.XXXXXX", path);
+  int fd = mkstemp(tmp_path);
+  if(fd < 0)
+    goto cleanup;
+
+  created = 1;
+  if(fchmod(fd, 0644) != 0 || !(out = fdopen(fd, "wb"))) {
+    close(fd);
+    goto cleanup;
+  }
+
+  if(fwrite(&header, sizeof(header), 1, out) != 1 ||
+     fwrite(table, sizeof(ads_mapfile_slot_t), slots, out) != slots)
+    goto cleanup;
+
+  status = ads_mapfile_write_records(out, key_type, serialize, records, count);
+  if(status != ADS_SUCCESS)
+    goto cleanup;
+
+  status = ADS_IOERROR;
+
+  int failed = fflush(out) != 0 || fsync(fileno(out)) != 0;
+  failed |= fclose(out) != 0;
+  out = NULL;
+
+  if(failed || rename(tmp_path, path) != 0)
+    goto cleanup;
+
+  status = ADS_SUCCESS;
+
+cleanup:
+  if(out)
+    fclose(out);
+  if(status != ADS_SUCCESS && created)
+    remove(tmp_path);
+
+  free(records);
+  free(table);
+  free(tmp_path);
+
+  return status;
+}
+
+/* ----- READ ----- */
+
+ads_status_t ads_mapfile_open(ads_mapfile_t* file, const char* path) {
+  int fd = open(path, O_RDONLY);
+  if(fd < 0)
+    return ADS_IOERROR;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    return ADS_IOERROR;
+  }
+
+  if((size_t) st.st_size < sizeof(ads_mapfile_header_t)) {
+    close(fd);
+    return ADS_INVALID;
+  }
+
+  // the mapping stays valid after closing the descriptor
+  void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED)
+    return ADS_IOERROR;
+
+  const ads_mapfile_header_t* header = base;
+  int valid = memcmp(header->magic, ADS_MAPFILE_MAGIC, sizeof(header->magic)) == 0
+           && header->version == ADS_MAPFILE_VERSION
+           && (header->key_type == ADS_MAPFILE_STRING || header->key_type == ADS_MAPFILE_UINT64)
+           && header->file_size == (uint64_t) st.st_size
+           && header->slots > 0 && (header->slots & (header->slots - 1)) == 0
+           && header->size < header->slots
+           // the table must fit in the file, written so that nothing can overflow
+           && header->slots_offset % sizeof(uint64_t) == 0
+           && header->slots_offset <= header->file_size
+           && header->slots <= (header->file_size - header->slots_offset) / sizeof(ads_mapfile_slot_t);
+
+  if(!valid) {
+    munmap(base, st.st_size);
+    return ADS_INVALID;
+  }
+
+  file->base      = base;
+  file->file_size = st.st_size;
+  file->size      = header->size;
+  file->slots     = header->slots;
+  file->key_type  = header->key_type;
+  file->table     = (const ads_mapfile_slot_t*) ((const char*) base + header->slots_offset);
+
+  return ADS_SUCCESS;
+}
+
+void ads_mapfile_close(ads_mapfile_t* file) {
+  if(file->base)
+    munmap((void*) file->base, file->file_size);
+
+  memset(file, 0, sizeof(ads_mapfile_t));
+}
+
+// record of a slot, NULL if its offset points outside the file
+static inline const char*
+ads_mapfile_get_record(const ads_mapfile_t* file, const ads_mapfile_slot_t* slot) {
+  if(slot->offset > file->file_size - 2 * sizeof(uint64_t))
+    return NULL;
+  return file->base + slot->offset;
+}
+
+static inline const void*
+ads_mapfile_get_value(const ads_mapfile_t* file, const char* value, size_t* value_size, uint64_t size) {
+  if(size > file->file_size || (size_t) (value - file->base) > file->file_size - size)
+    return NULL;
+
+  if(value_size) *value_size = size;
+  return value;
+}
+
+const void* ads_mapfile_get_string(const ads_mapfile_t* file, const char* key, size_t* value_size) {
+  if(file->key_type != ADS_MAPFILE_STRING)
+    return NULL;
+
+  size_t key_size = strlen(key);
+  uint64_t hash = ads_mapfile_hash_string(key, key_size);
+
+  size_t mask = file->slots - 1;
+  size_t probes = 0; // bounded, in case the file is corrupted and has no empty slot
+  for(size_t slot = hash & mask; file->table[slot].offset != 0 && probes < file->slots; slot = (slot + 1) & mask, probes++) {
+    if(file->table[slot].hash != hash)
+      continue;
+
+    const char* record = ads_mapfile_get_record(file, &file->table[slot]);
+    if(!record || ads_mapfile_read_u64(record) != key_size)
+      continue;
+
+    const char* record_key = record + 2 * sizeof(uint64_t);
+    if((size_t) (record_key - file->base) + key_size >= file->file_size)
+      continue;
+
+    if(memcmp(record_key, key, key_size) == 0)
+      return ads_mapfile_get_value(file, record_key + key_size + 1, value_size,
+                                   ads_mapfile_read_u64(record + sizeof(uint64_t)));
+  }
+
+  return NULL;
+}
+
+const void* ads_mapfile_get_uint64(const ads_mapfile_t* file, uint64_t key, size_t* value_size) {
+  if(file->key_type != ADS_MAPFILE_UINT64)
+    return NULL;
+
+  uint64_t hash = ads_mapfile_hash_uint64(key);
+
+  size_t mask = file->slots - 1;
+  size_t probes = 0;
+  for(size_t slot = hash & mask; file->table[slot].offset != 0 && probes < file->slots; slot = (slot + 1) & mask, probes++) {
+    if(file->table[slot].hash != hash)
+      continue;
+
+    const char* record = ads_mapfile_get_record(file, &file->table[slot]);
+    if(record && ads_mapfile_read_u64(record) == key)
+      return ads_mapfile_get_value(file, record + 2 * sizeof(uint64_t), value_size,
+                                   ads_mapfile_read_u64(record + sizeof(uint64_t)));
+  }
+
+  return NULL;
+}
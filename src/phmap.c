@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/phmap.h"
+
+#define ADS_PHMAP_MAX_SEEDS 16 // a build retries with another seed when a group can't be placed
+
+// MurmurHash3 finalizer
+static inline size_t
+ads_phmap_mix(size_t hash) {
+  hash ^= (hash >> 33);
+  hash *= 0xff51afd7ed558ccd;
+  hash ^= (hash >> 33);
+  hash *= 0xc4ceb9fe1a85ec53;
+  hash ^= (hash >> 33);
+
+  return hash;
+}
+
+static inline size_t
+ads_phmap_group_of(size_t hash, size_t seed, size_t groups) {
+  return ads_phmap_mix(hash ^ seed) % groups;
+}
+
+static inline size_t
+ads_phmap_slot_of(size_t hash, size_t seed, uint32_t displacement, size_t size) {
+  return ads_phmap_mix(hash ^ seed ^ ((size_t) displacement + 1) * 0x9e3779b97f4a7c15) % size;
+}
+
+/* ----- BUILD ----- */
+
+typedef struct ads_phmap_build {
+  ads_map_entry_t* entries;
+  size_t count;
+
+  size_t* order;        // entries indexes, grouped
+  size_t* group_start;  // first position in `order` of each group (+1 sentinel)
+  size_t* group_order;  // groups, biggest first
+  uint64_t* taken;      // bitmap of the slots already given to a key
+  size_t* positions;    // slots of the group being placed
+} ads_phmap_build_t;
+
+#define ads_phmap_is_taken(taken, i) ((taken)[(i) / 64] & ((uint64_t) 1 << ((i) % 64)))
+#define ads_phmap_set_taken(taken, i) ((taken)[(i) / 64] |= ((uint64_t) 1 << ((i) % 64)))
+
+// counting sort of the entries by group and of the groups by size; returns the biggest group size
+static size_t
+ads_phmap_group_entries(ads_phmap_t* phmap, ads_phmap_build_t* b) {
+  size_t* group_start = b->group_start;
+  memset(group_start, 0, (phmap->groups + 1) * sizeof(size_t));
+
+  for(size_t i = 0; i < b->count; i++)
+    group_start[ads_phmap_group_of(b->entries[i].hash, phmap->seed, phmap->groups) + 1]++;
+
+  size_t max_group = 0;
+  for(size_t g = 0; g < phmap->groups; g++) {
+    if(group_start[g + 1] > max_group)
+      max_group = group_start[g + 1];
+    group_start[g + 1] += group_start[g];
+  }
+
+  // group_order is used as a cursor per group while filling `order`
+  memcpy(b->group_order, group_start, phmap->groups * sizeof(size_t));
+  for(size_t i = 0; i < b->count; i++) {
+    size_t g = ads_phmap_group_of(b->entries[i].hash, phmap->seed, phmap->groups);
+    b->order[b->group_order[g]++] = i;
+  }
+
+  // groups by decreasing size: the big ones are placed while the table is still empty
+  size_t next = 0;
+  for(size_t size = max_group; size > 0; size--) {
+    for(size_t g = 0; g < phmap->groups; g++) {
+      if(group_start[g + 1] - group_start[g] == size)
+        b->group_order[next++] = g;
+    }
+  }
+
+  return max_group;
+}
+
+// find a displacement for every group; 0 if some group couldn't be placed with this seed
+static int
+ads_phmap_place_groups(ads_phmap_t* phmap, ads_phmap_build_t* b, size_t non_empty_groups) {
+  uint32_t max_displacement = b->count * 64 + 1024 < UINT32_MAX ? b->count * 64 + 1024 : UINT32_MAX;
+  memset(b->taken, 0, ((b->count + 63) / 64) * sizeof(uint64_t));
+
+  for(size_t i = 0; i < non_empty_groups; i++) {
+    size_t g = b->group_order[i];
+    size_t first = b->group_start[g], size = b->group_start[g + 1] - first;
+
+    uint32_t d;
+    for(d = 0; d < max_displacement; d++) {
+      size_t k;
+      for(k = 0; k < size; k++) {
+        size_t slot = ads_phmap_slot_of(b->entries[b->order[first + k]].hash, phmap->seed, d, phmap->size);
+        if(ads_phmap_is_taken(b->taken, slot))
+          break;
+
+        // two keys of the same group can't share a slot either
+        size_t j;
+        for(j = 0; j < k && b->positions[j] != slot; j++);
+        if(j < k)
+          break;
+
+        b->positions[k] = slot;
+      }
+
+      if(k == size)
+        break;
+    }
+
+    if(d == max_displacement)
+      return 0;
+
+    phmap->displacements[g] = d;
+    for(size_t k = 0; k < size; k++)
+      ads_phmap_set_taken(b->taken, b->positions[k]);
+  }
+
+  return 1;
+}
+
+// keys with the same hash always land in the same group and slot, whatever the displacement
+static int
+ads_phmap_has_equal_hashes(ads_phmap_t* phmap, ads_phmap_build_t* b) {
+  for(size_t g = 0; g < phmap->groups; g++) {
+    for(size_t i = b->group_start[g]; i < b->group_start[g + 1]; i++) {
+      for(size_t j = i + 1; j < b->group_start[g + 1]; j++) {
+        if(b->entries[b->order[i]].hash == b->entries[b->order[j]].hash)
+          return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+// an empty map, left behind by a failed build so that ads_phmap_get/destroy stay safe
+static void
+ads_phmap_clear(ads_phmap_t* phmap) {
+  phmap->block         = NULL;
+  phmap->displacements = NULL;
+  phmap->slots         = NULL;
+  phmap->size          = 0;
+  phmap->groups        = 0;
+}
+
+// bytes of the displacements, padded so that the slots after them are aligned
+static inline size_t
+ads_phmap_displacements_size(size_t groups) {
+  size_t size = groups * sizeof(uint32_t);
+  return size + (sizeof(ads_map_entry_t) - size % sizeof(ads_map_entry_t)) % sizeof(ads_map_entry_t);
+}
+
+// the +1 keeps an empty map from asking for 0 bytes
+#define ads_phmap_block_size(phmap) \
+  (ads_phmap_displacements_size((phmap)->groups) + (phmap)->size * sizeof(ads_map_entry_t) + 1)
+
+/* the scratch buffers of the build are freed before it returns, so they stay on malloc: only
+   the block, which lives as long as the map, comes from its allocator */
+static ads_status_t
+ads_phmap_build_entries(ads_phmap_t* phmap, ads_map_entry_t* entries, size_t count) {
+  phmap->size   = count;
+  phmap->groups = count / ADS_PHMAP_GROUP_SIZE + 1;
+
+  // displacements first, then the slots (aligned)
+  size_t displacements_size = ads_phmap_displacements_size(phmap->groups);
+
+  phmap->block = ads_alloc(phmap->allocator, ads_phmap_block_size(phmap));
+  if(!phmap->block) {
+    ads_phmap_clear(phmap);
+    return ADS_NOMEM;
+  }
+
+  phmap->displacements = phmap->block;
+  phmap->slots = (ads_map_entry_t*) ((char*) phmap->block + displacements_size);
+
+  ads_phmap_build_t b = {
+    .entries     = entries,
+    .count       = count,
+    .order       = malloc(count * sizeof(size_t) + 1),
+    .group_start = malloc((phmap->groups + 1) * sizeof(size_t)),
+    .group_order = malloc(phmap->groups * sizeof(size_t)),
+    .taken       = malloc(((count + 63) / 64) * sizeof(uint64_t) + 1),
+    .positions   = NULL
+  };
+
+  ads_status_t status = ADS_NOMEM;
+  if(!b.order || !b.group_start || !b.group_order || !b.taken)
+    goto cleanup;
+
+  int placed = 0;
+  for(size_t attempt = 0; attempt < ADS_PHMAP_MAX_SEEDS && !placed; attempt++) {
+    phmap->seed = attempt * 0x9e3779b97f4a7c15;
+
+    size_t max_group = ads_phmap_group_entries(phmap, &b);
+    if(attempt == 0) {
+      status = ADS_INVALID;
+      if(ads_phmap_has_equal_hashes(phmap, &b))
+        goto cleanup;
+
+      status = ADS_NOMEM;
+      b.positions = malloc(max_group * sizeof(size_t) + 1);
+      if(!b.positions)
+        goto cleanup;
+    }
+    else {
+      // the groups of a new seed may be bigger
+      size_t* positions = realloc(b.positions, max_group * sizeof(size_t) + 1);
+      if(!positions)
+        goto cleanup;
+      b.positions = positions;
+    }
+
+    size_t non_empty_groups = 0;
+    for(size_t g = 0; g < phmap->groups; g++)
+      non_empty_groups += b.group_start[g + 1] != b.group_start[g];
+
+    memset(phmap->displacements, 0, phmap->groups * sizeof(uint32_t));
+    placed = ads_phmap_place_groups(phmap, &b, non_empty_groups);
+  }
+
+  status = ADS_INVALID;
+  if(!placed)
+    goto cleanup;
+
+  for(size_t i = 0; i < count; i++) {
+    size_t g = ads_phmap_group_of(entries[i].hash, phmap->seed, phmap->groups);
+    size_t slot = ads_phmap_slot_of(entries[i].hash, phmap->seed, phmap->displacements[g], phmap->size);
+    phmap->slots[slot] = entries[i];
+  }
+  status = ADS_SUCCESS;
+
+cleanup:
+  free(b.order);
+  free(b.group_start);
+  free(b.group_order);
+  free(b.taken);
+  free(b.positions);
+
+  if(status != ADS_SUCCESS) {
+    ads_free(phmap->allocator, phmap->block, ads_phmap_block_size(phmap));
+    ads_phmap_clear(phmap);
+  }
+
+  return status;
+}
+
+ads_status_t
+ads_phmap_build(ads_phmap_t* phmap,
+                void**       keys,
+                void**       values,
+                size_t       count,
+                void   (*destroy)(void* value),
+                int    (*compare)(void* key1, void* key2),
+                size_t (*hash)(void* key))
+{
+  return ads_phmap_build_allocator(phmap, keys, values, count, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_phmap_build_allocator(ads_phmap_t* phmap,
+                          void**       keys,
+                          void**       values,
+                          size_t       count,
+                          const ads_allocator_t* allocator,
+                          void   (*destroy)(void* value),
+                          int    (*compare)(void* key1, void* key2),
+                          size_t (*hash)(void* key))
+{
+  phmap->allocator = allocator ? allocator : ads_allocator_get_default();
+  phmap->destroy   = destroy;
+  phmap->compare   = compare;
+  phmap->hash      = hash;
+
+  ads_map_entry_t* entries = malloc(count * sizeof(ads_map_entry_t) + 1);
+  if(!entries) {
+    ads_phmap_clear(phmap);
+    return ADS_NOMEM;
+  }
+
+  for(size_t i = 0; i < count; i++) {
+    entries[i].key   = keys[i];
+    entries[i].value = values[i];
+    entries[i].hash  = hash(keys[i]);
+  }
+
+  ads_status_t status = ads_phmap_build_entries(phmap, entries, count);
+  free(entries);
+
+  return status;
+}
+
+ads_status_t ads_phmap_build_from_map(ads_phmap_t* phmap, ads_map_t* map) {
+  phmap->allocator = map->allocator;
+  phmap->destroy   = NULL; // the values still belong to `map`
+  phmap->compare   = map->compare;
+  phmap->hash      = map->hash;
+
+  ads_map_entry_t* entries = malloc(ads_map_get_size(map) * sizeof(ads_map_entry_t) + 1);
+  if(!entries) {
+    ads_phmap_clear(phmap);
+    return ADS_NOMEM;
+  }
+
+  // the cached hashes of the entries are reused, `hash` isn't called
+  size_t count = 0, index = 0;
+  ads_dlist_t* bucket = NULL;
+  while((bucket = ads_map_next_bucket(map, &index))) {
+    ads_dlist_node_t* node = ads_dlist_get_head(bucket);
+    for(; node; node = ads_dlist_get_next(node))
+      entries[count++] = *ads_dlist_get_data_as(node, ads_map_entry_t*);
+    index++;
+  }
+
+  ads_status_t status = ads_phmap_build_entries(phmap, entries, count);
+  free(entries);
+
+  return status;
+}
+
+/* ---------- */
+
+void ads_phmap_destroy(ads_phmap_t* phmap) {
+  if(phmap->destroy) {
+    for(size_t i = 0; i < phmap->size; i++)
+      phmap->destroy(phmap->slots[i].value);
+  }
+
+  ads_free(phmap->allocator, phmap->block, ads_phmap_block_size(phmap));
+  memset(phmap, 0, sizeof(ads_phmap_t));
+}
+
+ads_map_entry_t* ads_phmap_get(const ads_phmap_t* phmap, void* key, void** out) {
+  if(phmap->size == 0)
+    return NULL;
+
+  size_t hash = phmap->hash(key);
+  uint32_t displacement = phmap->displacements[ads_phmap_group_of(hash, phmap->seed, phmap->groups)];
+
+  // a key that isn't in the map still lands on some slot: the cached hash rejects it cheaply
+  ads_map_entry_t* entry = &phmap->slots[ads_phmap_slot_of(hash, phmap->seed, displacement, phmap->size)];
+  if(entry->hash != hash || !phmap->compare(key, entry->key))
+    return NULL;
+
+  if(out) *out = entry->value;
+  return entry;
+}
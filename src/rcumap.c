@@ -0,0 +1,366 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+#include "../include/rcumap.h"
+
+#define ads_rcumap_index_of(hash, buckets) ((hash) % (buckets))
+
+#define ads_rcumap_table_size(buckets) \
+  (sizeof(ads_rcumap_table_t) + (buckets) * sizeof(_Atomic(ads_rcumap_node_t*)))
+
+static ads_rcumap_table_t*
+ads_rcumap_create_table(ads_rcumap_t* map, size_t buckets) {
+  ads_rcumap_table_t* table = ads_calloc(map->allocator, 1, ads_rcumap_table_size(buckets));
+  if(table) {
+    table->buckets = buckets;
+    for(size_t i = 0; i < buckets; i++)
+      atomic_init(&table->htable[i], NULL);
+  }
+
+  return table;
+}
+
+static ads_rcumap_node_t*
+ads_rcumap_create_node(ads_rcumap_t* map, void* key, void* value, size_t hash, ads_rcumap_node_t* next) {
+  ads_rcumap_node_t* node = ads_calloc(map->allocator, 1, sizeof(ads_rcumap_node_t));
+  if(node) {
+    atomic_init(&node->next, next);
+    node->key   = key;
+    node->value = value;
+    node->hash  = hash;
+  }
+
+  return node;
+}
+
+// free the nodes still linked in a table, but not their values (they were moved to another table)
+static void
+ads_rcumap_free_table(ads_rcumap_t* map, ads_rcumap_table_t* table) {
+  for(size_t i = 0; i < table->buckets; i++) {
+    ads_rcumap_node_t* node = atomic_load_explicit(&table->htable[i], memory_order_relaxed);
+    while(node) {
+      ads_rcumap_node_t* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+      ads_free(map->allocator, node, sizeof(ads_rcumap_node_t));
+      node = next;
+    }
+  }
+
+  ads_free(map->allocator, table, ads_rcumap_table_size(table->buckets));
+}
+
+ads_status_t
+ads_rcumap_init(ads_rcumap_t* map,
+                size_t buckets,
+                size_t max_readers,
+                void   (*destroy)(void* value),
+                int    (*compare)(void* key1, void* key2),
+                size_t (*hash)(void* key))
+{
+  return ads_rcumap_init_allocator(map, buckets, max_readers, NULL, destroy, compare, hash);
+}
+
+ads_status_t
+ads_rcumap_init_allocator(ads_rcumap_t* map,
+                          size_t buckets,
+                          size_t max_readers,
+                          const ads_allocator_t* allocator,
+                          void   (*destroy)(void* value),
+                          int    (*compare)(void* key1, void* key2),
+                          size_t (*hash)(void* key))
+{
+  // without a reader slot the map could never be read
+  if(max_readers == 0)
+    return ADS_INVALID;
+
+  if(buckets == 0)
+    buckets = 1;
+
+  map->allocator = allocator ? allocator : ads_allocator_get_default();
+  ads_rcumap_table_t* table = ads_rcumap_create_table(map, buckets);
+  if(!table)
+    return ADS_NOMEM;
+
+  size_t readers_size = max_readers * sizeof(ads_rcumap_reader_t);
+  map->readers = ads_alloc_aligned(map->allocator, readers_size, ADS_RCUMAP_CACHE_LINE);
+  if(!map->readers) {
+    ads_free(map->allocator, table, ads_rcumap_table_size(buckets));
+    return ADS_NOMEM;
+  }
+
+  for(size_t i = 0; i < max_readers; i++) {
+    atomic_init(&map->readers[i].epoch, 0);
+    atomic_init(&map->readers[i].in_use, 0);
+    map->readers[i].map = map;
+  }
+
+  if(pthread_mutex_init(&map->write_lock, NULL) != 0) {
+    ads_free(map->allocator, map->readers, readers_size);
+    ads_free(map->allocator, table, ads_rcumap_table_size(buckets));
+    return ADS_NOMEM;
+  }
+
+  atomic_init(&map->table, table);
+  atomic_init(&map->epoch, 1);
+  map->max_readers = max_readers;
+
+  map->compare = compare;
+  map->hash    = hash;
+  map->destroy = destroy;
+
+  map->size = 0;
+  map->retired_nodes  = NULL;
+  map->retired_tables = NULL;
+
+  return ADS_SUCCESS;
+}
+
+/* ----- RECLAMATION ----- */
+
+static inline size_t
+ads_rcumap_retire_epoch(ads_rcumap_t* map) {
+  // readers that announce the new epoch started after the unlink and can't see the memory
+  return atomic_fetch_add(&map->epoch, 1);
+}
+
+static void
+ads_rcumap_retire_node(ads_rcumap_t* map, ads_rcumap_node_t* node, int destroy_value) {
+  node->destroy_value = destroy_value;
+  node->retired_epoch = ads_rcumap_retire_epoch(map);
+  node->retired_next  = map->retired_nodes;
+  map->retired_nodes  = node;
+}
+
+static void
+ads_rcumap_retire_table(ads_rcumap_t* map, ads_rcumap_table_t* table) {
+  table->retired_epoch = ads_rcumap_retire_epoch(map);
+  table->retired_next  = map->retired_tables;
+  map->retired_tables  = table;
+}
+
+// oldest epoch a reader is currently reading at
+static size_t
+ads_rcumap_min_reader_epoch(ads_rcumap_t* map) {
+  size_t min_epoch = SIZE_MAX;
+
+  atomic_thread_fence(memory_order_seq_cst);
+  for(size_t i = 0; i < map->max_readers; i++) {
+    size_t epoch = atomic_load(&map->readers[i].epoch);
+    if(epoch != 0 && epoch < min_epoch)
+      min_epoch = epoch;
+  }
+
+  return min_epoch;
+}
+
+// free the retired memory no reader can see anymore; called with write_lock held
+static void
+ads_rcumap_reclaim(ads_rcumap_t* map) {
+  if(!map->retired_nodes && !map->retired_tables)
+    return;
+
+  size_t min_epoch = ads_rcumap_min_reader_epoch(map);
+
+  ads_rcumap_node_t** node_ref = &map->retired_nodes;
+  while(*node_ref) {
+    ads_rcumap_node_t* node = *node_ref;
+    if(node->retired_epoch < min_epoch) {
+      *node_ref = node->retired_next;
+      if(node->destroy_value && map->destroy)
+        map->destroy(node->value);
+      ads_free(map->allocator, node, sizeof(ads_rcumap_node_t));
+    }
+    else
+      node_ref = &node->retired_next;
+  }
+
+  ads_rcumap_table_t** table_ref = &map->retired_tables;
+  while(*table_ref) {
+    ads_rcumap_table_t* table = *table_ref;
+    if(table->retired_epoch < min_epoch) {
+      *table_ref = table->retired_next;
+      ads_rcumap_free_table(map, table);
+    }
+    else
+      table_ref = &table->retired_next;
+  }
+}
+
+void ads_rcumap_synchronize(ads_rcumap_t* map) {
+  for(;;) {
+    pthread_mutex_lock(&map->write_lock);
+    ads_rcumap_reclaim(map);
+    int done = !map->retired_nodes && !map->retired_tables;
+    pthread_mutex_unlock(&map->write_lock);
+
+    if(done)
+      break;
+    sched_yield();
+  }
+}
+
+void ads_rcumap_destroy(ads_rcumap_t* map) {
+  ads_rcumap_synchronize(map);
+
+  ads_rcumap_table_t* table = atomic_load(&map->table);
+  for(size_t i = 0; i < table->buckets && map->destroy; i++) {
+    ads_rcumap_node_t* node = atomic_load_explicit(&table->htable[i], memory_order_relaxed);
+    for(; node; node = atomic_load_explicit(&node->next, memory_order_relaxed))
+      map->destroy(node->value);
+  }
+
+  ads_rcumap_free_table(map, table);
+  ads_free(map->allocator, map->readers, map->max_readers * sizeof(ads_rcumap_reader_t));
+  pthread_mutex_destroy(&map->write_lock);
+}
+
+/* ----- READERS ----- */
+
+ads_rcumap_reader_t* ads_rcumap_reader_register(ads_rcumap_t* map) {
+  for(size_t i = 0; i < map->max_readers; i++) {
+    int expected = 0;
+    if(atomic_compare_exchange_strong(&map->readers[i].in_use, &expected, 1))
+      return &map->readers[i];
+  }
+
+  return NULL;
+}
+
+void ads_rcumap_reader_unregister(ads_rcumap_reader_t* reader) {
+  atomic_store(&reader->epoch, 0);
+  atomic_store(&reader->in_use, 0);
+}
+
+void ads_rcumap_read_lock(ads_rcumap_reader_t* reader) {
+  size_t epoch = atomic_load(&reader->map->epoch);
+  atomic_store_explicit(&reader->epoch, epoch, memory_order_relaxed);
+
+  // the announcement must be visible to writers before any pointer of the map is read
+  atomic_thread_fence(memory_order_seq_cst);
+}
+
+void ads_rcumap_read_unlock(ads_rcumap_reader_t* reader) {
+  atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+ads_status_t ads_rcumap_get(ads_rcumap_t* map, void* key, void** out) {
+  size_t hash = map->hash(key);
+
+  ads_rcumap_table_t* table = atomic_load_explicit(&map->table, memory_order_acquire);
+  _Atomic(ads_rcumap_node_t*)* bucket = &table->htable[ads_rcumap_index_of(hash, table->buckets)];
+
+  ads_rcumap_node_t* node = atomic_load_explicit(bucket, memory_order_acquire);
+  while(node) {
+    if(node->hash == hash && map->compare(key, node->key)) {
+      if(out) *out = node->value;
+      return ADS_SUCCESS;
+    }
+    node = atomic_load_explicit(&node->next, memory_order_acquire);
+  }
+
+  return ADS_NOTFOUND;
+}
+
+/* ----- WRITERS ----- */
+
+// link that points to the node holding `key` (or to the NULL ending its chain)
+static _Atomic(ads_rcumap_node_t*)*
+ads_rcumap_find_ref(ads_rcumap_t* map, ads_rcumap_table_t* table, void* key, size_t hash) {
+  _Atomic(ads_rcumap_node_t*)* ref = &table->htable[ads_rcumap_index_of(hash, table->buckets)];
+
+  ads_rcumap_node_t* node;
+  while((node = atomic_load_explicit(ref, memory_order_relaxed))) {
+    if(node->hash == hash && map->compare(key, node->key))
+      break;
+    ref = &node->next;
+  }
+
+  return ref;
+}
+
+// copy every node to a table twice as big and publish it; readers keep using the old one meanwhile
+static void
+ads_rcumap_grow(ads_rcumap_t* map, ads_rcumap_table_t* old) {
+  ads_rcumap_table_t* table = ads_rcumap_create_table(map, old->buckets * 2);
+  if(!table)
+    return; // keep the current table, the chains just get longer
+
+  for(size_t i = 0; i < old->buckets; i++) {
+    ads_rcumap_node_t* node = atomic_load_explicit(&old->htable[i], memory_order_relaxed);
+    for(; node; node = atomic_load_explicit(&node->next, memory_order_relaxed)) {
+      _Atomic(ads_rcumap_node_t*)* head = &table->htable[ads_rcumap_index_of(node->hash, table->buckets)];
+
+      ads_rcumap_node_t* copy = ads_rcumap_create_node(map, node->key, node->value, node->hash,
+                                                       atomic_load_explicit(head, memory_order_relaxed));
+      if(!copy) {
+        // the values belong to the old table's nodes, only the copies are released
+        ads_rcumap_free_table(map, table);
+        return;
+      }
+      atomic_store_explicit(head, copy, memory_order_relaxed);
+    }
+  }
+
+  atomic_store_explicit(&map->table, table, memory_order_release);
+  ads_rcumap_retire_table(map, old);
+}
+
+ads_status_t ads_rcumap_insert(ads_rcumap_t* map, void* key, void* value) {
+  size_t hash = map->hash(key);
+  ads_status_t status = ADS_SUCCESS;
+
+  pthread_mutex_lock(&map->write_lock);
+
+  ads_rcumap_table_t* table = atomic_load_explicit(&map->table, memory_order_relaxed);
+  _Atomic(ads_rcumap_node_t*)* ref = ads_rcumap_find_ref(map, table, key, hash);
+  ads_rcumap_node_t* old = atomic_load_explicit(ref, memory_order_relaxed);
+
+  // an update publishes a new node in place of the old one, readers may still be on the old one
+  ads_rcumap_node_t* next = old ? atomic_load_explicit(&old->next, memory_order_relaxed)
+                                : atomic_load_explicit(&table->htable[ads_rcumap_index_of(hash, table->buckets)],
+                                                       memory_order_relaxed);
+  ads_rcumap_node_t* node = ads_rcumap_create_node(map, key, value, hash, next);
+  if(!node)
+    status = ADS_NOMEM;
+  else if(old) {
+    atomic_store_explicit(ref, node, memory_order_release);
+    ads_rcumap_retire_node(map, old, 1);
+  }
+  else {
+    atomic_store_explicit(&table->htable[ads_rcumap_index_of(hash, table->buckets)], node, memory_order_release);
+    if(++map->size > table->buckets * ADS_RCUMAP_MAX_LOAD_FACTOR)
+      ads_rcumap_grow(map, table);
+  }
+
+  ads_rcumap_reclaim(map);
+  pthread_mutex_unlock(&map->write_lock);
+
+  return status;
+}
+
+ads_status_t ads_rcumap_remove(ads_rcumap_t* map, void* key, void** out) {
+  size_t hash = map->hash(key);
+  ads_status_t status = ADS_SUCCESS;
+
+  pthread_mutex_lock(&map->write_lock);
+
+  ads_rcumap_table_t* table = atomic_load_explicit(&map->table, memory_order_relaxed);
+  _Atomic(ads_rcumap_node_t*)* ref = ads_rcumap_find_ref(map, table, key, hash);
+  ads_rcumap_node_t* node = atomic_load_explicit(ref, memory_order_relaxed);
+
+  if(!node)
+    status = ADS_NOTFOUND;
+  else {
+    // the node keeps its next pointer, so a reader standing on it can go on
+    atomic_store_explicit(ref, atomic_load_explicit(&node->next, memory_order_relaxed), memory_order_release);
+    map->size--;
+
+    if(out) *out = node->value;
+    ads_rcumap_retire_node(map, node, out == NULL);
+  }
+
+  ads_rcumap_reclaim(map);
+  pthread_mutex_unlock(&map->write_lock);
+
+  return status;
+}
@@ -16,15 +16,21 @@ ads_string_init_optimized(ads_string_t* str) {
   str->buf = str->basic_str;
 }
 
+// free the buffer of a string that isn't optimized
+static inline void
+ads_string_free_buf(ads_string_t* str) {
+  ads_free(str->allocator, str->buf, str->capacity + 1);
+}
+
 static inline char* 
 expand(ads_string_t* str, size_t new_capacity) {
 
-  char* new_buf = calloc(new_capacity + 1, sizeof(char));
+  char* new_buf = ads_calloc(str->allocator, new_capacity + 1, sizeof(char));
   if(new_buf) {
     memcpy(new_buf, str->buf, str->size + 1);
 
     if(!ads_string_is_optimized(str))
-      free(str->buf);
+      ads_string_free_buf(str);
 
     str->buf = new_buf;
     str->capacity = new_capacity;
@@ -51,20 +57,20 @@ ads_string_internal_copy(ads_string_t* restrict dest,
   // the size of src_buf' string is bigger than dest's capacity
   if(src_size > dest->capacity) {    
     // get a new region of memory that fits src_buf's string
-    char* new_buf = calloc(src_capacity + 1, sizeof(char));
+    char* new_buf = ads_calloc(dest->allocator, src_capacity + 1, sizeof(char));
     if(new_buf == NULL)
       return ADS_NOMEM;
 
     // if dest's string is in the free store(heap), we must free it before the assignment
     if(!ads_string_is_optimized(dest))
-      free(dest->buf);
+      ads_string_free_buf(dest);
 
     // points to the new region of memory that will store a copy of src_buf's string
     dest->buf = new_buf;
   }
   // dest is not optimized, but src_buf's string can be optimized (stored in dest->basic_str)
   else if(!ads_string_is_optimized(dest) && src_capacity == BASIC_SIZE) {
-    free(dest->buf);
+    ads_string_free_buf(dest);
     dest->buf = dest->basic_str;
   }
 
@@ -98,15 +104,27 @@ ads_string_concat_internal(ads_string_t* restrict dest,
 }
 
 void ads_string_clear(ads_string_t* str) {
+  const ads_allocator_t* allocator = str->allocator;
+
   if(!ads_string_is_optimized(str))
-    free(str->buf);
+    ads_string_free_buf(str);
 
   memset(str, 0, sizeof(ads_string_t));
+  str->allocator = allocator;
   ads_string_init_optimized(str);
 }
 
 ads_status_t ads_string_init(ads_string_t* restrict str, const char* restrict init_str) {
+  return ads_string_init_allocator(str, init_str, NULL);
+}
+
+ads_status_t
+ads_string_init_allocator(ads_string_t* restrict str,
+                          const char*   restrict init_str,
+                          const ads_allocator_t* allocator)
+{
   memset(str, 0, sizeof(ads_string_t));
+  str->allocator = allocator ? allocator : ads_allocator_get_default();
 
   if(init_str == NULL)
     init_str = "";
@@ -119,7 +137,7 @@ ads_status_t ads_string_init(ads_string_t* restrict str, const char* restrict in
   else {
     // string in the free store, alloc memory
     str->capacity = str->size;
-    str->buf = calloc(str->capacity + 1, sizeof(char)); // +1 = '\0'
+    str->buf = ads_calloc(str->allocator, str->capacity + 1, sizeof(char)); // +1 = '\0'
     if(!str->buf)
       return ADS_NOMEM;
   }
@@ -132,7 +150,7 @@ ads_status_t ads_string_init(ads_string_t* restrict str, const char* restrict in
 void ads_string_destroy(ads_string_t* str) {
   // if the string is stored in heap, free the memory
   if(!ads_string_is_optimized(str))
-    free(str->buf);
+    ads_string_free_buf(str);
 
   memset(str, 0, sizeof(ads_string_t));
 }
@@ -380,20 +398,23 @@ void ads_string_rtrim(ads_string_t* str) {
 static void
 ads_string_list_destroy(void* data) {
   ads_string_t* _data = data;
+  const ads_allocator_t* allocator = _data->allocator;
 
   ads_string_destroy(_data);
-  free(_data);
+  ads_free(allocator, _data, sizeof(ads_string_t));
 }
 
+// the pieces come from the allocator of the string being split
 static ads_string_t*
-ads_string_split_create_data(const char* str, size_t str_size) {
+ads_string_split_create_data(const ads_allocator_t* allocator, const char* str, size_t str_size) {
 
-  ads_string_t* data = calloc(1, sizeof(ads_string_t));
+  ads_string_t* data = ads_calloc(allocator, 1, sizeof(ads_string_t));
   if(data == NULL)
     goto nomem_err_1; // just return NULL
 
+  data->allocator = allocator;
   if(str_size > BASIC_SIZE) {
-    data->buf = calloc(str_size, sizeof(char));
+    data->buf = ads_calloc(allocator, str_size + 1, sizeof(char)); // +1 = '\0'
     if(data->buf == NULL)
       goto nomem_err_2; // free `data` and return NULL
     data->capacity = str_size;
@@ -409,7 +430,7 @@ ads_string_split_create_data(const char* str, size_t str_size) {
 
 // on error, go to one of these labels, free memory(if needed) and return NULL
 nomem_err_2:
-  free(data);
+  ads_free(allocator, data, sizeof(ads_string_t));
 nomem_err_1:
   return NULL;
 }
@@ -431,7 +452,7 @@ int ads_string_split(ads_string_t* str, const char* delimiter, ads_list_t* out)
     size_t found_size = found - save_str_buf;
 
     // create an ads_string_t to be pushed into the list
-    data = ads_string_split_create_data(save_str_buf, found_size);
+    data = ads_string_split_create_data(str->allocator, save_str_buf, found_size);
     if(data == NULL)
       return -1;
 
@@ -443,7 +464,7 @@ int ads_string_split(ads_string_t* str, const char* delimiter, ads_list_t* out)
   size_t rest_size = str->size - (save_str_buf - str->buf);
   if(rest_size > 0 && rest_size != str->size) {
     // create an ads_string_t to be pushed into the list
-    data = ads_string_split_create_data(save_str_buf, rest_size);
+    data = ads_string_split_create_data(str->allocator, save_str_buf, rest_size);
     if(data == NULL)
       return -1;
 
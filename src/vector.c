@@ -1,37 +1,209 @@
+#define _GNU_SOURCE // mremap
 #include <stdlib.h>
 #include <memory.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "../include/vector.h"
 
-#define ADS_VECTOR_PRE_ALLOCATE 4
+/* ----- BUFFER MANAGEMENT ----- */
+
+/*
+  every change of capacity goes through ads_vector_set_capacity. Buffers below
+  ADS_VECTOR_MMAP_THRESHOLD bytes come from the vector's allocator; with the std allocator,
+  larger ones are mapped directly, so growing them with mremap moves page table entries
+  instead of copying the elements.
+  The inline storage of ads_vector_init_inline is used whenever the capacity fits in it, and
+  is never freed or reallocated.
+
+  realloc can't keep an alignment stronger than malloc's, so aligned vectors take a new
+  aligned buffer from the allocator and copy the elements instead. Mapped buffers are page
+  aligned.
+*/
+
+#ifdef MREMAP_MAYMOVE
+#define ADS_VECTOR_CAN_MAP 1
+#else
+#define ADS_VECTOR_CAN_MAP 0
+#endif
+
+static inline size_t
+ads_vector_map_size(size_t bytes) {
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  return (bytes + page - 1) / page * page;
+}
 
-static inline int
-double_capacity(ads_vector_t* vec)
-{
-  void* new_buf = realloc(vec->buf, (vec->capacity * vec->data_size) * 2);
-  if(new_buf == NULL)
-    return 0;
+// heap buffer of `bytes` bytes, with the vector's alignment
+static inline void*
+ads_vector_alloc(const ads_vector_t* vec, size_t bytes) {
+  return ads_alloc_aligned(vec->allocator, bytes, vec->alignment);
+}
+
+// heap buffer currently in use, neither mapped nor inline
+static inline void
+ads_vector_free_heap(ads_vector_t* vec) {
+  ads_free(vec->allocator, vec->buf, vec->capacity * vec->data_size);
+}
+
+static inline void
+ads_vector_advise(const ads_vector_t* vec, void* buf, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+  if((vec->flags & ADS_VECTOR_HUGEPAGE) && bytes >= ADS_VECTOR_HUGEPAGE_THRESHOLD)
+    madvise(buf, bytes, MADV_HUGEPAGE); // only a hint, failing is harmless
+#else
+  (void) vec; (void) buf; (void) bytes;
+#endif
+}
+
+static void
+ads_vector_free_buffer(ads_vector_t* vec) {
+  if(vec->mapped)
+    munmap(vec->buf, ads_vector_map_size(vec->capacity * vec->data_size));
+  else if(!ads_vector_is_inline(vec))
+    ads_vector_free_heap(vec);
+
+  vec->buf      = NULL;
+  vec->capacity = 0;
+  vec->mapped   = 0;
+}
+
+static ads_status_t
+ads_vector_set_capacity(ads_vector_t* vec, size_t capacity) {
+  size_t bytes = capacity * vec->data_size;
+  size_t used  = vec->size * vec->data_size;
+  void* buf;
+
+  // also when shrunk to nothing: the storage is there anyway, and never released
+  if(vec->inline_buf && capacity <= vec->inline_capacity) {
+    if(!ads_vector_is_inline(vec)) {
+      // back to the caller's storage
+      if(used)
+        memcpy(vec->inline_buf, vec->buf, used);
+      ads_vector_free_buffer(vec);
+      vec->buf = vec->inline_buf;
+    }
+
+    vec->capacity = vec->inline_capacity;
+    return ADS_SUCCESS;
+  }
+
+  if(capacity == 0) {
+    ads_vector_free_buffer(vec);
+    return ADS_SUCCESS;
+  }
+
+  if(ADS_VECTOR_CAN_MAP && bytes >= ADS_VECTOR_MMAP_THRESHOLD && vec->allocator == &ads_allocator_std) {
+    if(vec->mapped) {
+      buf = mremap(vec->buf, ads_vector_map_size(vec->capacity * vec->data_size),
+                   ads_vector_map_size(bytes), MREMAP_MAYMOVE);
+      if(buf == MAP_FAILED)
+        return ADS_NOMEM;
+
+      ads_vector_advise(vec, buf, ads_vector_map_size(bytes));
+    }
+    else {
+      // crossing the threshold: the elements are copied one last time
+      buf = mmap(NULL, ads_vector_map_size(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(buf == MAP_FAILED)
+        return ADS_NOMEM;
+
+      // before the copy, so the first touch already faults in huge pages
+      ads_vector_advise(vec, buf, ads_vector_map_size(bytes));
+
+      if(used)
+        memcpy(buf, vec->buf, used);
+      if(!ads_vector_is_inline(vec))
+        ads_vector_free_heap(vec);
+    }
+
+    vec->mapped = 1;
+  }
+  else if(vec->mapped) {
+    // shrinking below the threshold
+    buf = ads_vector_alloc(vec, bytes);
+    if(buf == NULL)
+      return ADS_NOMEM;
+
+    memcpy(buf, vec->buf, used);
+    ads_vector_free_buffer(vec);
+  }
+  else if(ads_vector_is_inline(vec)) {
+    // spilling to the heap
+    buf = ads_vector_alloc(vec, bytes);
+    if(buf == NULL)
+      return ADS_NOMEM;
+
+    if(used)
+      memcpy(buf, vec->buf, used);
+  }
+  else if(vec->alignment) {
+    buf = ads_vector_alloc(vec, bytes);
+    if(buf == NULL)
+      return ADS_NOMEM;
+
+    if(used)
+      memcpy(buf, vec->buf, used);
+    ads_vector_free_heap(vec);
+  }
+  else {
+    buf = ads_realloc(vec->allocator, vec->buf, vec->capacity * vec->data_size, bytes);
+    if(buf == NULL)
+      return ADS_NOMEM;
+  }
+
+  vec->buf = buf;
+  vec->capacity = capacity;
+
+  return ADS_SUCCESS;
+}
+
+// make room for `needed` elements, growing by the vector's growth factor
+static inline ads_status_t
+ads_vector_grow(ads_vector_t* vec, size_t needed) {
+  if(needed <= vec->capacity)
+    return ADS_SUCCESS;
 
-  vec->buf = new_buf;
-  vec->capacity *= 2;
+  size_t capacity = (size_t) (vec->capacity * vec->growth_factor);
+  if(capacity <= vec->capacity)
+    capacity = vec->capacity + 1;
+  if(capacity < needed)
+    capacity = needed;
 
-  return 1;
+  return ads_vector_set_capacity(vec, capacity);
 }
 
+/* ---------- */
+
 ads_status_t
 ads_vector_init(ads_vector_t*        vec,
                 size_t               data_size,
                 ads_vector_copy_f    copy,
                 ads_vector_destroy_f destroy)
 {
+  return ads_vector_init_capacity(vec, data_size, ADS_VECTOR_PRE_ALLOCATE, ADS_VECTOR_GROWTH_FACTOR, copy, destroy);
+}
 
-  // pre-allocate ADS_VECTOR_PRE_ALLOCATE elements of size = data_size
-  vec->buf = calloc(ADS_VECTOR_PRE_ALLOCATE, data_size);
-  if(vec->buf == NULL)
-    return ADS_NOMEM;
-
+ads_status_t
+ads_vector_init_capacity(ads_vector_t*        vec,
+                         size_t               data_size,
+                         size_t               capacity,
+                         double               growth_factor,
+                         ads_vector_copy_f    copy,
+                         ads_vector_destroy_f destroy)
+{
+  vec->buf = NULL;
   vec->data_size = data_size;
   vec->size = 0;
-  vec->capacity = ADS_VECTOR_PRE_ALLOCATE;
+  vec->capacity = 0;
+  vec->mapped = 0;
+  vec->allocator = ads_allocator_get_default();
+  vec->flags = 0;
+  vec->alignment = 0;
+  vec->inline_buf = NULL;
+  vec->inline_capacity = 0;
+  vec->growth_factor = growth_factor > 1.0 ? growth_factor : ADS_VECTOR_GROWTH_FACTOR;
+
+  if(ads_vector_set_capacity(vec, capacity) != ADS_SUCCESS)
+    return ADS_NOMEM;
 
   vec->copy = copy ? copy : memcpy;
   vec->destroy = destroy;
@@ -39,24 +211,100 @@ ads_vector_init(ads_vector_t*        vec,
   return ADS_SUCCESS;
 }
 
+ads_status_t
+ads_vector_init_allocator(ads_vector_t*          vec,
+                          size_t                 data_size,
+                          size_t                 capacity,
+                          const ads_allocator_t* allocator,
+                          ads_vector_copy_f      copy,
+                          ads_vector_destroy_f   destroy)
+{
+  if(ads_vector_init_capacity(vec, data_size, 0, ADS_VECTOR_GROWTH_FACTOR, copy, destroy) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  if(allocator)
+    vec->allocator = allocator;
+
+  return ads_vector_set_capacity(vec, capacity);
+}
+
+ads_status_t
+ads_vector_init_aligned(ads_vector_t*        vec,
+                        size_t               data_size,
+                        size_t               capacity,
+                        size_t               alignment,
+                        int                  flags,
+                        ads_vector_copy_f    copy,
+                        ads_vector_destroy_f destroy)
+{
+  // mapped buffers can't be aligned beyond a page
+  if(alignment == 0 || (alignment & (alignment - 1)) || alignment > (size_t) sysconf(_SC_PAGESIZE))
+    return ADS_INVALID;
+
+  if(ads_vector_init_capacity(vec, data_size, 0, ADS_VECTOR_GROWTH_FACTOR, copy, destroy) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  // aligned_alloc may reject an alignment below the size of a pointer
+  vec->alignment = alignment < sizeof(void*) ? sizeof(void*) : alignment;
+  vec->flags     = flags;
+
+  return ads_vector_set_capacity(vec, capacity);
+}
+
+ads_status_t
+ads_vector_init_inline(ads_vector_t*        vec,
+                       size_t               data_size,
+                       void*                storage,
+                       size_t               capacity,
+                       ads_vector_copy_f    copy,
+                       ads_vector_destroy_f destroy)
+{
+  if(ads_vector_init_capacity(vec, data_size, 0, ADS_VECTOR_GROWTH_FACTOR, copy, destroy) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  if(storage && capacity) {
+    vec->inline_buf      = storage;
+    vec->inline_capacity = capacity;
+    vec->buf             = storage;
+    vec->capacity        = capacity;
+  }
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_vector_reserve(ads_vector_t* vec, size_t capacity) {
+  if(capacity <= vec->capacity)
+    return ADS_SUCCESS;
+
+  return ads_vector_set_capacity(vec, capacity);
+}
+
+ads_status_t ads_vector_shrink_to_fit(ads_vector_t* vec) {
+  if(vec->size == vec->capacity)
+    return ADS_SUCCESS;
+
+  return ads_vector_set_capacity(vec, vec->size);
+}
+
 void ads_vector_clear(ads_vector_t* vec) {
   if(vec->destroy) {
     for(size_t i = 0; i < vec->size; i++)
       vec->destroy(ads_vector_get_idx_address(vec, i));
   }
-  memset(vec->buf, 0, vec->size * vec->data_size);
+  if(vec->size)
+    memset(vec->buf, 0, vec->size * vec->data_size);
   vec->size = 0;
 }
 
 void ads_vector_destroy(ads_vector_t* vec) {
   ads_vector_clear(vec);
-  free(vec->buf);    
+  ads_vector_free_buffer(vec);
 }
 
 ads_status_t ads_vector_push_back(ads_vector_t* vec, void* data) {
 
   if(ads_vector_is_full(vec)) {
-    if(!double_capacity(vec))
+    if(ads_vector_grow(vec, vec->size + 1) != ADS_SUCCESS)
       return ADS_NOMEM;
   }
 
@@ -70,7 +318,7 @@ ads_status_t ads_vector_push_back(ads_vector_t* vec, void* data) {
 ads_status_t ads_vector_push_front(ads_vector_t* vec, void* data) {
   
   if(ads_vector_is_full(vec)) {
-    if(!double_capacity(vec))
+    if(ads_vector_grow(vec, vec->size + 1) != ADS_SUCCESS)
       return ADS_NOMEM;
   }
 
@@ -90,25 +338,73 @@ ads_status_t ads_vector_insert_at(ads_vector_t* vec, ssize_t index, void* data)
     return ads_vector_push_front(vec, data);
   else if((size_t) index == vec->size)
     return ads_vector_push_back(vec, data);
-  else {
-    
-    if(ads_vector_is_full(vec)) {
-      if(!double_capacity(vec))
-        return ADS_NOMEM;
-    }
+  else
+    return ads_vector_insert_range(vec, index, data, 1);
+}
 
-    void* idx_start = ads_vector_get_idx_address(vec, index);
-    void* dest_start = ads_vector_get_idx_address(vec, index + 1);
-    size_t bytes_idx_up_to_end = (vec->size - index) * vec->data_size; 
-    
-    memmove(dest_start, idx_start, bytes_idx_up_to_end);
-    vec->copy(idx_start, data, vec->data_size); // memcpy or custom function
+/* ----- RANGE OPERATIONS ----- */
 
-    return ADS_SUCCESS;
+// copy `count` elements into uninitialized space, in one memcpy when copy is the default
+static inline void
+ads_vector_copy_n(ads_vector_t* vec, void* dest, const void* src, size_t count) {
+  if(vec->copy == memcpy) {
+    memcpy(dest, src, count * vec->data_size);
+    return;
+  }
 
+  for(size_t i = 0; i < count; i++) {
+    vec->copy(dest, src, vec->data_size);
+    dest = (char*) dest + vec->data_size;
+    src  = (const char*) src + vec->data_size;
   }
 }
 
+ads_status_t ads_vector_append_n(ads_vector_t* vec, const void* data, size_t count) {
+  if(ads_vector_grow(vec, vec->size + count) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  ads_vector_copy_n(vec, ads_vector_get_idx_address(vec, vec->size), data, count);
+  vec->size += count;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_vector_insert_range(ads_vector_t* vec, ssize_t index, const void* data, size_t count) {
+  if(index < 0 || (size_t) index > vec->size)
+    return ADS_OUTOFBOUNDS;
+
+  if(ads_vector_grow(vec, vec->size + count) != ADS_SUCCESS)
+    return ADS_NOMEM;
+
+  void* idx_start = ads_vector_get_idx_address(vec, index);
+  memmove(ads_vector_get_idx_address(vec, index + count), idx_start, (vec->size - index) * vec->data_size);
+  ads_vector_copy_n(vec, idx_start, data, count);
+  vec->size += count;
+
+  return ADS_SUCCESS;
+}
+
+ads_status_t ads_vector_erase_range(ads_vector_t* vec, ssize_t index, size_t count) {
+  if(index < 0 || (size_t) index > vec->size || count > vec->size - index)
+    return ADS_OUTOFBOUNDS;
+
+  if(vec->destroy) {
+    for(size_t i = index; i < index + count; i++)
+      vec->destroy(ads_vector_get_idx_address(vec, i));
+  }
+
+  size_t tail = vec->size - index - count;
+  memmove(ads_vector_get_idx_address(vec, index), ads_vector_get_idx_address(vec, index + count), tail * vec->data_size);
+  vec->size -= count;
+
+  // the slots left behind are zeroed, as ads_vector_clear does
+  memset(ads_vector_get_idx_address(vec, vec->size), 0, count * vec->data_size);
+
+  return ADS_SUCCESS;
+}
+
+/* ---------- */
+
 ads_status_t ads_vector_get_at(ads_vector_t* vec, ssize_t index, void** out) {
   if(index < 0 || (size_t) index >= vec->size)
     return ADS_OUTOFBOUNDS;
@@ -120,18 +416,29 @@ ads_status_t ads_vector_get_at(ads_vector_t* vec, ssize_t index, void** out) {
 }
 
 ads_status_t ads_vector_copy(ads_vector_t* dest, const ads_vector_t* src) {
-  dest->buf = calloc(src->capacity, src->data_size);
-  if(dest->buf == NULL)
+  dest->buf       = NULL;
+  dest->capacity  = 0;
+  dest->mapped    = 0;
+  dest->allocator = src->allocator;
+  dest->size      = 0;
+  dest->flags     = src->flags;
+  dest->alignment = src->alignment;
+  dest->inline_buf      = NULL;
+  dest->inline_capacity = 0;
+  dest->data_size = src->data_size;
+
+  if(ads_vector_set_capacity(dest, src->capacity) != ADS_SUCCESS)
     return ADS_NOMEM;
 
-  dest->capacity  = src->capacity;
-  dest->size      = src->size;
-  dest->data_size = src->data_size;
+  dest->size          = src->size;
+  dest->growth_factor = src->growth_factor;
 
   dest->copy      = src->copy;
   dest->destroy   = src->destroy;
 
-  memcpy(dest->buf, src->buf, src->size * src->data_size);
+  // an empty vector may have no buffer at all, and memcpy doesn't take NULL even for 0 bytes
+  if(src->size)
+    memcpy(dest->buf, src->buf, src->size * src->data_size);
   return ADS_SUCCESS;
 }
 
@@ -141,7 +448,7 @@ ads_vector_remove_internal(ads_vector_t* vec, size_t index) {
   if(vec->destroy)
     vec->destroy(rem_idx);
 
-  memset(rem_idx, 0, sizeof(vec->data_size));
+  memset(rem_idx, 0, vec->data_size);
   --vec->size;
 }
 
@@ -152,10 +459,5 @@ void ads_vector_pop_back(ads_vector_t* vec) {
 
 void ads_vector_pop_front(ads_vector_t* vec) {
   if(vec->size > 0)
-    ads_vector_remove_internal(vec, 0);
-  
-  if(vec->size > 0) {
-    void* src = ads_vector_get_idx_address(vec, 1);
-    memcpy(vec->buf, src, vec->size * vec->data_size);
-  }
+    ads_vector_erase_range(vec, 0, 1);
 }
\ No newline at end of file
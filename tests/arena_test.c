@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../include/arena.h"
+#include "../include/list.h"
+#include "../include/dlist.h"
+#include "../include/map.h"
+#include "../include/vector.h"
+
+#define ads_arena_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_arena_alloc_TEST(void) {
+  ads_arena_t arena;
+  ads_arena_init(&arena, 1024);
+  assert(ads_arena_get_capacity(&arena) == 0);
+
+  // the first allocation brings the first chunk
+  char* first = ads_arena_alloc(&arena, 10, 0);
+  assert(first && ads_arena_is_aligned(first, ADS_ARENA_ALIGNMENT));
+  assert(ads_arena_get_capacity(&arena) == 1024);
+
+  char* second = ads_arena_alloc(&arena, 10, 0);
+  assert(second > first && ads_arena_is_aligned(second, ADS_ARENA_ALIGNMENT));
+
+  void* aligned = ads_arena_alloc(&arena, 1, 256);
+  assert(aligned && ads_arena_is_aligned(aligned, 256));
+
+  // the next chunks double in size
+  for(int i = 0; i < 100; i++)
+    assert(ads_arena_alloc(&arena, 100, 0));
+  assert(ads_arena_get_capacity(&arena) >= 1024 + 2048 + 4096);
+
+  // a request larger than any chunk gets one of its own
+  size_t capacity = ads_arena_get_capacity(&arena);
+  char* large = ads_arena_alloc(&arena, 1 << 20, 0);
+  assert(large);
+  memset(large, 0xab, 1 << 20);
+  assert(ads_arena_get_capacity(&arena) >= capacity + (1 << 20));
+
+  assert(ads_arena_alloc(&arena, SIZE_MAX - 8, 0) == NULL);
+
+  ads_arena_destroy(&arena);
+  assert(ads_arena_get_capacity(&arena) == 0);
+
+  // after destroy, the chunks start over from the size given to ads_arena_init
+  assert(ads_arena_alloc(&arena, 10, 0));
+  assert(ads_arena_get_capacity(&arena) == 1024);
+
+  ads_arena_destroy(&arena);
+}
+
+static inline void ads_arena_realloc_TEST(void) {
+  ads_arena_t arena;
+  ads_arena_init(&arena, 1024);
+
+  // the last allocation grows and shrinks in place
+  char* ptr = ads_arena_alloc(&arena, 16, 0);
+  strcpy(ptr, "arena");
+  assert(ads_arena_realloc(&arena, ptr, 16, 512) == ptr);
+  assert(ads_arena_realloc(&arena, ptr, 512, 32) == ptr);
+
+  // an older one is copied, unless it shrinks
+  char* other = ads_arena_alloc(&arena, 16, 0);
+  assert(ads_arena_realloc(&arena, ptr, 32, 16) == ptr);
+  char* moved = ads_arena_realloc(&arena, ptr, 32, 64);
+  assert(moved != ptr && moved > other);
+  assert(strcmp(moved, "arena") == 0);
+
+  // past the end of its chunk, the last allocation is copied too
+  char* big = ads_arena_realloc(&arena, moved, 64, 4096);
+  assert(big != moved);
+  assert(strcmp(big, "arena") == 0);
+
+  assert(ads_arena_realloc(&arena, NULL, 0, 8) != NULL);
+
+  ads_arena_destroy(&arena);
+}
+
+static inline void ads_arena_mark_reset_TEST(void) {
+  ads_arena_t arena;
+  ads_arena_init(&arena, 1024);
+
+  // a mark of an empty arena
+  ads_arena_mark_t empty;
+  ads_arena_mark(&arena, &empty);
+
+  void* before = ads_arena_alloc(&arena, 100, 0);
+
+  ads_arena_mark_t outer;
+  ads_arena_mark(&arena, &outer);
+  void* after_outer = ads_arena_alloc(&arena, 100, 0);
+
+  // the inner mark is taken in a later chunk
+  for(int i = 0; i < 50; i++)
+    assert(ads_arena_alloc(&arena, 100, 0));
+  ads_arena_mark_t inner;
+  ads_arena_mark(&arena, &inner);
+  size_t capacity = ads_arena_get_capacity(&arena);
+  void* after_inner = ads_arena_alloc(&arena, 100, 0);
+
+  for(int i = 0; i < 200; i++)
+    assert(ads_arena_alloc(&arena, 100, 0));
+  assert(ads_arena_get_capacity(&arena) > capacity);
+
+  // the chunks added after the mark are released and the memory after it is handed out again
+  ads_arena_reset(&arena, &inner);
+  assert(ads_arena_get_capacity(&arena) == capacity);
+  assert(ads_arena_alloc(&arena, 100, 0) == after_inner);
+
+  ads_arena_reset(&arena, &outer);
+  assert(ads_arena_get_capacity(&arena) == 1024);
+  assert(ads_arena_alloc(&arena, 100, 0) == after_outer);
+
+  // without a mark, everything is released but the first chunk
+  for(int i = 0; i < 200; i++)
+    assert(ads_arena_alloc(&arena, 100, 0));
+  ads_arena_reset(&arena, NULL);
+  assert(ads_arena_get_capacity(&arena) == 1024);
+  assert(ads_arena_alloc(&arena, 100, 0) == before);
+
+  // back to the empty arena
+  ads_arena_reset(&arena, &empty);
+  assert(ads_arena_get_capacity(&arena) == 0);
+
+  ads_arena_destroy(&arena);
+}
+
+// overwrite whatever the arena handed out after `mark`
+static void
+ads_arena_scribble(ads_arena_t* arena, const ads_arena_mark_t* mark) {
+  size_t capacity = ads_arena_get_capacity(arena);
+  ads_arena_reset(arena, mark);
+  memset(ads_arena_alloc(arena, capacity, 0), 0xff, capacity);
+}
+
+static inline void ads_arena_containers_TEST(void) {
+  ads_arena_t arena;
+  ads_arena_init(&arena, 0);
+  const ads_allocator_t* allocator = ads_arena_get_allocator(&arena);
+
+  ads_arena_mark_t mark;
+  ads_arena_mark(&arena, &mark);
+
+  ads_list_t list;
+  ads_dlist_t dlist;
+  ads_map_t map = {0};
+  ads_vector_t vec;
+
+  ads_list_init_allocator(&list, NULL, allocator);
+  ads_dlist_init_allocator(&dlist, NULL, allocator);
+  assert(!ads_map_init_allocator(&map, 16, 0, allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(!ads_vector_init_allocator(&vec, sizeof(size_t), 0, allocator, NULL, NULL));
+
+  for(size_t i = 0; i < 5000; i++) {
+    assert(!ads_list_push_back(&list, ads_map_uint64_key(i)));
+    assert(!ads_dlist_push_front(&dlist, ads_map_uint64_key(i)));
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+    assert(!ads_vector_push_back(&vec, &i));
+  }
+
+  // everything came from the arena and works as usual
+  assert(ads_arena_get_capacity(&arena) > 0);
+  assert(ads_list_get_size(&list) == 5000 && ads_dlist_get_size(&dlist) == 5000);
+  void* out = NULL;
+  for(size_t i = 0; i < 5000; i++) {
+    assert(ads_map_get(&map, ads_map_uint64_key(i), &out) && (size_t) out == i * 2);
+    assert(ads_vector_get_as(&vec, size_t*)[i] == i);
+  }
+  for(size_t i = 0; i < 5000; i += 2)
+    assert(!ads_map_remove(&map, ads_map_uint64_key(i), NULL));
+  assert(ads_map_get_size(&map) == 2500);
+
+  // the vector clears its buffer on destroy, so it goes first
+  ads_vector_destroy(&vec);
+
+  /* without a destroy function, destroy doesn't visit the nodes: it must not even read them,
+     which is checked by releasing and overwriting all of their memory first */
+  ads_arena_scribble(&arena, &mark);
+  ads_list_destroy(&list);
+  ads_dlist_destroy(&dlist);
+  ads_map_destroy(&map);
+
+  assert(ads_list_is_empty(&list) && ads_dlist_is_empty(&dlist));
+
+  ads_arena_destroy(&arena);
+}
+
+static size_t destroyed = 0;
+
+static void ads_arena_count_destroy(void* data) {
+  (void) data;
+  destroyed++;
+}
+
+static inline void ads_arena_containers_destroy_TEST(void) {
+  ads_arena_t arena;
+  ads_arena_init(&arena, 0);
+  const ads_allocator_t* allocator = ads_arena_get_allocator(&arena);
+
+  ads_list_t list;
+  ads_map_t map = {0};
+  ads_list_init_allocator(&list, ads_arena_count_destroy, allocator);
+  assert(!ads_map_init_allocator(&map, 16, 0, allocator, ads_arena_count_destroy, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 0; i < 1000; i++) {
+    assert(!ads_list_push_back(&list, ads_map_uint64_key(i)));
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), NULL));
+  }
+
+  // with a destroy function, every element is still visited
+  destroyed = 0;
+  ads_list_destroy(&list);
+  ads_map_destroy(&map);
+  assert(destroyed == 2000);
+
+  ads_arena_destroy(&arena);
+}
+
+static void* ads_arena_thread_TEST_run(void* arg) {
+  ads_arena_t* arena = ads_arena_thread();
+  assert(arena && arena == ads_arena_thread());
+  assert(ads_arena_alloc(arena, 100, 0));
+
+  *(ads_arena_t**) arg = arena;
+  return NULL;
+}
+
+static inline void ads_arena_thread_TEST(void) {
+  ads_arena_t* mine = ads_arena_thread();
+  assert(mine && mine == ads_arena_thread());
+
+  // each thread gets its own arena, released when it exits
+  ads_arena_t* other = NULL;
+  pthread_t thread;
+  assert(pthread_create(&thread, NULL, ads_arena_thread_TEST_run, &other) == 0);
+  pthread_join(thread, NULL);
+  assert(other && other != mine);
+}
+
+int main() {
+
+  ads_arena_alloc_TEST();
+  ads_arena_realloc_TEST();
+  ads_arena_mark_reset_TEST();
+  ads_arena_containers_TEST();
+  ads_arena_containers_destroy_TEST();
+  ads_arena_thread_TEST();
+
+  puts("ARENA TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/btree.h"
+#include "../include/iterator.h"
+
+#define ads_btree_uint64_key(key) ((void*) ((size_t)(key)))
+
+/* check the shape of the subtree: sorted keys, no node but the root below the minimum, every
+   key within the bounds set by the parent's separators and every leaf at the same depth.
+   Returns the depth of the leaves */
+static size_t
+ads_btree_check_node(const ads_btree_node_t* node, int is_root, size_t low, size_t high) {
+  assert(node->count <= ADS_BTREE_NODE_KEYS);
+  if(!is_root)
+    assert(node->count >= ADS_BTREE_MIN_KEYS);
+
+  for(size_t i = 0; i < node->count; i++) {
+    size_t key = (size_t) node->keys[i];
+    assert(key >= low && key < high);
+    if(i > 0)
+      assert((size_t) node->keys[i - 1] < key);
+  }
+
+  if(node->leaf)
+    return 0;
+
+  const ads_btree_inner_t* inner = (const ads_btree_inner_t*) node;
+  size_t depth = 0;
+  for(size_t i = 0; i <= node->count; i++) {
+    size_t child_low  = i == 0 ? low : (size_t) node->keys[i - 1];
+    size_t child_high = i == node->count ? high : (size_t) node->keys[i];
+    size_t child_depth = ads_btree_check_node(inner->children[i], 0, child_low, child_high);
+    if(i > 0)
+      assert(child_depth == depth);
+    depth = child_depth;
+  }
+
+  return depth + 1;
+}
+
+#define ads_btree_check(tree) ads_btree_check_node((tree)->root, 1, 0, (size_t) -1)
+
+static inline void ads_btree_random_TEST(void) {
+  enum { KEYS = 4096, OPS = 100000 };
+
+  // reference: present[k] tells if k is in the tree, with value k * 3 + version[k]
+  static char present[KEYS];
+  static size_t version[KEYS];
+  size_t size = 0;
+
+  ads_btree_t tree;
+  assert(!ads_btree_init(&tree, NULL, ADS_BTREE_COMPARE_UINT64));
+
+  srand(42);
+  for(size_t op = 0; op < OPS; op++) {
+    size_t key = (size_t) rand() % KEYS;
+    void* out = NULL;
+
+    // insert twice as often as remove, so the tree grows and shrinks through several levels
+    if(rand() % 3) {
+      version[key]++;
+      assert(!ads_btree_insert(&tree, ads_btree_uint64_key(key), ads_btree_uint64_key(key * 3 + version[key])));
+      if(!present[key]) {
+        present[key] = 1;
+        size++;
+      }
+    }
+    else if(present[key]) {
+      assert(!ads_btree_remove(&tree, ads_btree_uint64_key(key), &out));
+      assert((size_t) out == key * 3 + version[key]);
+      present[key] = 0;
+      size--;
+    }
+    else
+      assert(ads_btree_remove(&tree, ads_btree_uint64_key(key), NULL) == ADS_NOTFOUND);
+
+    assert(ads_btree_get_size(&tree) == size);
+
+    if(op % 10000 == 0)
+      ads_btree_check(&tree);
+  }
+
+  ads_btree_check(&tree);
+
+  void* out = NULL;
+  for(size_t key = 0; key < KEYS; key++) {
+    if(present[key]) {
+      assert(!ads_btree_get(&tree, ads_btree_uint64_key(key), &out));
+      assert((size_t) out == key * 3 + version[key]);
+    }
+    else
+      assert(ads_btree_get(&tree, ads_btree_uint64_key(key), NULL) == ADS_NOTFOUND);
+  }
+
+  // the leaves, walked in order, hold exactly the keys of the reference
+  ads_btree_cursor_t cursor;
+  ads_btree_first(&tree, &cursor);
+  for(size_t key = 0; key < KEYS; key++) {
+    if(!present[key])
+      continue;
+    assert(!ads_btree_cursor_is_end(&cursor));
+    assert((size_t) ads_btree_cursor_get_key(&cursor) == key);
+    ads_btree_cursor_next(&cursor);
+  }
+  assert(ads_btree_cursor_is_end(&cursor));
+
+  // removing everything brings the root back to an empty leaf
+  for(size_t key = 0; key < KEYS; key++) {
+    if(present[key])
+      assert(!ads_btree_remove(&tree, ads_btree_uint64_key(key), NULL));
+  }
+  assert(ads_btree_is_empty(&tree));
+  assert(tree.root->leaf && tree.root->count == 0);
+
+  ads_btree_destroy(&tree);
+}
+
+static inline void ads_btree_sequential_TEST(void) {
+  ads_btree_t tree;
+  assert(!ads_btree_init(&tree, free, ADS_BTREE_COMPARE_STRING));
+
+  // increasing keys always split the rightmost nodes
+  char key[32];
+  char* keys[2000];
+  for(int i = 0; i < 2000; i++) {
+    sprintf(key, "key-%05d", i);
+    keys[i] = strdup(key);
+    assert(!ads_btree_insert(&tree, keys[i], strdup(key)));
+  }
+  assert(ads_btree_get_size(&tree) == 2000);
+
+  // replacing a value frees the old one
+  assert(!ads_btree_insert(&tree, keys[10], strdup("ten")));
+  char* value = NULL;
+  assert(!ads_btree_get(&tree, "key-00010", (void**) &value));
+  assert(strcmp(value, "ten") == 0);
+  assert(ads_btree_get_size(&tree) == 2000);
+
+  // the values left are freed by destroy
+  ads_btree_destroy(&tree);
+  for(int i = 0; i < 2000; i++)
+    free(keys[i]);
+}
+
+static inline void ads_btree_bulk_load_TEST(void) {
+  enum { COUNT = 10000 };
+
+  static void* keys[COUNT];
+  static void* values[COUNT];
+  for(size_t i = 0; i < COUNT; i++) {
+    keys[i]   = ads_btree_uint64_key(i * 2);
+    values[i] = ads_btree_uint64_key(i);
+  }
+
+  ads_btree_t tree;
+  assert(!ads_btree_init(&tree, NULL, ADS_BTREE_COMPARE_UINT64));
+
+  // keys out of order are rejected and the tree stays empty
+  keys[10] = ads_btree_uint64_key(0);
+  assert(ads_btree_bulk_load(&tree, keys, values, COUNT) == ADS_INVALID);
+  assert(ads_btree_is_empty(&tree));
+  keys[10] = ads_btree_uint64_key(20);
+
+  assert(!ads_btree_bulk_load(&tree, keys, values, COUNT));
+  assert(ads_btree_get_size(&tree) == COUNT);
+  ads_btree_check(&tree);
+
+  // only an empty tree can be loaded
+  assert(ads_btree_bulk_load(&tree, keys, values, COUNT) == ADS_INVALID);
+
+  // [1001, 2001) holds the even keys 1002..2000
+  ads_btree_range_t range;
+  ads_btree_range(&tree, ads_btree_uint64_key(1001), ads_btree_uint64_key(2001), &range);
+
+  ads_iterator_t it;
+  ads_btree_cursor_t* cursor = NULL;
+  size_t expected = 1002;
+  ads_iterator_init(&it, &range, ADS_ITERATOR_BTREE);
+  while(ads_iterator_iterate(&it, (void**) &cursor)) {
+    assert((size_t) ads_btree_cursor_get_key(cursor) == expected);
+    assert((size_t) ads_btree_cursor_get_value(cursor) == expected / 2);
+    expected += 2;
+  }
+  assert(expected == 2002);
+  ads_iterator_destroy(&it);
+
+  // an empty interval
+  ads_btree_range(&tree, ads_btree_uint64_key(500), ads_btree_uint64_key(500), &range);
+  ads_iterator_init(&it, &range, ADS_ITERATOR_BTREE);
+  assert(!ads_iterator_iterate(&it, (void**) &cursor));
+  ads_iterator_destroy(&it);
+
+  // the packed tree still takes inserts and removes
+  for(size_t i = 1; i < 2 * COUNT; i += 2)
+    assert(!ads_btree_insert(&tree, ads_btree_uint64_key(i), NULL));
+  for(size_t i = 0; i < 2 * COUNT; i += 4)
+    assert(!ads_btree_remove(&tree, ads_btree_uint64_key(i), NULL));
+  assert(ads_btree_get_size(&tree) == COUNT + COUNT / 2);
+  ads_btree_check(&tree);
+
+  ads_btree_destroy(&tree);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_btree_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_btree_t tree;
+  assert(!ads_btree_init_allocator(&tree, &allocator, NULL, ADS_BTREE_COMPARE_UINT64));
+  assert(allocated > 0 && ads_is_aligned(tree.root, ADS_BTREE_NODE_ALIGN));
+
+  // splits, then merges
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_btree_insert(&tree, (void*) i, NULL));
+  assert(ads_is_aligned(tree.root, ADS_BTREE_NODE_ALIGN));
+  for(size_t i = 0; i < 10000; i += 3)
+    assert(!ads_btree_remove(&tree, (void*) i, NULL));
+
+  ads_btree_destroy(&tree);
+  assert(allocated == 0);
+
+  static void* keys[5000];
+  for(size_t i = 0; i < 5000; i++)
+    keys[i] = (void*) i;
+
+  assert(!ads_btree_init_allocator(&tree, &allocator, NULL, ADS_BTREE_COMPARE_UINT64));
+  assert(!ads_btree_bulk_load(&tree, keys, keys, 5000));
+  ads_btree_destroy(&tree);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_btree_random_TEST();
+  ads_btree_sequential_TEST();
+  ads_btree_bulk_load_TEST();
+  ads_btree_allocator_TEST();
+
+  puts("BTREE TEST: OK");
+
+  return 0;
+}
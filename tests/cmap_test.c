@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "../include/cmap.h"
+#include "../include/map.h"
+
+static inline void ads_cmap_insert_get_TEST(void) {
+  ads_cmap_t map;
+  assert(!ads_cmap_init(&map, 5, 64, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_cmap_get_stripes(&map) == 8);
+
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_cmap_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+  assert(ads_cmap_get_size(&map) == 10000);
+
+  void* out = NULL;
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_cmap_get(&map, ads_map_uint64_key(i), &out) && (size_t) out == i * 2);
+  assert(ads_cmap_get(&map, ads_map_uint64_key(123456), NULL) == ADS_NOTFOUND);
+
+  // the value already there is kept, and the one passed is left to the caller
+  assert(!ads_cmap_get_or_insert(&map, ads_map_uint64_key(5), ads_map_uint64_key(50), &out));
+  assert((size_t) out == 10);
+  assert(!ads_cmap_get_or_insert(&map, ads_map_uint64_key(10000), ads_map_uint64_key(1), &out));
+  assert((size_t) out == 1);
+
+  for(size_t i = 0; i < 10000; i += 2)
+    assert(!ads_cmap_remove(&map, ads_map_uint64_key(i), &out) && (size_t) out == i * 2);
+  assert(ads_cmap_remove(&map, ads_map_uint64_key(0), NULL) == ADS_NOTFOUND);
+  assert(ads_cmap_get_size(&map) == 5001);
+
+  ads_cmap_destroy(&map);
+}
+
+static void* ads_cmap_compute_null(void* key, void* arg) {
+  (void) key; (void) arg;
+  return NULL;
+}
+
+static inline void ads_cmap_compute_TEST(void) {
+  ads_cmap_t map;
+  assert(!ads_cmap_init(&map, 4, 0, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // nothing is inserted when `compute` gives no value
+  void* out = NULL;
+  assert(ads_cmap_compute_if_absent(&map, ads_map_uint64_key(1), ads_cmap_compute_null, NULL, &out) == ADS_NOTFOUND);
+  assert(ads_cmap_get_size(&map) == 0);
+
+  // nor called when the key is there
+  assert(!ads_cmap_insert(&map, ads_map_uint64_key(1), ads_map_uint64_key(7)));
+  assert(!ads_cmap_compute_if_absent(&map, ads_map_uint64_key(1), ads_cmap_compute_null, NULL, &out));
+  assert((size_t) out == 7);
+
+  ads_cmap_destroy(&map);
+}
+
+/* ----- CONCURRENCY ----- */
+
+enum { THREADS = 8, KEYS = 2000, ROUNDS = 4 };
+
+typedef struct ads_cmap_value {
+  size_t key;
+  size_t creator;
+} ads_cmap_value_t;
+
+static atomic_size_t created[KEYS];
+
+typedef struct ads_cmap_worker {
+  ads_cmap_t* map;
+  size_t id;
+  ads_cmap_value_t* seen[KEYS]; // value each key had for this thread
+} ads_cmap_worker_t;
+
+static void* ads_cmap_create(void* key, void* arg) {
+  ads_cmap_worker_t* worker = arg;
+
+  ads_cmap_value_t* value = malloc(sizeof(ads_cmap_value_t));
+  value->key = (size_t) key;
+  value->creator = worker->id;
+  atomic_fetch_add(&created[(size_t) key], 1);
+
+  return value;
+}
+
+static void* ads_cmap_worker_run(void* arg) {
+  ads_cmap_worker_t* worker = arg;
+  unsigned seed = (unsigned) worker->id;
+
+  // every thread goes over the same keys, from a different starting point and mixing both calls
+  for(size_t round = 0; round < ROUNDS; round++) {
+    for(size_t n = 0; n < KEYS; n++) {
+      size_t key = (n * 7 + worker->id * (KEYS / THREADS)) % KEYS;
+      void* out = NULL;
+
+      if(rand_r(&seed) % 2)
+        assert(!ads_cmap_compute_if_absent(worker->map, ads_map_uint64_key(key), ads_cmap_create, worker, &out));
+      else {
+        ads_cmap_value_t* value = ads_cmap_create(ads_map_uint64_key(key), worker);
+        assert(!ads_cmap_get_or_insert(worker->map, ads_map_uint64_key(key), value, &out));
+
+        // lost the race: the value was never inserted and is still ours
+        if(out != value) {
+          atomic_fetch_sub(&created[key], 1);
+          free(value);
+        }
+      }
+
+      ads_cmap_value_t* value = out;
+      assert(value && value->key == key);
+      if(worker->seen[key])
+        assert(worker->seen[key] == value);
+      worker->seen[key] = value;
+    }
+  }
+
+  return NULL;
+}
+
+static inline void ads_cmap_concurrent_TEST(void) {
+  ads_cmap_t map;
+  assert(!ads_cmap_init(&map, 4, 16, free, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  static ads_cmap_worker_t workers[THREADS];
+  pthread_t threads[THREADS];
+  for(size_t i = 0; i < THREADS; i++) {
+    workers[i].map = &map;
+    workers[i].id = i;
+    assert(pthread_create(&threads[i], NULL, ads_cmap_worker_run, &workers[i]) == 0);
+  }
+  for(size_t i = 0; i < THREADS; i++)
+    pthread_join(threads[i], NULL);
+
+  // each value was created once and every thread got that one
+  assert(ads_cmap_get_size(&map) == KEYS);
+  for(size_t key = 0; key < KEYS; key++) {
+    assert(atomic_load(&created[key]) == 1);
+
+    void* out = NULL;
+    assert(!ads_cmap_get(&map, ads_map_uint64_key(key), &out));
+    for(size_t i = 0; i < THREADS; i++)
+      assert(workers[i].seen[key] == out);
+  }
+
+  ads_cmap_destroy(&map);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_cmap_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_cmap_t map;
+  assert(!ads_cmap_init_allocator(&map, 4, 16, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_is_aligned(map.stripes, ADS_CMAP_CACHE_LINE));
+  for(size_t i = 0; i < 4; i++)
+    assert(map.stripes[i].map.allocator == &allocator);
+
+  for(size_t i = 0; i < 1000; i++)
+    assert(!ads_cmap_insert(&map, ads_map_uint64_key(i), NULL));
+  for(size_t i = 0; i < 1000; i += 2)
+    assert(!ads_cmap_remove(&map, ads_map_uint64_key(i), NULL));
+
+  ads_cmap_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_cmap_insert_get_TEST();
+  ads_cmap_compute_TEST();
+  ads_cmap_concurrent_TEST();
+  ads_cmap_allocator_TEST();
+
+  puts("CMAP TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/deque.h"
+
+// the elements of `deque`, front to back, must be first, first + 1, ..., first + size - 1
+static void
+ads_deque_check_sequence(ads_deque_t* deque, int first) {
+  for(size_t i = 0; i < ads_deque_get_size(deque); i++) {
+    int* value = NULL;
+    assert(!ads_deque_get_at(deque, i, (void**) &value));
+    assert(*value == first + (int) i);
+  }
+}
+
+static inline void ads_deque_push_pop_TEST(void) {
+  ads_deque_t deque;
+  assert(!ads_deque_init(&deque, sizeof(int), NULL, NULL));
+
+  int value = 0;
+  assert(ads_deque_pop_back(&deque, &value) == ADS_NOTFOUND);
+  assert(ads_deque_pop_front(&deque, &value) == ADS_NOTFOUND);
+
+  for(int i = 0; i < 100; i++)
+    assert(!ads_deque_push_back(&deque, &i));
+  for(int i = -1; i >= -100; i--)
+    assert(!ads_deque_push_front(&deque, &i));
+
+  assert(ads_deque_get_size(&deque) == 200);
+  ads_deque_check_sequence(&deque, -100);
+
+  assert(ads_deque_get_at(&deque, 200, NULL) == ADS_OUTOFBOUNDS);
+  assert(ads_deque_get_at(&deque, -1, NULL) == ADS_OUTOFBOUNDS);
+
+  assert(!ads_deque_pop_front(&deque, &value) && value == -100);
+  assert(!ads_deque_pop_back(&deque, &value) && value == 99);
+  ads_deque_check_sequence(&deque, -99);
+
+  ads_deque_destroy(&deque);
+}
+
+static inline void ads_deque_wrap_TEST(void) {
+  ads_deque_t deque;
+  assert(!ads_deque_init(&deque, sizeof(int), NULL, NULL));
+  assert(deque.capacity == ADS_DEQUE_PRE_ALLOCATE);
+
+  // move the head to the middle of the buffer, then fill it: the back wraps to slot 0
+  int value = 0;
+  for(int i = 0; i < ADS_DEQUE_PRE_ALLOCATE / 2; i++)
+    assert(!ads_deque_push_back(&deque, &i));
+  for(int i = 0; i < ADS_DEQUE_PRE_ALLOCATE / 2; i++)
+    assert(!ads_deque_pop_front(&deque, NULL));
+  for(int i = 0; i < ADS_DEQUE_PRE_ALLOCATE; i++)
+    assert(!ads_deque_push_back(&deque, &i));
+
+  assert(ads_deque_is_full(&deque));
+  assert(deque.head == ADS_DEQUE_PRE_ALLOCATE / 2);
+  ads_deque_check_sequence(&deque, 0);
+
+  // growing with the elements wrapped keeps their order
+  value = ADS_DEQUE_PRE_ALLOCATE;
+  assert(!ads_deque_push_back(&deque, &value));
+  assert(deque.capacity == 2 * ADS_DEQUE_PRE_ALLOCATE);
+  ads_deque_check_sequence(&deque, 0);
+
+  // popping and pushing at both ends across the new end of the buffer
+  for(int i = 0; i < 1000; i++) {
+    int front = 0, back = 0;
+    assert(!ads_deque_pop_front(&deque, &front));
+    value = front + (int) ads_deque_get_size(&deque) + 1;
+    assert(!ads_deque_push_back(&deque, &value));
+    ads_deque_check_sequence(&deque, front + 1);
+
+    assert(!ads_deque_pop_back(&deque, &back));
+    assert(back == value);
+    assert(!ads_deque_push_front(&deque, &front));
+    ads_deque_check_sequence(&deque, front);
+
+    // shift the window one element forward
+    assert(!ads_deque_pop_front(&deque, NULL));
+    assert(!ads_deque_push_back(&deque, &back));
+  }
+  assert(deque.capacity == 2 * ADS_DEQUE_PRE_ALLOCATE);
+
+  ads_deque_destroy(&deque);
+}
+
+static inline void ads_deque_wrap_front_TEST(void) {
+  ads_deque_t deque;
+  assert(!ads_deque_init(&deque, sizeof(int), NULL, NULL));
+
+  // pushing at the front of an empty deque wraps the head to the last slot
+  int value = 0;
+  assert(!ads_deque_push_front(&deque, &value));
+  assert(deque.head == ADS_DEQUE_PRE_ALLOCATE - 1);
+
+  // keep growing with the head wrapped, by pushes at both ends and a reserve
+  for(int i = 1; i < 50; i++)
+    assert(!ads_deque_push_back(&deque, &i));
+  ads_deque_check_sequence(&deque, 0);
+
+  for(int i = -1; i >= -20; i--)
+    assert(!ads_deque_push_front(&deque, &i));
+  ads_deque_check_sequence(&deque, -20);
+
+  assert(!ads_deque_reserve(&deque, 1000));
+  assert(deque.capacity == 1024);
+  ads_deque_check_sequence(&deque, -20);
+
+  for(int i = -20; i < 50; i++) {
+    assert(!ads_deque_pop_front(&deque, &value));
+    assert(value == i);
+  }
+  assert(ads_deque_is_empty(&deque));
+
+  ads_deque_destroy(&deque);
+}
+
+static void ads_deque_free_ptr(void* slot) {
+  free(*(void**) slot);
+}
+
+static inline void ads_deque_destroy_TEST(void) {
+  ads_deque_t deque;
+  assert(!ads_deque_init(&deque, sizeof(char*), NULL, ads_deque_free_ptr));
+
+  for(int i = 0; i < 20; i++) {
+    char* str = strdup("deque");
+    assert(!ads_deque_push_front(&deque, &str));
+  }
+
+  // popped with `out`, the caller takes the string over
+  char* str = NULL;
+  assert(!ads_deque_pop_back(&deque, &str));
+  free(str);
+
+  // without `out`, destroy frees it
+  assert(!ads_deque_pop_front(&deque, NULL));
+
+  // the rest, wrapped around the buffer, is freed by destroy
+  ads_deque_destroy(&deque);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx; (void) alignment;
+  allocated += size;
+  return malloc(size);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+static inline void ads_deque_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_deque_t deque;
+  assert(!ads_deque_init_allocator(&deque, sizeof(int), &allocator, NULL, NULL));
+  assert(allocated == ADS_DEQUE_PRE_ALLOCATE * sizeof(int));
+
+  for(int i = 0; i < 1000; i++)
+    assert(!ads_deque_push_front(&deque, &i));
+  assert(allocated == deque.capacity * sizeof(int));
+
+  // every buffer, including the ones replaced while growing, went back to the allocator
+  ads_deque_destroy(&deque);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_deque_push_pop_TEST();
+  ads_deque_wrap_TEST();
+  ads_deque_wrap_front_TEST();
+  ads_deque_destroy_TEST();
+  ads_deque_allocator_TEST();
+
+  puts("DEQUE TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/flatmap.h"
+#include "../include/map.h"
+
+
+static inline void ads_flatmap_insert_get_TEST(void) {
+  ads_flatmap_t map = {0};
+  assert(!ads_flatmap_init(&map, 0, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_flatmap_get_capacity(&map) == ADS_FLATMAP_GROUP_WIDTH);
+
+  // insert enough keys to force the table to grow several times
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_flatmap_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+
+  assert(ads_flatmap_get_size(&map) == 10000);
+  assert(ads_flatmap_get_capacity(&map) >= 10000);
+
+  void* out = NULL;
+  for(size_t i = 0; i < 10000; i++) {
+    assert(ads_flatmap_get(&map, ads_map_uint64_key(i), &out) != NULL);
+    assert((size_t) out == i * 2);
+  }
+
+  // update an existing key
+  assert(!ads_flatmap_insert(&map, ads_map_uint64_key(5), ads_map_uint64_key(50)));
+  assert(ads_flatmap_get_size(&map) == 10000);
+  ads_flatmap_get(&map, ads_map_uint64_key(5), &out);
+  assert((size_t) out == 50);
+
+  // key not in the map
+  assert(ads_flatmap_get(&map, ads_map_uint64_key(123456), NULL) == NULL);
+
+  ads_flatmap_destroy(&map);
+}
+
+static inline void ads_flatmap_remove_TEST(void) {
+  ads_flatmap_t map = {0};
+  assert(!ads_flatmap_init(&map, 0, free, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  char key[32];
+  char* keys[1000];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    keys[i] = strdup(key);
+    assert(!ads_flatmap_insert(&map, keys[i], strdup(key)));
+  }
+
+  char* value = NULL;
+  for(int i = 0; i < 1000; i += 2) {
+    assert(!ads_flatmap_remove(&map, keys[i], (void**) &value));
+    assert(strcmp(value, keys[i]) == 0);
+    free(value);
+  }
+
+  // removing a key twice
+  assert(ads_flatmap_remove(&map, keys[0], NULL) == ADS_NOTFOUND);
+
+  // the remaining keys are still found past the tombstones
+  for(int i = 1; i < 1000; i += 2) {
+    assert(ads_flatmap_get(&map, keys[i], (void**) &value) != NULL);
+    assert(strcmp(value, keys[i]) == 0);
+  }
+  for(int i = 0; i < 1000; i += 2)
+    assert(ads_flatmap_get(&map, keys[i], NULL) == NULL);
+
+  assert(ads_flatmap_get_size(&map) == 500);
+
+  // the values left are freed by destroy
+  ads_flatmap_destroy(&map);
+  for(int i = 0; i < 1000; i++)
+    free(keys[i]);
+}
+
+static inline void ads_flatmap_tombstone_TEST(void) {
+  ads_flatmap_t map = {0};
+  assert(!ads_flatmap_init(&map, 0, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 0; i < 6; i++)
+    assert(!ads_flatmap_insert(&map, ads_map_uint64_key(i), NULL));
+
+  /* replace the keys one by one while the size stays the same: the freed slots are reused,
+     or the table is rehashed in place to drop the tombstones, but it never grows */
+  for(size_t i = 6; i < 5000; i++) {
+    assert(!ads_flatmap_remove(&map, ads_map_uint64_key(i - 6), NULL));
+    assert(!ads_flatmap_insert(&map, ads_map_uint64_key(i), NULL));
+    assert(ads_flatmap_get_size(&map) == 6);
+  }
+
+  assert(ads_flatmap_get_capacity(&map) == ADS_FLATMAP_GROUP_WIDTH);
+
+  for(size_t i = 4994; i < 5000; i++)
+    assert(ads_flatmap_get(&map, ads_map_uint64_key(i), NULL) != NULL);
+  assert(ads_flatmap_get(&map, ads_map_uint64_key(4993), NULL) == NULL);
+
+  ads_flatmap_destroy(&map);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx; (void) alignment;
+  allocated += size;
+  return malloc(size);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+static inline void ads_flatmap_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_flatmap_t map = {0};
+  assert(!ads_flatmap_init_allocator(&map, 0, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(allocated > 0);
+
+  for(size_t i = 0; i < 1000; i++)
+    assert(!ads_flatmap_insert(&map, ads_map_uint64_key(i), NULL));
+
+  // every table, including the ones replaced while growing, went back to the allocator
+  ads_flatmap_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_flatmap_insert_get_TEST();
+  ads_flatmap_remove_TEST();
+  ads_flatmap_tombstone_TEST();
+  ads_flatmap_allocator_TEST();
+
+  puts("FLATMAP TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/hash.h"
+#include "../include/map.h"
+
+static inline void ads_hash_known_answers_TEST(void) {
+  // test vectors of the reference wyhash (final4, default secret), hashed with seed = index
+  static const struct {
+    const char* data;
+    uint64_t hash;
+  } vectors[] = {
+    { "",               0x93228a4de0eec5a2 },
+    { "a",              0xc5bac3db178713c4 }, // 1 to 3 bytes
+    { "abc",            0xa97f2f7b1d9b3314 },
+    { "message digest", 0x786d1f1df3801df4 }, // 4 to 16 bytes
+    { "abcdefghijklmnopqrstuvwxyz", 0xdca5a8138ad37c87 }, // 17 to 48 bytes
+    { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 0xb9e734f117cfaf70 }, // above 48
+    { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", 0x6cc5eab49a92d617 }
+  };
+
+  for(size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    assert(ads_hash_bytes(vectors[i].data, strlen(vectors[i].data), i) == vectors[i].hash);
+}
+
+static inline void ads_hash_lengths_TEST(void) {
+  char buf[256 + 8];
+  for(size_t i = 0; i < sizeof(buf); i++)
+    buf[i] = (char) (i * 31 + 7);
+
+  for(size_t size = 0; size <= 256; size++) {
+    size_t hash = ads_hash_bytes(buf, size, 42);
+
+    // the reads are unaligned-safe: the same bytes anywhere in memory hash the same
+    for(size_t offset = 1; offset < 8; offset++) {
+      memmove(buf + offset, buf, size);
+      assert(ads_hash_bytes(buf + offset, size, 42) == hash);
+      memmove(buf, buf + offset, size);
+    }
+
+    // every byte of the key counts, including the ones read twice by overlapping reads
+    for(size_t i = 0; i < size; i++) {
+      buf[i] ^= 1;
+      assert(ads_hash_bytes(buf, size, 42) != hash);
+      buf[i] ^= 1;
+    }
+
+    // a prefix isn't the same key
+    if(size > 0)
+      assert(ads_hash_bytes(buf, size - 1, 42) != hash);
+  }
+}
+
+static inline void ads_hash_seed_TEST(void) {
+  const char* key = "seeded key";
+  size_t size = strlen(key);
+
+  assert(ads_hash_bytes(key, size, 0) != ads_hash_bytes(key, size, 1));
+  assert(ads_hash_bytes(key, size, 1) == ads_hash_bytes(key, size, 1));
+
+  // the string callbacks of the maps use the process-wide seed
+  size_t seed = ads_hash_get_seed();
+  assert(ADS_MAP_HASH_STRING((void*) key) == ads_hash_bytes(key, size, seed));
+
+  ads_hash_set_seed(seed + 0x9e3779b97f4a7c15);
+  assert(ads_hash_get_seed() == seed + 0x9e3779b97f4a7c15);
+  assert(ADS_MAP_HASH_STRING((void*) key) == ads_hash_bytes(key, size, ads_hash_get_seed()));
+  assert(ADS_MAP_HASH_STRING((void*) key) != ads_hash_bytes(key, size, seed));
+
+  ads_hash_set_seed(seed);
+  assert(ADS_MAP_HASH_STRING((void*) key) == ads_hash_bytes(key, size, seed));
+}
+
+int main() {
+
+  ads_hash_known_answers_TEST();
+  ads_hash_lengths_TEST();
+  ads_hash_seed_TEST();
+
+  puts("HASH TEST: OK");
+
+  return 0;
+}
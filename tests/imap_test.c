@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/imap.h"
+#include "../include/map.h"
+
+static inline void ads_imap_insert_get_TEST(void) {
+  ads_imap_t map;
+  assert(!ads_imap_init(&map, 4, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // enough keys to double the table several times
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_imap_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+
+  assert(ads_imap_get_size(&map) == 10000);
+  assert(ads_imap_get_buckets(&map) >= 10000 / ADS_IMAP_MAX_LOAD_FACTOR);
+
+  void* out = NULL;
+  for(size_t i = 0; i < 10000; i++) {
+    ads_imap_entry_t* entry = ads_imap_get(&map, ads_map_uint64_key(i), &out);
+    assert(entry && (size_t) out == i * 2);
+    assert((size_t) entry->link.key == i);
+    assert(entry->link.hash == ADS_MAP_HASH_UINT64(ads_map_uint64_key(i)));
+  }
+
+  // update an existing key
+  assert(!ads_imap_insert(&map, ads_map_uint64_key(5), ads_map_uint64_key(50)));
+  assert(ads_imap_get_size(&map) == 10000);
+  assert(ads_imap_get(&map, ads_map_uint64_key(5), &out) && (size_t) out == 50);
+
+  assert(ads_imap_get(&map, ads_map_uint64_key(123456), NULL) == NULL);
+
+  ads_imap_destroy(&map);
+  assert(map.htable == NULL && ads_imap_is_empty(&map));
+}
+
+static inline void ads_imap_remove_TEST(void) {
+  ads_imap_t map;
+  assert(!ads_imap_init(&map, 1, free, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  char key[32];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    assert(!ads_imap_insert(&map, strdup(key), strdup(key)));
+  }
+
+  // replacing a value frees the old one, the map keeps the first key
+  assert(!ads_imap_insert(&map, "key-10", strdup("ten")));
+  char* value = NULL;
+  assert(ads_imap_get(&map, "key-10", (void**) &value) && strcmp(value, "ten") == 0);
+
+  // with `out` the caller takes the value over, without it destroy frees it
+  void* key10 = ads_imap_get(&map, "key-10", NULL)->link.key;
+  void* key11 = ads_imap_get(&map, "key-11", NULL)->link.key;
+  assert(!ads_imap_remove(&map, "key-10", (void**) &value));
+  assert(strcmp(value, "ten") == 0);
+  free(value);
+  assert(ads_imap_remove(&map, "key-10", NULL) == ADS_NOTFOUND);
+  assert(!ads_imap_remove(&map, "key-11", NULL));
+  assert(ads_imap_get_size(&map) == 998);
+  free(key10);
+  free(key11);
+
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    assert((ads_imap_get(&map, key, NULL) == NULL) == (i == 10 || i == 11));
+  }
+
+  // the keys are the caller's, collect them before destroy frees the values
+  char* keys[1000];
+  size_t n = 0;
+  for(size_t i = 0; i < ads_imap_get_buckets(&map); i++) {
+    for(ads_imap_link_t* link = map.htable[i]; link; link = link->next)
+      keys[n++] = link->key;
+  }
+  assert(n == 998);
+
+  ads_imap_destroy(&map);
+  for(size_t i = 0; i < n; i++)
+    free(keys[i]);
+}
+
+typedef struct ads_imap_item {
+  int id;
+  ads_imap_link_t link;
+  int visited;
+} ads_imap_item_t;
+
+static inline void ads_imap_intrusive_TEST(void) {
+  enum { ITEMS = 2000 };
+  static ads_imap_item_t items[ITEMS];
+
+  ads_imap_t map;
+  assert(!ads_imap_init_intrusive(&map, 2, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(int i = 0; i < ITEMS; i++) {
+    items[i].id = i;
+    assert(ads_imap_link(&map, &items[i].link, ads_map_uint64_key(i)) == NULL);
+  }
+  assert(ads_imap_get_size(&map) == ITEMS);
+  assert(ads_imap_get_buckets(&map) >= ITEMS);
+
+  // the links found are the ones embedded in the items
+  for(int i = 0; i < ITEMS; i++) {
+    ads_imap_link_t* link = ads_imap_find(&map, ads_map_uint64_key(i));
+    assert(link == &items[i].link);
+    assert(ads_imap_container_of(link, ads_imap_item_t, link)->id == i);
+  }
+  assert(ads_imap_find(&map, ads_map_uint64_key(ITEMS)) == NULL);
+
+  // linking a key already there hands the old link back
+  ads_imap_item_t other = { .id = -1 };
+  assert(ads_imap_link(&map, &other.link, ads_map_uint64_key(7)) == &items[7].link);
+  assert(items[7].link.next == NULL);
+  assert(ads_imap_find(&map, ads_map_uint64_key(7)) == &other.link);
+  assert(ads_imap_get_size(&map) == ITEMS);
+  assert(ads_imap_link(&map, &items[7].link, ads_map_uint64_key(7)) == &other.link);
+
+  for(int i = 0; i < ITEMS; i += 2)
+    assert(ads_imap_unlink(&map, ads_map_uint64_key(i)) == &items[i].link);
+  assert(ads_imap_unlink(&map, ads_map_uint64_key(0)) == NULL);
+  assert(ads_imap_get_size(&map) == ITEMS / 2);
+
+  // walking the chains of every bucket visits each linked item once
+  size_t n = 0;
+  for(size_t i = 0; i < ads_imap_get_buckets(&map); i++) {
+    for(ads_imap_link_t* link = map.htable[i]; link; link = link->next, n++) {
+      ads_imap_item_t* item = ads_imap_container_of(link, ads_imap_item_t, link);
+      assert(item->id % 2 == 1 && !item->visited);
+      item->visited = 1;
+    }
+  }
+  assert(n == ITEMS / 2);
+
+  // the items are the caller's, destroy only releases the table
+  ads_imap_destroy(&map);
+  assert(items[1].id == 1);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_imap_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_imap_t map;
+  assert(!ads_imap_init_allocator(&map, 4, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(allocated == 4 * sizeof(ads_imap_link_t*));
+
+  for(size_t i = 0; i < 1000; i++)
+    assert(!ads_imap_insert(&map, ads_map_uint64_key(i), NULL));
+  assert(allocated == ads_imap_get_buckets(&map) * sizeof(ads_imap_link_t*) + 1000 * sizeof(ads_imap_entry_t));
+
+  for(size_t i = 0; i < 1000; i += 2)
+    assert(!ads_imap_remove(&map, ads_map_uint64_key(i), NULL));
+  assert(allocated == ads_imap_get_buckets(&map) * sizeof(ads_imap_link_t*) + 500 * sizeof(ads_imap_entry_t));
+
+  ads_imap_destroy(&map);
+  assert(allocated == 0);
+
+  // intrusive: the bucket arrays are the only allocations
+  static ads_imap_link_t links[100];
+  assert(!ads_imap_init_intrusive_allocator(&map, 0, &allocator, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  for(size_t i = 0; i < 100; i++)
+    assert(ads_imap_link(&map, &links[i], ads_map_uint64_key(i)) == NULL);
+  assert(allocated == ads_imap_get_buckets(&map) * sizeof(ads_imap_link_t*));
+
+  ads_imap_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_imap_insert_get_TEST();
+  ads_imap_remove_TEST();
+  ads_imap_intrusive_TEST();
+  ads_imap_allocator_TEST();
+
+  puts("IMAP TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,285 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/lru.h"
+
+#define ads_lru_key(key) ads_map_uint64_key(key)
+
+// every call to evict, in order
+static struct {
+  void* key;
+  void* value;
+} evicted[64];
+static size_t n_evicted = 0;
+
+static void ads_lru_record(void* key, void* value) {
+  assert(n_evicted < sizeof(evicted) / sizeof(evicted[0]));
+  evicted[n_evicted].key = key;
+  evicted[n_evicted].value = value;
+  n_evicted++;
+}
+
+#define ads_lru_evicted(i, k, v) (evicted[(i)].key == (k) && evicted[(i)].value == (v))
+
+static inline void ads_lru_order_TEST(void) {
+  ads_lru_t lru;
+  n_evicted = 0;
+  assert(!ads_lru_init(&lru, 3, ads_lru_record, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 1; i <= 3; i++)
+    assert(!ads_lru_insert(&lru, ads_lru_key(i), ads_lru_key(i * 10), 1));
+  assert(ads_lru_get_size(&lru) == 3 && ads_lru_get_cost(&lru) == 3);
+  assert(n_evicted == 0);
+
+  // a hit makes 1 the most recently used, so 2 goes first
+  void* out = NULL;
+  ads_lru_item_t* item = ads_lru_get(&lru, ads_lru_key(1), &out);
+  assert(item && (size_t) out == 10 && item->key == ads_lru_key(1) && item->cost == 1);
+
+  assert(!ads_lru_insert(&lru, ads_lru_key(4), ads_lru_key(40), 1));
+  assert(n_evicted == 1 && ads_lru_evicted(0, ads_lru_key(2), ads_lru_key(20)));
+  assert(ads_lru_get(&lru, ads_lru_key(2), NULL) == NULL);
+
+  // peek leaves the order as it is: 3 is still the least recently used
+  assert(ads_lru_peek(&lru, ads_lru_key(3), &out) && (size_t) out == 30);
+  assert(!ads_lru_insert(&lru, ads_lru_key(5), ads_lru_key(50), 1));
+  assert(n_evicted == 2 && ads_lru_evicted(1, ads_lru_key(3), ads_lru_key(30)));
+
+  // 1, 4, 5 are left, in that order of recency
+  assert(!ads_lru_insert(&lru, ads_lru_key(6), ads_lru_key(60), 1));
+  assert(!ads_lru_insert(&lru, ads_lru_key(7), ads_lru_key(70), 1));
+  assert(n_evicted == 4);
+  assert(ads_lru_evicted(2, ads_lru_key(1), ads_lru_key(10)));
+  assert(ads_lru_evicted(3, ads_lru_key(4), ads_lru_key(40)));
+
+  ads_lru_stats_t stats;
+  ads_lru_get_stats(&lru, &stats);
+  assert(stats.size == 3 && stats.cost == 3);
+  assert(stats.hits == 1 && stats.misses == 1 && stats.evictions == 4);
+
+  // the rest is evicted on destroy
+  ads_lru_destroy(&lru);
+  assert(n_evicted == 7);
+}
+
+static inline void ads_lru_cost_TEST(void) {
+  ads_lru_t lru;
+  n_evicted = 0;
+  assert(!ads_lru_init(&lru, 10, ads_lru_record, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  assert(!ads_lru_insert(&lru, ads_lru_key(1), NULL, 4));
+  assert(!ads_lru_insert(&lru, ads_lru_key(2), NULL, 4));
+  assert(ads_lru_get_cost(&lru) == 8);
+
+  // above the capacity on its own: rejected, and nothing is evicted for it
+  assert(ads_lru_insert(&lru, ads_lru_key(3), NULL, 11) == ADS_OUTOFBOUNDS);
+  assert(ads_lru_get_size(&lru) == 2 && n_evicted == 0);
+
+  // only as many entries as needed are evicted to fit the new one
+  assert(!ads_lru_insert(&lru, ads_lru_key(3), NULL, 5));
+  assert(n_evicted == 1 && evicted[0].key == ads_lru_key(1));
+  assert(ads_lru_get_cost(&lru) == 9 && ads_lru_get_size(&lru) == 2);
+
+  // an entry as costly as the whole cache leaves it alone
+  assert(!ads_lru_insert(&lru, ads_lru_key(4), NULL, 10));
+  assert(n_evicted == 3 && ads_lru_get_size(&lru) == 1 && ads_lru_get_cost(&lru) == 10);
+
+  for(size_t i = 5; i < 15; i++)
+    assert(!ads_lru_insert(&lru, ads_lru_key(i), NULL, 1));
+  assert(ads_lru_get_cost(&lru) == 10 && ads_lru_get_size(&lru) == 10);
+
+  // a replace that costs more trims the others
+  assert(!ads_lru_insert(&lru, ads_lru_key(14), NULL, 4));
+  assert(ads_lru_get_cost(&lru) == 10 && ads_lru_get_size(&lru) == 7);
+  assert(ads_lru_peek(&lru, ads_lru_key(14), NULL)->cost == 4);
+  assert(!ads_lru_peek(&lru, ads_lru_key(7), NULL) && ads_lru_peek(&lru, ads_lru_key(8), NULL));
+
+  ads_lru_trim(&lru, 5);
+  assert(ads_lru_get_cost(&lru) == 5 && ads_lru_get_size(&lru) == 2);
+  ads_lru_trim(&lru, 0);
+  assert(ads_lru_is_empty(&lru) && ads_lru_get_cost(&lru) == 0);
+
+  ads_lru_stats_t stats;
+  ads_lru_get_stats(&lru, &stats);
+  assert(stats.evictions == n_evicted - 1); // the replace released a value, but isn't an eviction
+
+  ads_lru_destroy(&lru);
+}
+
+static inline void ads_lru_replace_remove_TEST(void) {
+  ads_lru_t lru;
+  n_evicted = 0;
+  assert(!ads_lru_init(&lru, 10, ads_lru_record, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  char key1[] = "key", key2[] = "key";
+  assert(!ads_lru_insert(&lru, key1, "one", 1));
+
+  // the same key pointer again: only the old value is released
+  assert(!ads_lru_insert(&lru, key1, "two", 1));
+  assert(n_evicted == 1 && evicted[0].key == NULL && strcmp(evicted[0].value, "one") == 0);
+
+  // an equal key with another pointer: the old key goes too, the cache keeps the new one
+  assert(!ads_lru_insert(&lru, key2, "three", 1));
+  assert(n_evicted == 2 && evicted[1].key == key1 && strcmp(evicted[1].value, "two") == 0);
+  assert(ads_lru_peek(&lru, "key", NULL)->key == key2);
+  assert(ads_lru_get_size(&lru) == 1);
+
+  ads_lru_stats_t stats;
+  ads_lru_get_stats(&lru, &stats);
+  assert(stats.evictions == 0); // replaces aren't evictions
+
+  // with `out` the caller takes the value, evict only gets the key
+  void* out = NULL;
+  assert(!ads_lru_remove(&lru, "key", &out));
+  assert(strcmp(out, "three") == 0);
+  assert(n_evicted == 3 && ads_lru_evicted(2, key2, NULL));
+  assert(ads_lru_remove(&lru, "key", NULL) == ADS_NOTFOUND);
+
+  // without it, both
+  assert(!ads_lru_insert(&lru, key1, "four", 2));
+  assert(!ads_lru_remove(&lru, "key", NULL));
+  assert(n_evicted == 4 && evicted[3].key == key1 && strcmp(evicted[3].value, "four") == 0);
+  assert(ads_lru_is_empty(&lru) && ads_lru_get_cost(&lru) == 0);
+
+  ads_lru_destroy(&lru);
+  assert(n_evicted == 4);
+}
+
+/* ----- SHARDED CACHE ----- */
+
+static inline void ads_clru_TEST(void) {
+  ads_clru_t lru;
+  n_evicted = 0;
+
+  // every shard needs room for one entry
+  assert(ads_clru_init(&lru, 3, 3, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64) == ADS_INVALID);
+
+  // rounded up to 4 shards, and the remainder of 10 / 4 goes to the first ones
+  assert(!ads_clru_init(&lru, 3, 10, ads_lru_record, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_clru_get_shards(&lru) == 4);
+
+  size_t capacity = 0;
+  for(size_t i = 0; i < 4; i++) {
+    assert(ads_lru_get_capacity(&lru.shards[i].lru) == (i < 2 ? 3 : 2));
+    capacity += ads_lru_get_capacity(&lru.shards[i].lru);
+  }
+  assert(capacity == 10);
+
+  // each shard evicts on its own, within its part of the capacity
+  for(size_t i = 0; i < 1000; i++) {
+    assert(!ads_clru_insert(&lru, ads_lru_key(i), ads_lru_key(i), 1));
+
+    for(size_t s = 0; s < 4; s++) {
+      ads_lru_t* shard = &lru.shards[s].lru;
+      assert(ads_lru_get_cost(shard) <= ads_lru_get_capacity(shard));
+    }
+
+    if(n_evicted == 64)
+      n_evicted = 0;
+  }
+
+  // the last key inserted is always there
+  void* out = NULL;
+  assert(!ads_clru_get(&lru, ads_lru_key(999), &out) && (size_t) out == 999);
+  assert(ads_clru_get(&lru, ads_lru_key(0), NULL) == ADS_NOTFOUND);
+
+  ads_lru_stats_t stats;
+  ads_clru_get_stats(&lru, &stats);
+  assert(stats.size == 10 && stats.cost == 10);
+  assert(stats.evictions == 990);
+  assert(stats.hits == 1 && stats.misses == 1);
+
+  assert(!ads_clru_remove(&lru, ads_lru_key(999), &out) && (size_t) out == 999);
+  assert(ads_clru_remove(&lru, ads_lru_key(999), NULL) == ADS_NOTFOUND);
+
+  ads_clru_get_stats(&lru, &stats);
+  assert(stats.size == 9);
+
+  n_evicted = 0;
+  ads_clru_destroy(&lru);
+  assert(n_evicted == 9);
+}
+
+static void ads_clru_sum(void* key, void* value, void* arg) {
+  *(size_t*) arg += (size_t) key + (size_t) value;
+}
+
+static inline void ads_clru_visit_TEST(void) {
+  ads_clru_t lru;
+  assert(!ads_clru_init(&lru, 2, 100, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  assert(!ads_clru_insert(&lru, ads_lru_key(1), ads_lru_key(2), 1));
+
+  size_t sum = 0;
+  assert(!ads_clru_visit(&lru, ads_lru_key(1), ads_clru_sum, &sum));
+  assert(sum == 3);
+  assert(ads_clru_visit(&lru, ads_lru_key(2), ads_clru_sum, &sum) == ADS_NOTFOUND);
+  assert(sum == 3);
+
+  assert(ads_clru_insert(&lru, ads_lru_key(2), NULL, 51) == ADS_OUTOFBOUNDS);
+
+  ads_clru_destroy(&lru);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_lru_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_lru_t lru;
+  assert(!ads_lru_init_allocator(&lru, 10, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(lru.map.allocator == &allocator && lru.order.allocator == &allocator);
+
+  for(size_t i = 0; i < 100; i++)
+    assert(!ads_lru_insert(&lru, ads_lru_key(i), NULL, 1));
+  assert(!ads_lru_remove(&lru, ads_lru_key(99), NULL));
+  assert(allocated > 0);
+
+  // the evicted and removed entries went back to the allocator, the rest goes on destroy
+  ads_lru_destroy(&lru);
+  assert(allocated == 0);
+
+  ads_clru_t clru;
+  assert(!ads_clru_init_allocator(&clru, 4, 100, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_is_aligned(clru.shards, ADS_CLRU_CACHE_LINE));
+  for(size_t i = 0; i < 4; i++)
+    assert(clru.shards[i].lru.map.allocator == &allocator);
+
+  for(size_t i = 0; i < 1000; i++)
+    assert(!ads_clru_insert(&clru, ads_lru_key(i), NULL, 1));
+
+  ads_clru_destroy(&clru);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_lru_order_TEST();
+  ads_lru_cost_TEST();
+  ads_lru_replace_remove_TEST();
+  ads_clru_TEST();
+  ads_clru_visit_TEST();
+  ads_lru_allocator_TEST();
+
+  puts("LRU TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/map.h"
+#include "../include/iterator.h"
+
+
+static inline void ads_map_insert_get_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 8, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // insert enough keys to force the table to grow several times
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+
+  assert(ads_map_get_size(&map) == 10000);
+  assert(ads_map_get_buckets(&map) > 8);
+
+  // every key must be found, even while the table is being rehashed
+  void* out = NULL;
+  for(size_t i = 0; i < 10000; i++) {
+    assert(ads_map_get(&map, ads_map_uint64_key(i), &out) != NULL);
+    assert((size_t) out == i * 2);
+  }
+
+  // update an existing key
+  assert(!ads_map_insert(&map, ads_map_uint64_key(5), ads_map_uint64_key(50)));
+  assert(ads_map_get_size(&map) == 10000);
+  ads_map_get(&map, ads_map_uint64_key(5), &out);
+  assert((size_t) out == 50);
+
+  // key not in the map
+  assert(ads_map_get(&map, ads_map_uint64_key(123456), NULL) == NULL);
+
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_remove_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 4, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // factors that would divide by zero or make the table shrink and grow back are rejected
+  assert(ads_map_set_load_factor(&map, 0.0, 0.0) == ADS_INVALID);
+  assert(ads_map_set_load_factor(&map, -1.0, 0.0) == ADS_INVALID);
+  assert(ads_map_set_load_factor(&map, 1.0, 1.0) == ADS_INVALID);
+  assert(ads_map_set_load_factor(&map, 1.0, 0.75) == ADS_INVALID);
+  assert(ads_map_set_load_factor(&map, 1.0, -0.5) == ADS_INVALID);
+
+  // enable shrinking
+  assert(!ads_map_set_load_factor(&map, 1.0, 0.25));
+
+  for(size_t i = 0; i < 4096; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i)));
+  size_t grown_buckets = ads_map_get_buckets(&map);
+
+  void* out = NULL;
+  for(size_t i = 0; i < 4096; i += 2) {
+    assert(!ads_map_remove(&map, ads_map_uint64_key(i), &out));
+    assert((size_t) out == i);
+  }
+
+  // removing a key twice
+  assert(ads_map_remove(&map, ads_map_uint64_key(0), NULL) == ADS_NOTFOUND);
+
+  for(size_t i = 1; i < 4096; i += 2)
+    assert(ads_map_get(&map, ads_map_uint64_key(i), NULL) != NULL);
+
+  for(size_t i = 1; i < 4096; i += 2)
+    assert(!ads_map_remove(&map, ads_map_uint64_key(i), NULL));
+
+  // the table must shrink, but never below the initial number of buckets
+  assert(ads_map_is_empty(&map));
+  assert(ads_map_get_buckets(&map) < grown_buckets);
+  assert(ads_map_get_buckets(&map) >= 4);
+
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_reserve_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 1, free, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  assert(!ads_map_reserve(&map, 1000));
+  assert(ads_map_get_buckets(&map) >= 1000);
+  assert(!ads_map_is_rehashing(&map));
+
+  char key[32];
+  char* keys[1000];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    keys[i] = strdup(key);
+    assert(!ads_map_insert(&map, keys[i], strdup(key)));
+  }
+
+  // no resize was needed
+  assert(!ads_map_is_rehashing(&map));
+
+  char* value = NULL;
+  assert(ads_map_get(&map, "key-999", (void**) &value) != NULL);
+  assert(strcmp(value, "key-999") == 0);
+
+  ads_map_destroy(&map);
+  for(int i = 0; i < 1000; i++)
+    free(keys[i]);
+}
+
+static inline void ads_map_reserve_paused_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 8, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // stop right after a resize started, with buckets still in the old table
+  size_t size = 0;
+  while(!ads_map_is_rehashing(&map)) {
+    assert(!ads_map_insert(&map, ads_map_uint64_key(size), NULL));
+    size++;
+  }
+
+  // entries can't move while an iterator is out, so nothing can be reserved
+  ads_map_pause_rehash(&map);
+  size_t buckets = ads_map_get_buckets(&map);
+  assert(ads_map_reserve(&map, 1000) == ADS_INVALID);
+  assert(ads_map_get_buckets(&map) == buckets);
+  assert(ads_map_is_rehashing(&map));
+  ads_map_resume_rehash(&map);
+
+  assert(!ads_map_reserve(&map, 1000));
+  assert(ads_map_get_buckets(&map) >= 1000);
+  assert(!ads_map_is_rehashing(&map));
+
+  for(size_t i = 0; i < size; i++)
+    assert(ads_map_get(&map, ads_map_uint64_key(i), NULL) != NULL);
+
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_pow2_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init_flags(&map, 100, ADS_MAP_POW2, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  // buckets are rounded up to a power of two
+  assert(ads_map_get_buckets(&map) == 128);
+
+  for(size_t i = 0; i < 5000; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i)));
+
+  // the table keeps being a power of two after growing
+  size_t buckets = ads_map_get_buckets(&map);
+  assert((buckets & (buckets - 1)) == 0);
+
+  for(size_t i = 0; i < 5000; i++)
+    assert(ads_map_get(&map, ads_map_uint64_key(i), NULL) != NULL);
+
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_batch_TEST(void) {
+  enum { COUNT = 3000 };
+  static void* keys[COUNT];
+  static void* values[COUNT];
+  static void* out[COUNT];
+  static ads_map_entry_t* entries[COUNT];
+
+  ads_map_t batch, single;
+  assert(!ads_map_init(&batch, 8, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(!ads_map_init(&single, 8, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  /* keys repeat within a batch window (i / 2) and the table grows several times while the
+     batch is inserted: the last value of a key wins, as with one insert after the other */
+  for(size_t i = 0; i < COUNT; i++) {
+    keys[i]   = ads_map_uint64_key(i / 2);
+    values[i] = ads_map_uint64_key(i);
+    assert(!ads_map_insert(&single, keys[i], values[i]));
+  }
+  assert(!ads_map_insert_batch(&batch, keys, values, COUNT));
+  assert(ads_map_get_size(&batch) == COUNT / 2);
+  assert(ads_map_get_size(&batch) == ads_map_get_size(&single));
+
+  // present and missing keys mixed, some of them twice, looked up while the table is rehashing
+  for(size_t extra = 10 * COUNT; !ads_map_is_rehashing(&batch); extra++)
+    assert(!ads_map_insert(&batch, ads_map_uint64_key(extra), NULL));
+
+  for(size_t i = 0; i < COUNT; i++) {
+    keys[i] = ads_map_uint64_key(i % 3 == 0 ? i / 3 : COUNT + i);
+    out[i]  = ads_map_uint64_key(-1);
+  }
+  size_t found = ads_map_get_batch(&batch, keys, COUNT, entries, out);
+  assert(found == (COUNT + 2) / 3);
+
+  for(size_t i = 0; i < COUNT; i++) {
+    void* expected = NULL;
+    ads_map_entry_t* entry = ads_map_get(&single, keys[i], &expected);
+    assert((entry != NULL) == (entries[i] != NULL));
+
+    if(entry) {
+      assert(entries[i] == ads_map_lookup(&batch, keys[i], NULL));
+      assert(entries[i]->key == keys[i] && out[i] == expected);
+    }
+    else
+      assert(out[i] == ads_map_uint64_key(-1)); // left untouched for missing keys
+  }
+
+  // entries and out are optional
+  assert(ads_map_get_batch(&batch, keys, COUNT, NULL, NULL) == found);
+  assert(ads_map_get_batch(&batch, keys, 0, NULL, NULL) == 0);
+
+  ads_map_destroy(&batch);
+  ads_map_destroy(&single);
+}
+
+static inline void ads_map_iterator_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 1024, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  ads_iterator_t it;
+  ads_map_entry_t* entry = NULL;
+
+  // empty map
+  ads_iterator_init(&it, &map, ADS_ITERATOR_MAP);
+  assert(!ads_iterator_iterate(&it, (void**) &entry));
+
+  // insert until the table is in the middle of a rehash
+  size_t inserted = 0;
+  while(!ads_map_is_rehashing(&map)) {
+    assert(!ads_map_insert(&map, ads_map_uint64_key(inserted), ads_map_uint64_key(inserted)));
+    inserted++;
+  }
+
+  // every entry is visited once, in both tables
+  size_t visited = 0, sum = 0;
+  while(ads_iterator_iterate(&it, (void**) &entry)) {
+    visited++;
+    sum += (size_t) entry->key;
+  }
+  assert(visited == inserted);
+  assert(sum == inserted * (inserted - 1) / 2);
+
+  // removing the current entry while iterating
+  while(ads_iterator_iterate(&it, (void**) &entry)) {
+    if((size_t) entry->key % 2 == 0)
+      assert(!ads_map_remove(&map, entry->key, NULL));
+  }
+  assert(ads_map_get_size(&map) == inserted / 2);
+
+  // stopping in the middle and resetting lets the map rehash again
+  assert(ads_iterator_iterate(&it, (void**) &entry));
+  ads_iterator_reset(&it);
+  assert(map.iterators == 0);
+
+  ads_iterator_destroy(&it);
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_stats_TEST(void) {
+  ads_map_t map;
+  assert(!ads_map_init(&map, 64, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 0; i < 32; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), NULL));
+
+  ads_map_stats_t stats;
+  ads_map_get_stats(&map, &stats);
+  assert(stats.size == 32);
+  assert(stats.buckets == 64);
+  assert(stats.max_chain >= 1);
+  assert(stats.buckets - stats.empty_buckets <= 32);
+
+  for(size_t i = 0; i < 40; i++)
+    ads_map_get(&map, ads_map_uint64_key(i), NULL);
+
+#ifdef ADS_MAP_STATS
+  ads_map_get_stats(&map, &stats);
+  assert(stats.counters.hits == 32);
+  assert(stats.counters.misses == 8);
+
+  size_t lookups = 0;
+  for(size_t i = 0; i < ADS_MAP_STATS_PROBES; i++)
+    lookups += stats.counters.probes[i];
+  assert(lookups == 40);
+
+  ads_map_reset_stats(&map);
+  ads_map_get_stats(&map, &stats);
+  assert(stats.counters.hits == 0 && stats.counters.misses == 0);
+#endif
+
+  ads_map_destroy(&map);
+}
+
+static inline void ads_map_bloom_TEST(void) {
+  ads_map_t map;
+  assert(!ads_map_init_flags(&map, 8, ADS_MAP_BLOOM, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  ads_map_set_load_factor(&map, 1.0, 0.25);
+
+  /* several resizes. The filter of a new table starts empty and is filled as the entries are
+     moved, the keys not moved yet are found through the old one */
+  for(size_t i = 0; i < 5000; i++) {
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i)));
+
+    if(ads_map_is_rehashing(&map) && map.rehash_index == 0) {
+      assert(ads_bloom_get_count(&map.bloom) <= i);
+      for(size_t j = 0; j <= i; j++)
+        assert(ads_map_lookup(&map, ads_map_uint64_key(j), NULL));
+    }
+  }
+
+  size_t false_positives = 0;
+  for(size_t i = 0; i < 10000; i++) {
+    int present = ads_map_get(&map, ads_map_uint64_key(i), NULL) != NULL;
+    assert(present == (i < 5000));
+    false_positives += i >= 5000 && ads_bloom_may_contain(&map.bloom, ADS_MAP_HASH_UINT64(ads_map_uint64_key(i)));
+  }
+  assert(false_positives < 5000 / 20);
+
+  // removing purges and shrinks; the remaining keys must still be found
+  for(size_t i = 0; i < 5000; i++) {
+    if(i % 7)
+      assert(!ads_map_remove(&map, ads_map_uint64_key(i), NULL));
+  }
+  assert(ads_bloom_get_count(&map.bloom) <= 2 * ads_map_get_size(&map) + ads_bloom_get_blocks(&map.bloom));
+
+  // the filters of both tables are checked while a purge or shrink is under way
+  for(size_t i = 0; i < 5000; i++)
+    assert((ads_map_lookup(&map, ads_map_uint64_key(i), NULL) != NULL) == (i % 7 == 0));
+
+  for(size_t i = 0; i < 5000; i++)
+    assert((ads_map_get(&map, ads_map_uint64_key(i), NULL) != NULL) == (i % 7 == 0));
+
+  assert(ads_map_remove(&map, ads_map_uint64_key(1), NULL) == ADS_NOTFOUND);
+
+  ads_map_destroy(&map);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_map_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  // the Bloom filters come from the map's allocator too, aligned to their blocks
+  ads_map_t map;
+  assert(!ads_map_init_allocator(&map, 8, ADS_MAP_BLOOM, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(allocated > 0 && map.bloom.allocator == &allocator);
+  assert(ads_is_aligned(map.bloom.blocks, ADS_BLOOM_BLOCK_SIZE));
+
+  for(size_t i = 0; i < 5000; i++) {
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), NULL));
+    if(map.old_bloom.blocks)
+      assert(ads_is_aligned(map.old_bloom.blocks, ADS_BLOOM_BLOCK_SIZE));
+  }
+  for(size_t i = 0; i < 5000; i += 2)
+    assert(!ads_map_remove(&map, ads_map_uint64_key(i), NULL));
+
+  // every table and filter, including the ones replaced while resizing, went back to the allocator
+  ads_map_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_map_insert_get_TEST();
+  ads_map_remove_TEST();
+  ads_map_reserve_TEST();
+  ads_map_reserve_paused_TEST();
+  ads_map_pow2_TEST();
+  ads_map_batch_TEST();
+  ads_map_iterator_TEST();
+  ads_map_stats_TEST();
+  ads_map_bloom_TEST();
+  ads_map_allocator_TEST();
+
+  puts("MAP TEST: OK");
+
+  return 0;
+}
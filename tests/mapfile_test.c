@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "../include/mapfile.h"
+
+static char dir[] = "/tmp/ads_mapfile_XXXXXX";
+
+// `name` inside the test directory
+static const char* ads_mapfile_path(const char* name) {
+  static char path[256];
+  sprintf(path, "%s/%s", dir, name);
+  return path;
+}
+
+// files in the test directory, temporary ones included
+static size_t ads_mapfile_count_files(void) {
+  DIR* d = opendir(dir);
+  assert(d);
+
+  size_t count = 0;
+  struct dirent* entry;
+  while((entry = readdir(d)))
+    count += entry->d_name[0] != '.';
+
+  closedir(d);
+  return count;
+}
+
+static inline void ads_mapfile_string_TEST(void) {
+  ads_map_t map;
+  assert(!ads_map_init(&map, 16, free, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  static char keys[1000][16];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(keys[i], "key-%d", i);
+    assert(!ads_map_insert(&map, keys[i], i == 7 ? NULL : strdup(keys[i] + 4)));
+  }
+
+  const char* path = ads_mapfile_path("string.map");
+  assert(!ads_mapfile_write(&map, path, ADS_MAPFILE_STRING, NULL));
+  ads_map_destroy(&map);
+
+  // nothing left behind but the file
+  assert(ads_mapfile_count_files() == 1);
+
+  ads_mapfile_t file;
+  assert(!ads_mapfile_open(&file, path));
+  assert(ads_mapfile_get_size(&file) == 1000);
+
+  size_t size = 0;
+  for(int i = 0; i < 1000; i++) {
+    const char* value = ads_mapfile_get_string(&file, keys[i], &size);
+    assert(value);
+    if(i == 7)
+      assert(size == 0); // NULL values are stored empty
+    else
+      assert(size == strlen(keys[i] + 4) + 1 && strcmp(value, keys[i] + 4) == 0);
+  }
+
+  assert(ads_mapfile_get_string(&file, "key-1000", NULL) == NULL);
+  assert(ads_mapfile_get_string(&file, "key", NULL) == NULL);
+  assert(ads_mapfile_get_uint64(&file, 1, NULL) == NULL); // wrong key type
+
+  ads_mapfile_close(&file);
+  assert(file.base == NULL);
+}
+
+// the same buffer for every value, as most serializers do
+static const void* ads_mapfile_serialize_uint64(void* value, size_t* size) {
+  static char buf[32];
+  *size = (size_t) sprintf(buf, "value %zu", (size_t) value);
+  return buf;
+}
+
+static inline void ads_mapfile_uint64_TEST(void) {
+  ads_map_t map;
+  assert(!ads_map_init(&map, 16, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 0; i < 5000; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i * 3), ads_map_uint64_key(i)));
+
+  const char* path = ads_mapfile_path("uint64.map");
+  assert(!ads_mapfile_write(&map, path, ADS_MAPFILE_UINT64, ads_mapfile_serialize_uint64));
+
+  // writing again replaces the file
+  assert(!ads_map_insert(&map, ads_map_uint64_key(1), ads_map_uint64_key(123)));
+  assert(!ads_mapfile_write(&map, path, ADS_MAPFILE_UINT64, ads_mapfile_serialize_uint64));
+  ads_map_destroy(&map);
+
+  ads_mapfile_t file;
+  assert(!ads_mapfile_open(&file, path));
+  assert(ads_mapfile_get_size(&file) == 5001);
+
+  // every record holds its own value, not the last one left in the buffer
+  char expected[32];
+  size_t size = 0;
+  for(size_t i = 0; i < 5000; i++) {
+    const char* value = ads_mapfile_get_uint64(&file, i * 3, &size);
+    sprintf(expected, "value %zu", i);
+    assert(value && size == strlen(expected) && memcmp(value, expected, size) == 0);
+  }
+
+  const char* value = ads_mapfile_get_uint64(&file, 1, &size);
+  assert(value && size == strlen("value 123") && memcmp(value, "value 123", size) == 0);
+
+  assert(ads_mapfile_get_uint64(&file, 2, NULL) == NULL);
+  assert(ads_mapfile_get_string(&file, "1", NULL) == NULL);
+
+  ads_mapfile_close(&file);
+}
+
+static size_t serialized = 0;
+
+// a different size on every call
+static const void* ads_mapfile_serialize_unstable(void* value, size_t* size) {
+  (void) value;
+  *size = ++serialized % 8;
+  return "unstable";
+}
+
+static inline void ads_mapfile_write_fail_TEST(void) {
+  ads_map_t map;
+  assert(!ads_map_init(&map, 16, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  for(size_t i = 0; i < 10; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), NULL));
+
+  // the records wouldn't match the table: nothing is written, the temporary file is removed
+  size_t files = ads_mapfile_count_files();
+  const char* path = ads_mapfile_path("unstable.map");
+  assert(ads_mapfile_write(&map, path, ADS_MAPFILE_UINT64, ads_mapfile_serialize_unstable) == ADS_INVALID);
+  assert(access(path, F_OK) != 0);
+  assert(ads_mapfile_count_files() == files);
+
+  assert(ads_mapfile_write(&map, ads_mapfile_path("missing/dir.map"), ADS_MAPFILE_UINT64, NULL) == ADS_IOERROR);
+
+  ads_map_destroy(&map);
+}
+
+/* ----- CORRUPTED FILES ----- */
+
+static char* ads_mapfile_read(const char* path, size_t* size) {
+  FILE* in = fopen(path, "rb");
+  assert(in);
+  fseek(in, 0, SEEK_END);
+  *size = (size_t) ftell(in);
+  rewind(in);
+
+  char* data = malloc(*size);
+  assert(fread(data, 1, *size, in) == *size);
+  fclose(in);
+  return data;
+}
+
+static ads_status_t ads_mapfile_open_bytes(const void* data, size_t size) {
+  const char* path = ads_mapfile_path("corrupted.map");
+  FILE* out = fopen(path, "wb");
+  assert(out);
+  assert(fwrite(data, 1, size, out) == size);
+  fclose(out);
+
+  ads_mapfile_t file;
+  ads_status_t status = ads_mapfile_open(&file, path);
+  if(status == ADS_SUCCESS)
+    ads_mapfile_close(&file);
+
+  remove(path);
+  return status;
+}
+
+static inline void ads_mapfile_corrupted_TEST(void) {
+  ads_mapfile_t file;
+  assert(ads_mapfile_open(&file, ads_mapfile_path("none.map")) == ADS_IOERROR);
+
+  size_t size = 0;
+  char* good = ads_mapfile_read(ads_mapfile_path("string.map"), &size);
+  char* data = malloc(size);
+  ads_mapfile_header_t* header = (ads_mapfile_header_t*) data;
+
+  // the copy itself opens fine
+  memcpy(data, good, size);
+  assert(ads_mapfile_open_bytes(data, size) == ADS_SUCCESS);
+
+  // truncated: shorter than the header, or than the size it records
+  assert(ads_mapfile_open_bytes(data, sizeof(ads_mapfile_header_t) - 1) == ADS_INVALID);
+  assert(ads_mapfile_open_bytes(data, size - 8) == ADS_INVALID);
+  assert(ads_mapfile_open_bytes(data, 0) == ADS_INVALID);
+
+  header->magic[0] ^= 1;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->version = ADS_MAPFILE_VERSION + 1;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->key_type = 3;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  // the table past the end of the file, or partly out of it, or offsets that would overflow
+  memcpy(data, good, size);
+  header->slots_offset = size + 8;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->slots_offset = size - 8 * sizeof(ads_mapfile_slot_t);
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->slots_offset = UINT64_MAX - 7;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->slots = (uint64_t) 1 << 62;
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->slots = 3; // not a power of two
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  memcpy(data, good, size);
+  header->size = header->slots; // no empty slot
+  assert(ads_mapfile_open_bytes(data, size) == ADS_INVALID);
+
+  free(good);
+  free(data);
+}
+
+int main() {
+  assert(mkdtemp(dir));
+
+  ads_mapfile_string_TEST();
+  ads_mapfile_uint64_TEST();
+  ads_mapfile_write_fail_TEST();
+  ads_mapfile_corrupted_TEST();
+
+  remove(ads_mapfile_path("string.map"));
+  remove(ads_mapfile_path("uint64.map"));
+  assert(ads_mapfile_count_files() == 0);
+  rmdir(dir);
+
+  puts("MAPFILE TEST: OK");
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "../include/phmap.h"
+#include "../include/map.h"
+
+
+static inline void ads_phmap_build_TEST(void) {
+  void* keys[10000];
+  void* values[10000];
+  for(size_t i = 0; i < 10000; i++) {
+    keys[i]   = ads_map_uint64_key(i * 7);
+    values[i] = ads_map_uint64_key(i);
+  }
+
+  ads_phmap_t phmap;
+  assert(!ads_phmap_build(&phmap, keys, values, 10000, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_phmap_get_size(&phmap) == 10000);
+
+  void* out = NULL;
+  for(size_t i = 0; i < 10000; i++) {
+    assert(ads_phmap_get(&phmap, ads_map_uint64_key(i * 7), &out) != NULL);
+    assert((size_t) out == i);
+  }
+
+  // keys that aren't in the map still land on a slot, and must be rejected
+  for(size_t i = 0; i < 10000; i++)
+    assert(ads_phmap_get(&phmap, ads_map_uint64_key(i * 7 + 1), NULL) == NULL);
+
+  ads_phmap_destroy(&phmap);
+}
+
+static inline void ads_phmap_build_from_map_TEST(void) {
+  ads_map_t map = {0};
+  assert(!ads_map_init(&map, 8, free, ADS_MAP_COMPARE_STRING, ADS_MAP_HASH_STRING));
+
+  char key[32];
+  char* keys[1000];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    keys[i] = strdup(key);
+    assert(!ads_map_insert(&map, keys[i], strdup(key)));
+  }
+
+  ads_phmap_t phmap;
+  assert(!ads_phmap_build_from_map(&phmap, &map));
+  assert(ads_phmap_get_size(&phmap) == 1000);
+
+  char* value = NULL;
+  for(int i = 0; i < 1000; i++) {
+    assert(ads_phmap_get(&phmap, keys[i], (void**) &value) != NULL);
+    assert(strcmp(value, keys[i]) == 0);
+  }
+  assert(ads_phmap_get(&phmap, "key-1000", NULL) == NULL);
+
+  // the values still belong to `map`
+  ads_phmap_destroy(&phmap);
+  ads_map_destroy(&map);
+  for(int i = 0; i < 1000; i++)
+    free(keys[i]);
+}
+
+static inline void ads_phmap_duplicate_keys_TEST(void) {
+  void* keys[100];
+  void* values[100];
+  for(size_t i = 0; i < 100; i++) {
+    keys[i]   = ads_map_uint64_key(i);
+    values[i] = malloc(1);
+  }
+  keys[50] = ads_map_uint64_key(10);
+
+  ads_phmap_t phmap;
+  assert(ads_phmap_build(&phmap, keys, values, 100, free, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64) == ADS_INVALID);
+
+  // a failed build leaves an empty map, the values are still the caller's
+  assert(ads_phmap_get_size(&phmap) == 0);
+  assert(ads_phmap_get(&phmap, ads_map_uint64_key(10), NULL) == NULL);
+  ads_phmap_destroy(&phmap);
+
+  for(size_t i = 0; i < 100; i++)
+    free(values[i]);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_phmap_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  static void* keys[1000];
+  for(size_t i = 0; i < 1000; i++)
+    keys[i] = ads_map_uint64_key(i);
+
+  ads_phmap_t phmap;
+  assert(!ads_phmap_build_allocator(&phmap, keys, keys, 1000, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(allocated > 1000 * sizeof(ads_map_entry_t));
+
+  ads_phmap_destroy(&phmap);
+  assert(allocated == 0);
+
+  // a failed build gives its block back
+  keys[999] = keys[0];
+  assert(ads_phmap_build_allocator(&phmap, keys, keys, 1000, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64) == ADS_INVALID);
+  assert(allocated == 0);
+  ads_phmap_destroy(&phmap);
+
+  // built from a map, the block comes from the map's allocator
+  ads_map_t map;
+  assert(!ads_map_init_allocator(&map, 16, 0, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  for(size_t i = 0; i < 100; i++)
+    assert(!ads_map_insert(&map, ads_map_uint64_key(i), NULL));
+  size_t map_allocated = allocated;
+
+  assert(!ads_phmap_build_from_map(&phmap, &map));
+  assert(allocated > map_allocated);
+  ads_phmap_destroy(&phmap);
+  assert(allocated == map_allocated);
+
+  ads_map_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_phmap_build_TEST();
+  ads_phmap_build_from_map_TEST();
+  ads_phmap_duplicate_keys_TEST();
+  ads_phmap_allocator_TEST();
+
+  puts("PHMAP TEST: OK");
+
+  return 0;
+}
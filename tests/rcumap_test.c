@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../include/rcumap.h"
+#include "../include/map.h"
+
+
+static inline void ads_rcumap_init_TEST(void) {
+  ads_rcumap_t map;
+
+  // no reader could ever be registered
+  assert(ads_rcumap_init(&map, 8, 0, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64) == ADS_INVALID);
+
+  assert(!ads_rcumap_init(&map, 8, 2, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  ads_rcumap_reader_t* first  = ads_rcumap_reader_register(&map);
+  ads_rcumap_reader_t* second = ads_rcumap_reader_register(&map);
+  assert(first && second && first != second);
+  assert(ads_rcumap_reader_register(&map) == NULL);
+
+  // a slot released is handed out again
+  ads_rcumap_reader_unregister(first);
+  assert(ads_rcumap_reader_register(&map) == first);
+
+  ads_rcumap_reader_unregister(first);
+  ads_rcumap_reader_unregister(second);
+  ads_rcumap_destroy(&map);
+}
+
+static inline void ads_rcumap_insert_get_TEST(void) {
+  ads_rcumap_t map;
+  assert(!ads_rcumap_init(&map, 1, 1, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  ads_rcumap_reader_t* reader = ads_rcumap_reader_register(&map);
+  assert(reader);
+
+  // insert enough keys to publish bigger tables several times
+  for(size_t i = 0; i < 10000; i++)
+    assert(!ads_rcumap_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(i * 2)));
+
+  assert(ads_rcumap_get_size(&map) == 10000);
+
+  void* out = NULL;
+  ads_rcumap_read_lock(reader);
+  for(size_t i = 0; i < 10000; i++) {
+    assert(ads_rcumap_get(&map, ads_map_uint64_key(i), &out) == ADS_SUCCESS);
+    assert((size_t) out == i * 2);
+  }
+  assert(ads_rcumap_get(&map, ads_map_uint64_key(123456), NULL) == ADS_NOTFOUND);
+  ads_rcumap_read_unlock(reader);
+
+  // update an existing key
+  assert(!ads_rcumap_insert(&map, ads_map_uint64_key(5), ads_map_uint64_key(50)));
+  assert(ads_rcumap_get_size(&map) == 10000);
+
+  ads_rcumap_read_lock(reader);
+  assert(ads_rcumap_get(&map, ads_map_uint64_key(5), &out) == ADS_SUCCESS);
+  assert((size_t) out == 50);
+  ads_rcumap_read_unlock(reader);
+
+  for(size_t i = 0; i < 10000; i += 2)
+    assert(!ads_rcumap_remove(&map, ads_map_uint64_key(i), NULL));
+  assert(ads_rcumap_remove(&map, ads_map_uint64_key(0), NULL) == ADS_NOTFOUND);
+  assert(ads_rcumap_get_size(&map) == 5000);
+
+  ads_rcumap_read_lock(reader);
+  for(size_t i = 0; i < 10000; i++)
+    assert(ads_rcumap_get(&map, ads_map_uint64_key(i), NULL) == (i % 2 ? ADS_SUCCESS : ADS_NOTFOUND));
+  ads_rcumap_read_unlock(reader);
+
+  ads_rcumap_reader_unregister(reader);
+  ads_rcumap_destroy(&map);
+}
+
+static inline void ads_rcumap_remove_out_TEST(void) {
+  ads_rcumap_t map;
+  assert(!ads_rcumap_init(&map, 8, 1, free, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+
+  for(size_t i = 0; i < 100; i++) {
+    size_t* value = malloc(sizeof(size_t));
+    *value = i;
+    assert(!ads_rcumap_insert(&map, ads_map_uint64_key(i), value));
+  }
+
+  // the value given back is owned by the caller once no reader can see it
+  size_t* value = NULL;
+  assert(!ads_rcumap_remove(&map, ads_map_uint64_key(10), (void**) &value));
+  assert(*value == 10);
+  ads_rcumap_synchronize(&map);
+  free(value);
+
+  // the values left (and the ones replaced by updates) are released with `destroy`
+  assert(!ads_rcumap_insert(&map, ads_map_uint64_key(20), malloc(sizeof(size_t))));
+  assert(!ads_rcumap_remove(&map, ads_map_uint64_key(30), NULL));
+  ads_rcumap_destroy(&map);
+}
+
+/* ----- READERS AND A WRITER ----- */
+
+#define ADS_RCUMAP_TEST_KEYS    512
+#define ADS_RCUMAP_TEST_READERS 3
+#define ADS_RCUMAP_TEST_ROUNDS  20
+
+static ads_rcumap_t shared;
+static _Atomic int writer_done;
+
+static void* ads_rcumap_reader_thread(void* arg) {
+  (void) arg;
+
+  ads_rcumap_reader_t* reader = ads_rcumap_reader_register(&shared);
+  assert(reader);
+
+  while(!atomic_load(&writer_done)) {
+    ads_rcumap_read_lock(reader);
+    for(size_t i = 0; i < ADS_RCUMAP_TEST_KEYS; i++) {
+      size_t* value = NULL;
+      // a value found stays valid until read_unlock, even if the writer replaced it meanwhile
+      if(ads_rcumap_get(&shared, ads_map_uint64_key(i), (void**) &value) == ADS_SUCCESS)
+        assert(*value % ADS_RCUMAP_TEST_KEYS == i);
+    }
+    ads_rcumap_read_unlock(reader);
+  }
+
+  ads_rcumap_reader_unregister(reader);
+  return NULL;
+}
+
+static inline void ads_rcumap_readers_writer_TEST(void) {
+  assert(!ads_rcumap_init(&shared, 1, ADS_RCUMAP_TEST_READERS, free, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  atomic_init(&writer_done, 0);
+
+  pthread_t readers[ADS_RCUMAP_TEST_READERS];
+  for(int i = 0; i < ADS_RCUMAP_TEST_READERS; i++)
+    assert(pthread_create(&readers[i], NULL, ads_rcumap_reader_thread, NULL) == 0);
+
+  // every round inserts (or updates) all the keys, then removes half of them
+  for(size_t round = 0; round < ADS_RCUMAP_TEST_ROUNDS; round++) {
+    for(size_t i = 0; i < ADS_RCUMAP_TEST_KEYS; i++) {
+      size_t* value = malloc(sizeof(size_t));
+      *value = round * ADS_RCUMAP_TEST_KEYS + i;
+      assert(!ads_rcumap_insert(&shared, ads_map_uint64_key(i), value));
+    }
+    for(size_t i = round % 2; i < ADS_RCUMAP_TEST_KEYS; i += 2)
+      assert(!ads_rcumap_remove(&shared, ads_map_uint64_key(i), NULL));
+  }
+
+  atomic_store(&writer_done, 1);
+  for(int i = 0; i < ADS_RCUMAP_TEST_READERS; i++)
+    pthread_join(readers[i], NULL);
+
+  assert(ads_rcumap_get_size(&shared) == ADS_RCUMAP_TEST_KEYS / 2);
+  ads_rcumap_destroy(&shared);
+}
+
+static size_t allocated = 0;
+
+static void* counting_alloc(void* ctx, size_t size, size_t alignment) {
+  (void) ctx;
+  allocated += size;
+  if(alignment <= sizeof(void*))
+    return malloc(size);
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void counting_free(void* ctx, void* ptr, size_t size) {
+  (void) ctx;
+  allocated -= size;
+  free(ptr);
+}
+
+#define ads_is_aligned(ptr, alignment) ((uintptr_t) (ptr) % (alignment) == 0)
+
+static inline void ads_rcumap_allocator_TEST(void) {
+  ads_allocator_t allocator = { counting_alloc, NULL, counting_free, NULL };
+
+  ads_rcumap_t map;
+  assert(!ads_rcumap_init_allocator(&map, 1, 2, &allocator, NULL, ADS_MAP_COMPARE_UINT64, ADS_MAP_HASH_UINT64));
+  assert(ads_is_aligned(map.readers, ADS_RCUMAP_CACHE_LINE));
+
+  // growing retires whole tables, updates and removes retire nodes
+  for(size_t i = 0; i < 1000; i++)
+    assert(!ads_rcumap_insert(&map, ads_map_uint64_key(i), NULL));
+  for(size_t i = 0; i < 1000; i += 2)
+    assert(!ads_rcumap_insert(&map, ads_map_uint64_key(i), ads_map_uint64_key(1)));
+  for(size_t i = 0; i < 1000; i += 3)
+    assert(!ads_rcumap_remove(&map, ads_map_uint64_key(i), NULL));
+
+  ads_rcumap_destroy(&map);
+  assert(allocated == 0);
+}
+
+int main() {
+
+  ads_rcumap_init_TEST();
+  ads_rcumap_insert_get_TEST();
+  ads_rcumap_remove_out_TEST();
+  ads_rcumap_readers_writer_TEST();
+  ads_rcumap_allocator_TEST();
+
+  puts("RCUMAP TEST: OK");
+
+  return 0;
+}
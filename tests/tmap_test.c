@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/tmap.h"
+
+ADS_MAP_DEFINE(test_idmap, uint64_t, uint64_t, ADS_TMAP_HASH_UINT64, ADS_TMAP_EQ)
+ADS_MAP_DEFINE(test_strmap, const char*, int, ADS_TMAP_HASH_STRING, ADS_TMAP_EQ_STRING)
+
+// slot where the probe for `key` starts
+#define test_idmap_home(map, key) (ads_tmap_mix(ADS_TMAP_HASH_UINT64((key))) & ((map)->capacity - 1))
+
+static inline void ads_tmap_insert_get_TEST(void) {
+  test_idmap_t map;
+  assert(!test_idmap_init(&map, 0));
+  assert(ads_tmap_get_capacity(&map) == ADS_TMAP_MIN_CAPACITY);
+
+  for(uint64_t i = 0; i < 10000; i++)
+    assert(!test_idmap_insert(&map, i, i * 2));
+  assert(ads_tmap_get_size(&map) == 10000);
+  assert(ads_tmap_get_size(&map) <= ads_tmap_max_load(ads_tmap_get_capacity(&map)));
+
+  for(uint64_t i = 0; i < 10000; i++) {
+    uint64_t* value = test_idmap_get(&map, i);
+    assert(value && *value == i * 2);
+  }
+  assert(test_idmap_get(&map, 10000) == NULL);
+
+  // replace
+  assert(!test_idmap_insert(&map, 5, 50));
+  assert(*test_idmap_get(&map, 5) == 50);
+  assert(ads_tmap_get_size(&map) == 10000);
+
+  uint64_t out = 0;
+  for(uint64_t i = 0; i < 10000; i += 2) {
+    assert(!test_idmap_remove(&map, i, &out));
+    assert(out == i * 2);
+  }
+  assert(test_idmap_remove(&map, 0, NULL) == ADS_NOTFOUND);
+  assert(ads_tmap_get_size(&map) == 5000);
+
+  for(uint64_t i = 0; i < 10000; i++)
+    assert((test_idmap_get(&map, i) != NULL) == (i % 2 == 1));
+
+  test_idmap_destroy(&map);
+}
+
+static inline void ads_tmap_tombstone_TEST(void) {
+  test_idmap_t map;
+  assert(!test_idmap_init(&map, 0));
+  size_t mask = ads_tmap_get_capacity(&map) - 1;
+
+  // two keys starting at the same slot, so the second one lands right after the first
+  uint64_t first = 1, second = 2;
+  while(test_idmap_home(&map, second) != test_idmap_home(&map, first))
+    second++;
+  size_t home = test_idmap_home(&map, first);
+
+  assert(!test_idmap_insert(&map, first, 1));
+  assert(!test_idmap_insert(&map, second, 2));
+  assert(map.ctrl[home] & 0x80 && map.ctrl[(home + 1) & mask] & 0x80);
+  assert(map.used == 2);
+
+  // the slot after `second` is empty: no probe can go through it, so no tombstone is left
+  assert(!test_idmap_remove(&map, second, NULL));
+  assert(map.ctrl[(home + 1) & mask] == ADS_TMAP_EMPTY);
+  assert(map.used == 1);
+
+  // a probe for `second` must go through the slot of `first`, which becomes a tombstone
+  assert(!test_idmap_insert(&map, second, 2));
+  assert(!test_idmap_remove(&map, first, NULL));
+  assert(map.ctrl[home] == ADS_TMAP_DELETED);
+  assert(map.used == 2);
+  assert(*test_idmap_get(&map, second) == 2);
+
+  // the tombstone is reused by the next key starting there
+  assert(!test_idmap_insert(&map, first, 3));
+  assert(map.ctrl[home] & 0x80 && map.used == 2);
+  assert(*test_idmap_get(&map, first) == 3);
+
+  test_idmap_destroy(&map);
+}
+
+static inline void ads_tmap_churn_TEST(void) {
+  test_idmap_t map;
+  assert(!test_idmap_init(&map, 0));
+
+  /* a sliding window of 3 keys: the tombstones fill the table, and since it's never more than
+     half full the rehash that clears them keeps the capacity */
+  size_t rehashes = 0;
+  for(uint64_t i = 0; i < 10000; i++) {
+    size_t used = map.used;
+    assert(!test_idmap_insert(&map, i, i));
+    if(i >= 3)
+      assert(!test_idmap_remove(&map, i - 3, NULL));
+
+    rehashes += map.used < used;
+    assert(ads_tmap_get_capacity(&map) == ADS_TMAP_MIN_CAPACITY);
+    assert(map.used <= ads_tmap_max_load(ADS_TMAP_MIN_CAPACITY));
+    assert(ads_tmap_get_size(&map) == (i < 3 ? i + 1 : 3));
+  }
+  assert(rehashes > 0);
+
+  for(uint64_t i = 0; i < 10000; i++)
+    assert((test_idmap_get(&map, i) != NULL) == (i >= 9997));
+
+  test_idmap_destroy(&map);
+}
+
+static inline void ads_tmap_reserve_next_TEST(void) {
+  test_idmap_t map;
+  assert(!test_idmap_init(&map, 100));
+  assert(ads_tmap_max_load(ads_tmap_get_capacity(&map)) >= 100);
+
+  assert(!test_idmap_reserve(&map, 1000));
+  size_t capacity = ads_tmap_get_capacity(&map);
+  assert(ads_tmap_max_load(capacity) >= 1000);
+
+  // the reserved room is there, no rehash until it's used up
+  for(uint64_t i = 0; i < 1000; i++)
+    assert(!test_idmap_insert(&map, i, i + 1));
+  assert(ads_tmap_get_capacity(&map) == capacity);
+
+  // reserving less than the capacity does nothing
+  assert(!test_idmap_reserve(&map, 10));
+  assert(ads_tmap_get_capacity(&map) == capacity);
+
+  for(uint64_t i = 0; i < 1000; i += 3)
+    assert(!test_idmap_remove(&map, i, NULL));
+
+  // every entry is visited once, tombstones and empty slots are skipped
+  static char visited[1000];
+  size_t count = 0;
+  test_idmap_slot_t* slot;
+  for(size_t i = 0; (slot = test_idmap_next(&map, &i)); i++) {
+    assert(slot->key < 1000 && slot->key % 3 != 0);
+    assert(slot->value == slot->key + 1);
+    assert(!visited[slot->key]);
+    visited[slot->key] = 1;
+    count++;
+  }
+  assert(count == ads_tmap_get_size(&map));
+
+  size_t index = ads_tmap_get_capacity(&map);
+  assert(test_idmap_next(&map, &index) == NULL);
+
+  test_idmap_destroy(&map);
+  assert(map.ctrl == NULL && ads_tmap_is_empty(&map));
+}
+
+static inline void ads_tmap_string_TEST(void) {
+  test_strmap_t map;
+  assert(!test_strmap_init(&map, 0));
+
+  // the keys are stored as pointers, they must outlive the map
+  static char keys[1000][16];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(keys[i], "key-%d", i);
+    assert(!test_strmap_insert(&map, keys[i], i));
+  }
+
+  // looked up by content, not by pointer
+  char key[16];
+  for(int i = 0; i < 1000; i++) {
+    sprintf(key, "key-%d", i);
+    int* value = test_strmap_get(&map, key);
+    assert(value && *value == i);
+  }
+  assert(test_strmap_get(&map, "key") == NULL);
+  assert(test_strmap_get(&map, "") == NULL);
+
+  int out = 0;
+  assert(!test_strmap_remove(&map, "key-10", &out) && out == 10);
+  assert(test_strmap_get(&map, "key-10") == NULL);
+
+  // the same hash as the maps of map.h, with the process-wide seed
+  assert(ADS_TMAP_HASH_STRING("key-1") == ads_hash_bytes("key-1", 5, ads_hash_get_seed()));
+
+  test_strmap_destroy(&map);
+}
+
+int main() {
+
+  ads_tmap_insert_get_TEST();
+  ads_tmap_tombstone_TEST();
+  ads_tmap_churn_TEST();
+  ads_tmap_reserve_next_TEST();
+  ads_tmap_string_TEST();
+
+  puts("TMAP TEST: OK");
+
+  return 0;
+}
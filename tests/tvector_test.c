@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/tvector.h"
+
+ADS_VECTOR_DEFINE(test_ivec, int)
+
+// strings owned by the vector: copied on the way in, freed on the way out
+#define test_svec_copy(dest, src) (*(dest) = strdup(*(src)))
+#define test_svec_free(elem)      (free(*(elem)))
+ADS_VECTOR_DEFINE_HOOKS(test_svec, char*, test_svec_copy, test_svec_free)
+
+static inline void ads_tvector_push_pop_TEST(void) {
+  test_ivec_t vec;
+  assert(!test_ivec_init(&vec, 0));
+  assert(vec.data == NULL && ads_tvector_get_capacity(&vec) == 0);
+
+  // 4 elements first, then the capacity doubles
+  size_t capacity = 0, growths = 0;
+  for(int i = 0; i < 1000; i++) {
+    assert(!test_ivec_push(&vec, i));
+    if(ads_tvector_get_capacity(&vec) != capacity) {
+      assert(ads_tvector_get_capacity(&vec) == (capacity ? capacity * 2 : ADS_TVECTOR_PRE_ALLOCATE));
+      capacity = ads_tvector_get_capacity(&vec);
+      growths++;
+    }
+  }
+  assert(ads_tvector_get_size(&vec) == 1000 && capacity == 1024 && growths == 9);
+
+  for(int i = 0; i < 1000; i++)
+    assert(vec.data[i] == i && *test_ivec_at(&vec, i) == i);
+
+  for(int i = 999; i >= 500; i--) {
+    assert(vec.data[vec.size - 1] == i);
+    test_ivec_pop(&vec);
+  }
+  assert(ads_tvector_get_size(&vec) == 500);
+  assert(ads_tvector_get_capacity(&vec) == 1024); // popping doesn't shrink
+
+  test_ivec_clear(&vec);
+  assert(ads_tvector_is_empty(&vec));
+  test_ivec_pop(&vec); // nothing to pop
+  assert(ads_tvector_is_empty(&vec));
+
+  test_ivec_destroy(&vec);
+  assert(vec.data == NULL && ads_tvector_get_capacity(&vec) == 0);
+}
+
+static inline void ads_tvector_insert_erase_TEST(void) {
+  test_ivec_t vec;
+  assert(!test_ivec_init(&vec, 0));
+
+  // front, back and middle; the vector grows on the way
+  assert(!test_ivec_insert(&vec, 0, 1));
+  assert(!test_ivec_insert(&vec, 0, 0));
+  assert(!test_ivec_insert(&vec, 2, 4));
+  assert(!test_ivec_insert(&vec, 2, 2));
+  assert(!test_ivec_insert(&vec, 3, 3));
+  assert(ads_tvector_get_size(&vec) == 5 && ads_tvector_get_capacity(&vec) == 8);
+  for(int i = 0; i < 5; i++)
+    assert(vec.data[i] == i);
+
+  assert(test_ivec_insert(&vec, 6, 6) == ADS_OUTOFBOUNDS);
+  assert(ads_tvector_get_size(&vec) == 5);
+
+  assert(!test_ivec_erase(&vec, 2));
+  assert(!test_ivec_erase(&vec, 3));
+  assert(!test_ivec_erase(&vec, 0));
+  assert(ads_tvector_get_size(&vec) == 2 && vec.data[0] == 1 && vec.data[1] == 3);
+
+  assert(test_ivec_erase(&vec, 2) == ADS_OUTOFBOUNDS);
+  assert(!test_ivec_erase(&vec, 1) && !test_ivec_erase(&vec, 0));
+  assert(test_ivec_erase(&vec, 0) == ADS_OUTOFBOUNDS);
+  assert(ads_tvector_is_empty(&vec));
+
+  // the same as a model array, under many random positions
+  static int model[2000];
+  size_t size = 0;
+  srand(21);
+  for(int i = 0; i < 20000; i++) {
+    if(size == 0 || (size < 2000 && rand() % 3)) {
+      size_t index = (size_t) rand() % (size + 1);
+      memmove(&model[index + 1], &model[index], (size - index) * sizeof(int));
+      model[index] = i;
+      size++;
+      assert(!test_ivec_insert(&vec, index, i));
+    }
+    else {
+      size_t index = (size_t) rand() % size;
+      memmove(&model[index], &model[index + 1], (size - index - 1) * sizeof(int));
+      size--;
+      assert(!test_ivec_erase(&vec, index));
+    }
+  }
+  assert(ads_tvector_get_size(&vec) == size);
+  assert(memcmp(vec.data, model, size * sizeof(int)) == 0);
+
+  test_ivec_destroy(&vec);
+}
+
+static inline void ads_tvector_reserve_TEST(void) {
+  test_ivec_t vec;
+  assert(!test_ivec_init(&vec, 10));
+  assert(ads_tvector_get_capacity(&vec) == 10);
+
+  assert(!test_ivec_reserve(&vec, 100));
+  assert(ads_tvector_get_capacity(&vec) == 100);
+
+  // no reallocation until the reserved room is used up
+  int* data = vec.data;
+  for(int i = 0; i < 100; i++)
+    assert(!test_ivec_push(&vec, i));
+  assert(vec.data == data && ads_tvector_get_capacity(&vec) == 100);
+
+  // reserving less than the capacity does nothing
+  assert(!test_ivec_reserve(&vec, 50));
+  assert(ads_tvector_get_capacity(&vec) == 100);
+
+  assert(!test_ivec_push(&vec, 100));
+  assert(ads_tvector_get_capacity(&vec) == 200);
+
+  // append_n grows straight to the size needed when doubling isn't enough
+  static int values[1000];
+  for(int i = 0; i < 1000; i++)
+    values[i] = 101 + i;
+  assert(!test_ivec_append_n(&vec, values, 1000));
+  assert(ads_tvector_get_size(&vec) == 1101 && ads_tvector_get_capacity(&vec) == 1101);
+  for(int i = 0; i < 1101; i++)
+    assert(vec.data[i] == i);
+
+  for(int i = 0; i < 1001; i++)
+    test_ivec_pop(&vec);
+  assert(!test_ivec_shrink_to_fit(&vec));
+  assert(ads_tvector_get_capacity(&vec) == 100);
+  for(int i = 0; i < 100; i++)
+    assert(vec.data[i] == i);
+
+  test_ivec_clear(&vec);
+  assert(!test_ivec_shrink_to_fit(&vec));
+  assert(vec.data == NULL && ads_tvector_get_capacity(&vec) == 0);
+
+  test_ivec_destroy(&vec);
+}
+
+static inline void ads_tvector_hooks_TEST(void) {
+  test_svec_t vec;
+  assert(!test_svec_init(&vec, 0));
+
+  char buf[16];
+  for(int i = 0; i < 100; i++) {
+    sprintf(buf, "str-%d", i);
+    assert(!test_svec_push(&vec, buf));
+  }
+
+  // every element is its own copy
+  for(int i = 0; i < 100; i++) {
+    sprintf(buf, "str-%d", i);
+    assert(vec.data[i] != buf && strcmp(vec.data[i], buf) == 0);
+  }
+
+  // inserted elements are copied too, erased and popped ones are freed
+  assert(!test_svec_insert(&vec, 50, "middle"));
+  assert(strcmp(vec.data[50], "middle") == 0 && strcmp(vec.data[51], "str-50") == 0);
+  assert(!test_svec_erase(&vec, 0));
+  assert(strcmp(vec.data[0], "str-1") == 0);
+  test_svec_pop(&vec);
+  assert(ads_tvector_get_size(&vec) == 99 && strcmp(vec.data[98], "str-98") == 0);
+
+  char* values[] = { "a", "b", "c" };
+  assert(!test_svec_append_n(&vec, (char* const*) values, 3));
+  assert(vec.data[99] != values[0] && strcmp(vec.data[101], "c") == 0);
+
+  // the rest is freed here
+  test_svec_destroy(&vec);
+}
+
+int main() {
+
+  ads_tvector_push_pop_TEST();
+  ads_tvector_insert_erase_TEST();
+  ads_tvector_reserve_TEST();
+  ads_tvector_hooks_TEST();
+
+  puts("TVECTOR TEST: OK");
+
+  return 0;
+}
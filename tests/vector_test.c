@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "../include/vector.h"
+
+// the elements of `vec` must be first, first + 1, ..., first + size - 1
+static void
+ads_vector_check_sequence(ads_vector_t* vec, int first) {
+  for(size_t i = 0; i < vec->size; i++)
+    assert(ads_vector_get_as(vec, int*)[i] == first + (int) i);
+}
+
+static size_t destroyed = 0;
+
+static void ads_vector_count_destroy(void* data) {
+  (void) data;
+  destroyed++;
+}
+
+static inline void ads_vector_insert_TEST(void) {
+  ads_vector_t vec;
+  assert(!ads_vector_init(&vec, sizeof(int), NULL, NULL));
+
+  int values[] = { 0, 1, 3, 4 };
+  for(int i = 0; i < 4; i++)
+    assert(!ads_vector_push_back(&vec, &values[i]));
+
+  // in the middle, the size must grow along with the elements moved
+  int value = 2;
+  assert(!ads_vector_insert_at(&vec, 2, &value));
+  assert(vec.size == 5);
+  ads_vector_check_sequence(&vec, 0);
+
+  // at both ends
+  value = -1;
+  assert(!ads_vector_insert_at(&vec, 0, &value));
+  value = 5;
+  assert(!ads_vector_insert_at(&vec, vec.size, &value));
+  assert(vec.size == 7);
+  ads_vector_check_sequence(&vec, -1);
+
+  assert(ads_vector_insert_at(&vec, vec.size + 1, &value) == ADS_OUTOFBOUNDS);
+  assert(ads_vector_insert_at(&vec, -1, &value) == ADS_OUTOFBOUNDS);
+
+  int* out = NULL;
+  assert(!ads_vector_get_at(&vec, 6, (void**) &out) && *out == 5);
+  assert(ads_vector_get_at(&vec, 7, NULL) == ADS_OUTOFBOUNDS);
+
+  ads_vector_destroy(&vec);
+}
+
+static inline void ads_vector_pop_TEST(void) {
+  ads_vector_t vec;
+  assert(!ads_vector_init(&vec, sizeof(int), NULL, ads_vector_count_destroy));
+
+  for(int i = 0; i < 10; i++)
+    assert(!ads_vector_push_back(&vec, &i));
+
+  // the first element is destroyed once and the others move down
+  destroyed = 0;
+  ads_vector_pop_front(&vec);
+  assert(destroyed == 1);
+  assert(vec.size == 9);
+  ads_vector_check_sequence(&vec, 1);
+
+  ads_vector_pop_back(&vec);
+  assert(destroyed == 2);
+  assert(vec.size == 8);
+  ads_vector_check_sequence(&vec, 1);
+
+  // the slots left behind are zeroed
+  assert(ads_vector_get_as(&vec, int*)[8] == 0);
+  assert(ads_vector_get_as(&vec, int*)[9] == 0);
+
+  while(vec.size > 0)
+    ads_vector_pop_front(&vec);
+  assert(destroyed == 10);
+
+  // popping an empty vector does nothing
+  ads_vector_pop_front(&vec);
+  ads_vector_pop_back(&vec);
+  assert(destroyed == 10);
+
+  ads_vector_destroy(&vec);
+}
+
+static inline void ads_vector_capacity_TEST(void) {
+  ads_vector_t vec;
+  assert(!ads_vector_init_capacity(&vec, sizeof(int), 0, 1.5, NULL, NULL));
+  assert(vec.capacity == 0 && vec.buf == NULL);
+
+  for(int i = 0; i < 100; i++) {
+    size_t capacity = vec.capacity;
+    assert(!ads_vector_push_back(&vec, &i));
+
+    // the capacity only changes when full, by the growth factor (at least one more element)
+    if(capacity != vec.capacity) {
+      assert((size_t) i == capacity);
+      assert(vec.capacity == (capacity * 3 / 2 > capacity ? capacity * 3 / 2 : capacity + 1));
+    }
+  }
+
+  // reserve never decreases the capacity
+  size_t capacity = vec.capacity;
+  assert(!ads_vector_reserve(&vec, 10));
+  assert(vec.capacity == capacity);
+
+  assert(!ads_vector_reserve(&vec, 1000));
+  assert(vec.capacity == 1000);
+  ads_vector_check_sequence(&vec, 0);
+
+  // no reallocation up to the reserved capacity
+  void* buf = vec.buf;
+  for(int i = 100; i < 1000; i++)
+    assert(!ads_vector_push_back(&vec, &i));
+  assert(vec.buf == buf);
+
+  for(int i = 0; i < 500; i++)
+    ads_vector_pop_back(&vec);
+  assert(!ads_vector_shrink_to_fit(&vec));
+  assert(vec.capacity == 500);
+  ads_vector_check_sequence(&vec, 0);
+
+  // an empty vector releases its buffer
+  ads_vector_clear(&vec);
+  assert(!ads_vector_shrink_to_fit(&vec));
+  assert(vec.capacity == 0 && vec.buf == NULL);
+
+  int value = 7;
+  assert(!ads_vector_push_back(&vec, &value));
+  ads_vector_check_sequence(&vec, 7);
+
+  ads_vector_destroy(&vec);
+}
+
+static inline void ads_vector_range_TEST(void) {
+  int values[100];
+  for(int i = 0; i < 100; i++)
+    values[i] = i;
+
+  ads_vector_t vec;
+  assert(!ads_vector_init(&vec, sizeof(int), NULL, ads_vector_count_destroy));
+
+  // a single growth for the whole range
+  assert(!ads_vector_append_n(&vec, &values[0], 10));
+  assert(!ads_vector_append_n(&vec, &values[60], 40));
+  assert(vec.size == 50);
+
+  // fill the gap: 0..9 then 10..59 then 60..99
+  assert(!ads_vector_insert_range(&vec, 10, &values[10], 50));
+  assert(vec.size == 100);
+  ads_vector_check_sequence(&vec, 0);
+
+  assert(ads_vector_insert_range(&vec, 101, values, 1) == ADS_OUTOFBOUNDS);
+
+  // at the front and at the end
+  assert(!ads_vector_erase_range(&vec, 0, 10));
+  assert(!ads_vector_insert_range(&vec, 0, values, 10));
+  assert(!ads_vector_insert_range(&vec, vec.size, values, 0));
+  ads_vector_check_sequence(&vec, 0);
+
+  destroyed = 0;
+  assert(!ads_vector_erase_range(&vec, 20, 30));
+  assert(destroyed == 30);
+  assert(vec.size == 70);
+  for(size_t i = 0; i < vec.size; i++)
+    assert(ads_vector_get_as(&vec, int*)[i] == (int) (i < 20 ? i : i + 30));
+
+  // the slots left behind are zeroed
+  for(size_t i = vec.size; i < 100; i++)
+    assert(ads_vector_get_as(&vec, int*)[i] == 0);
+
+  assert(ads_vector_erase_range(&vec, 60, 11) == ADS_OUTOFBOUNDS);
+  assert(ads_vector_erase_range(&vec, 71, 0) == ADS_OUTOFBOUNDS);
+  assert(!ads_vector_erase_range(&vec, 70, 0));
+  assert(!ads_vector_erase_range(&vec, 0, vec.size));
+  assert(vec.size == 0 && destroyed == 100);
+
+  ads_vector_destroy(&vec);
+}
+
+static inline void ads_vector_inline_TEST(void) {
+  ADS_SMALL_VECTOR(int, 4) small;
+  assert(!ads_small_vector_init(&small, NULL, NULL));
+
+  ads_vector_t* vec = &small.vec;
+  assert(ads_vector_is_inline(vec));
+  assert(vec->capacity == 4);
+
+  // up to the inline capacity nothing moves
+  for(int i = 0; i < 4; i++)
+    assert(!ads_vector_push_back(vec, &i));
+  assert(ads_vector_is_inline(vec));
+  assert(vec->buf == small.storage);
+
+  // one more spills to the heap
+  int value = 4;
+  assert(!ads_vector_push_back(vec, &value));
+  assert(!ads_vector_is_inline(vec));
+  assert(vec->capacity > 4);
+  ads_vector_check_sequence(vec, 0);
+
+  for(int i = 5; i < 100; i++)
+    assert(!ads_vector_push_back(vec, &i));
+  ads_vector_check_sequence(vec, 0);
+
+  // a copy always lives on the heap
+  ads_vector_t copy;
+  assert(!ads_vector_copy(&copy, vec));
+  assert(copy.inline_buf == NULL);
+  ads_vector_check_sequence(&copy, 0);
+  ads_vector_destroy(&copy);
+
+  // shrinking to fit in the storage moves the elements back
+  while(vec->size > 3)
+    ads_vector_pop_back(vec);
+  assert(!ads_vector_shrink_to_fit(vec));
+  assert(ads_vector_is_inline(vec));
+  assert(vec->capacity == 4);
+  ads_vector_check_sequence(vec, 0);
+
+  // reserving past the storage spills again, the range ops keep working across it
+  assert(!ads_vector_reserve(vec, 16));
+  assert(!ads_vector_is_inline(vec));
+  ads_vector_check_sequence(vec, 0);
+
+  assert(!ads_vector_erase_range(vec, 0, 3));
+  assert(!ads_vector_shrink_to_fit(vec));
+  assert(ads_vector_is_inline(vec));
+
+  int values[] = { 10, 11, 12, 13, 14, 15 };
+  assert(!ads_vector_append_n(vec, values, 2));
+  assert(ads_vector_is_inline(vec));
+  assert(!ads_vector_insert_range(vec, 2, &values[2], 4));
+  assert(!ads_vector_is_inline(vec));
+  ads_vector_check_sequence(vec, 10);
+
+  ads_vector_destroy(vec);
+}
+
+static inline void ads_vector_mapped_TEST(void) {
+  ads_vector_t vec;
+  assert(!ads_vector_init(&vec, sizeof(size_t), NULL, NULL));
+
+  // growing past the threshold moves the buffer to its own mapping
+  size_t count = 2 * ADS_VECTOR_MMAP_THRESHOLD / sizeof(size_t);
+  for(size_t i = 0; i < count; i++)
+    assert(!ads_vector_push_back(&vec, &i));
+  assert(vec.mapped);
+
+  for(size_t i = 0; i < count; i++)
+    assert(ads_vector_get_as(&vec, size_t*)[i] == i);
+
+  // and back to the heap once it's shrunk below it
+  while(vec.size > 100)
+    ads_vector_pop_back(&vec);
+  assert(!ads_vector_shrink_to_fit(&vec));
+  assert(!vec.mapped);
+  assert(vec.capacity == 100);
+  for(size_t i = 0; i < 100; i++)
+    assert(ads_vector_get_as(&vec, size_t*)[i] == i);
+
+  ads_vector_destroy(&vec);
+}
+
+#define ads_vector_is_aligned(vec, alignment) ((size_t) (vec)->buf % (alignment) == 0)
+
+static inline void ads_vector_aligned_TEST(void) {
+  ads_vector_t vec;
+
+  // not a power of two, or beyond what a mapping can give
+  assert(ads_vector_init_aligned(&vec, sizeof(int), 4, 48, 0, NULL, NULL) == ADS_INVALID);
+  assert(ads_vector_init_aligned(&vec, sizeof(int), 4, 0, 0, NULL, NULL) == ADS_INVALID);
+  assert(ads_vector_init_aligned(&vec, sizeof(int), 4, 1 << 20, 0, NULL, NULL) == ADS_INVALID);
+
+  assert(!ads_vector_init_aligned(&vec, sizeof(int), 3, 64, 0, NULL, NULL));
+  assert(ads_vector_is_aligned(&vec, 64));
+
+  // every buffer keeps the alignment: grown, reserved, shrunk and after the range ops
+  for(int i = 0; i < 1000; i++) {
+    assert(!ads_vector_push_back(&vec, &i));
+    assert(ads_vector_is_aligned(&vec, 64));
+  }
+  ads_vector_check_sequence(&vec, 0);
+
+  assert(!ads_vector_reserve(&vec, 5000));
+  assert(ads_vector_is_aligned(&vec, 64));
+
+  assert(!ads_vector_erase_range(&vec, 0, 10));
+  assert(!ads_vector_shrink_to_fit(&vec));
+  assert(vec.capacity == 990);
+  assert(ads_vector_is_aligned(&vec, 64));
+  ads_vector_check_sequence(&vec, 10);
+
+  int values[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  assert(!ads_vector_insert_range(&vec, 0, values, 10));
+  assert(ads_vector_is_aligned(&vec, 64));
+  ads_vector_check_sequence(&vec, 0);
+
+  // a copy is aligned as well
+  ads_vector_t copy;
+  assert(!ads_vector_copy(&copy, &vec));
+  assert(ads_vector_is_aligned(&copy, 64));
+  ads_vector_check_sequence(&copy, 0);
+  ads_vector_destroy(&copy);
+
+  ads_vector_destroy(&vec);
+
+  // an alignment below the size of a pointer still works
+  assert(!ads_vector_init_aligned(&vec, 1, 0, 2, 0, NULL, NULL));
+  for(int i = 0; i < 100; i++)
+    assert(!ads_vector_push_back(&vec, &i));
+  assert(ads_vector_is_aligned(&vec, 2));
+  ads_vector_destroy(&vec);
+}
+
+static inline void ads_vector_aligned_mapped_TEST(void) {
+  ads_vector_t vec;
+  assert(!ads_vector_init_aligned(&vec, sizeof(size_t), 0, 64, ADS_VECTOR_HUGEPAGE, NULL, NULL));
+
+  // heap -> mapped -> heap, the alignment holds on both sides
+  size_t count = 2 * ADS_VECTOR_HUGEPAGE_THRESHOLD / sizeof(size_t);
+  for(size_t i = 0; i < count; i++)
+    assert(!ads_vector_push_back(&vec, &i));
+  assert(vec.mapped);
+  assert(ads_vector_is_aligned(&vec, 64));
+
+  while(vec.size > 100)
+    ads_vector_pop_back(&vec);
+  assert(!ads_vector_shrink_to_fit(&vec));
+  assert(!vec.mapped);
+  assert(ads_vector_is_aligned(&vec, 64));
+  for(size_t i = 0; i < 100; i++)
+    assert(ads_vector_get_as(&vec, size_t*)[i] == i);
+
+  ads_vector_destroy(&vec);
+}
+
+int main() {
+
+  ads_vector_insert_TEST();
+  ads_vector_pop_TEST();
+  ads_vector_capacity_TEST();
+  ads_vector_range_TEST();
+  ads_vector_inline_TEST();
+  ads_vector_mapped_TEST();
+  ads_vector_aligned_TEST();
+  ads_vector_aligned_mapped_TEST();
+
+  puts("VECTOR TEST: OK");
+
+  return 0;
+}